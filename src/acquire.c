@@ -0,0 +1,332 @@
+#include "acquire.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool ReplayOpen(Replay* replay, const char* path, uint64_t iterations) {
+    if (!CaptureReaderOpen(&replay->reader, path)) return false;
+    replay->first_record = replay->reader.offset;
+    
+    // The parser takes one geometry, so the first frame sets it
+    RawFrame frame;
+    CaptureFrameInfo info;
+    if (!CaptureReaderNext(&replay->reader, &frame, &info) ||
+        !CaptureReaderSeek(&replay->reader, replay->first_record)) {
+        CaptureReaderClose(&replay->reader);
+        return false;
+    }
+    replay->geometry = (FrameGeometry){frame.samples, 3, frame.bits, frame.origin};
+    replay->iterations = iterations;
+    replay->active = true;
+    return true;
+}
+
+void ReplayClose(Replay* replay) {
+    CaptureReaderClose(&replay->reader);
+    replay->active = false;
+}
+
+static bool AcquireData(SerialPort* port, FrameParser* parser, char cmd, RawFrame* frame) {
+    if (!port->is_open) return false;
+    
+    uint8_t chunk[FRAME_MAX_WIRE_BYTES];
+    int chunk_max = (int)parser->frame_bytes;
+    
+    // Anything already waiting is the late tail of a reply that timed out
+    int stale = SerialBytesAvailable(port);
+    while (stale > 0) {
+        int n = SerialRead(port, chunk, stale < chunk_max ? stale : chunk_max);
+        if (n <= 0) break;
+        parser->stats.bytes_discarded += n;
+        stale -= n;
+    }
+    
+    // Nor do bytes the parser holds past the last good frame; left there the
+    // reply would land behind them and cost a resync
+    FrameParserDiscard(parser);
+    
+    double start = SerialGetTimeMs();
+    SerialWrite(port, &cmd, 1);
+    
+    bool received = false;
+    
+    while (!received) {
+        if (SerialGetTimeMs() - start > ACQUIRE_TIMEOUT_MS) break;
+        
+        // Only what completes the frame, unless more is already waiting. A
+        // low latency read then returns on the final byte instead of sitting
+        // out the inter-byte timer for a VMIN it will never reach.
+        size_t want = parser->length < parser->frame_bytes ? parser->frame_bytes - parser->length : 1;
+        int available = SerialBytesAvailable(port);
+        if (available > 0 && (size_t)available > want) want = (size_t)available;
+        if (want > parser->frame_bytes) want = parser->frame_bytes;
+        if (want > FrameParserSpace(parser)) want = FrameParserSpace(parser);
+        
+        int n = SerialRead(port, chunk, want);
+        if (n > 0) {
+            FrameParserPush(parser, chunk, n);
+            received = FrameParserNext(parser, frame);
+        }
+    }
+    
+    if (!received) {
+        FrameParserDiscard(parser);
+        return false;
+    }
+    return true;
+}
+
+// AcquireData with the capture in place of the port: from the parser on the
+// frame takes the same framing, validation and decode as one off the wire
+static bool AcquireReplay(Replay* replay, FrameParser* parser, RawFrame* frame, bool* weak) {
+    CaptureFrameInfo info;
+    if (!CaptureReaderNext(&replay->reader, frame, &info)) {
+        if (!CaptureReaderSeek(&replay->reader, replay->first_record) ||
+            !CaptureReaderNext(&replay->reader, frame, &info)) {
+            return false;
+        }
+    }
+    
+    if (frame->samples != replay->geometry.samples || frame->bits != replay->geometry.bits ||
+        frame->origin != replay->geometry.origin) {
+        return false;
+    }
+    
+    uint8_t wire[FRAME_MAX_VALUES * 2];
+    int values = frame->samples * 3;
+    for (int i = 0; i < values; i++) {
+        wire[2 * i] = (uint8_t)frame->values[i];
+        wire[2 * i + 1] = (uint8_t)(frame->values[i] >> 8);
+    }
+    
+    FrameParserPush(parser, wire, (size_t)values * 2);
+    if (!FrameParserNext(parser, frame)) {
+        FrameParserDiscard(parser);
+        return false;
+    }
+    *weak = info.excitation == 1;
+    return true;
+}
+
+// Never waits on the UI: when it is a full queue behind, its oldest frame makes room
+static void AcquirerQueue(Acquirer* acq, bool weak, float rtt_ms) {
+    uint64_t tail = acq->tail;
+    uint64_t head = AtomicLoad64(&acq->head);
+    
+    const RawFrame* frame = &acq->published.frame;
+    if (offsetof(AcquiredFrame, frame) + RawFrameBytes(frame->samples) > acq->frame_bytes) {
+        AtomicFetchAdd64(&acq->dropped, 1);
+        return;
+    }
+    
+    if (tail - head >= ACQUIRE_QUEUE) {
+        // Races with the UI taking the same slot; either way one frame leaves
+        if (AtomicCompareExchange64(&acq->head, &head, head + 1)) {
+            AtomicFetchAdd64(&acq->dropped, 1);
+        }
+    }
+    
+    AcquiredFrame* slot = (AcquiredFrame*)(acq->slots + (tail % ACQUIRE_QUEUE) * acq->slot_size);
+    slot->sequence = acq->published.sequence;
+    slot->weak = weak;
+    slot->rtt_ms = rtt_ms;
+    slot->timestamp_us = acq->published.timestamp_us;
+    memcpy(&slot->frame, frame, RawFrameBytes(frame->samples));
+    AtomicStore64(&acq->tail, tail + 1);
+}
+
+// The sinks get every frame straight from here, whatever the UI is doing
+static void AcquirerPublish(Acquirer* acq, bool weak, uint64_t timestamp_us) {
+    PipelineFrame* published = &acq->published;
+    published->sequence = ++acq->sequence;
+    published->timestamp_us = timestamp_us;
+    published->excitation = weak ? 1 : 0;
+    
+    if (!acq->pipeline || acq->pipeline->sink_count == 0) return;
+    FrameSplit(&published->frame, &acq->samples);
+    MetricsComputeFrame(&acq->samples, acq->calib, weak, acq->voltage, acq->current, published->metrics);
+    PipelinePublish(acq->pipeline, published);
+}
+
+static void AcquirerRun(void* arg) {
+    Acquirer* acq = arg;
+    
+    // Acts on this thread only; it starts no threads that could inherit it
+    if (acq->realtime) {
+        RealtimeEnter(&acq->status, acq->realtime_cpu, acq->realtime_priority);
+    } else {
+        RealtimeQuery(&acq->status);
+    }
+    
+    MutexLock(&acq->lock);
+    acq->started = true;
+    CondBroadcast(&acq->changed);
+    
+    double next = 0;            // Earliest time for the next command
+    bool last_ok = false;
+    
+    for (;;) {
+        while (acq->running && !acq->active) {
+            RealtimeJitterBreak(&acq->jitter);
+            CondWait(&acq->wake, &acq->lock);
+        }
+        if (!acq->running) break;
+        
+        // Flat out only while frames keep coming; a closed port still waits its turn
+        double now = SerialGetTimeMs();
+        if ((!acq->continuous || !last_ok) && now < next) {
+            CondWaitMs(&acq->wake, &acq->lock, (int)(next - now) + 1);
+            continue;
+        }
+        
+        bool weak = acq->mode == 1 || (acq->mode == 2 && acq->alt_use_weak);
+        if (acq->mode == 2) acq->alt_use_weak = !acq->alt_use_weak;
+        acq->busy = true;
+        MutexUnlock(&acq->lock);
+        
+#ifdef CURVEBUG_ALLOC_CHECK
+        if (acq->alloc_attempts++ == ACQUIRE_ALLOC_WARMUP) AllocCheckBegin();
+#endif
+        RawFrame* frame = &acq->published.frame;
+        double start = SerialGetTimeMs();
+        bool ok;
+        if (acq->replay && acq->replay->active) {
+            ok = AcquireReplay(acq->replay, acq->parser, frame, &weak);
+        } else {
+            ok = AcquireData(acq->port, acq->parser, weak ? 'W' : 'T', frame);
+        }
+        double end = SerialGetTimeMs();
+        
+        if (ok) {
+            uint64_t timestamp_us = (uint64_t)(end * 1000.0);
+            AcquirerPublish(acq, weak, timestamp_us);
+            AcquirerQueue(acq, weak, (float)(end - start));
+            RealtimeJitterAdd(&acq->jitter, timestamp_us);
+        } else if (acq->port->is_open || (acq->replay && acq->replay->active)) {
+            RealtimeJitterMiss(&acq->jitter);
+        }
+        
+        // Fixed rate from command to command, not from the end of a reply
+        next = start + ACQUIRE_INTERVAL_MS;
+        if (next < end) next = end;
+        last_ok = ok;
+        
+        MutexLock(&acq->lock);
+        acq->stats = acq->parser->stats;
+        acq->busy = false;
+        CondBroadcast(&acq->changed);
+    }
+    
+    acq->busy = false;
+    CondBroadcast(&acq->changed);
+    MutexUnlock(&acq->lock);
+    
+#ifdef CURVEBUG_ALLOC_CHECK
+    AllocCheckEnd(&acq->allocs);
+#endif
+}
+
+bool AcquirerStart(Acquirer* acq, SerialPort* port, FrameParser* parser, Replay* replay,
+                   Pipeline* pipeline, const CalibrationTable* calib,
+                   bool realtime, int cpu, int priority) {
+    memset(acq, 0, sizeof(*acq));
+    acq->port = port;
+    acq->parser = parser;
+    acq->replay = replay;
+    acq->pipeline = pipeline;
+    acq->calib = calib;
+    acq->stats = parser->stats;
+    acq->realtime = realtime;
+    acq->realtime_cpu = cpu;
+    acq->realtime_priority = priority;
+    
+    acq->frame_bytes = offsetof(AcquiredFrame, frame) + RawFrameBytes(parser->geometry.samples);
+    acq->slot_size = RawFrameSlotBytes(offsetof(AcquiredFrame, frame), parser->geometry.samples);
+    acq->slots = malloc(acq->slot_size * ACQUIRE_QUEUE);
+    if (!acq->slots) {
+        RealtimeQuery(&acq->status);
+        return false;
+    }
+    
+    acq->running = true;
+    RealtimeJitterInit(&acq->jitter);
+    MutexInit(&acq->lock);
+    CondInit(&acq->wake);
+    CondInit(&acq->changed);
+    
+    if (!ThreadCreate(&acq->thread, AcquirerRun, acq)) {
+        acq->running = false;
+        CondDestroy(&acq->changed);
+        CondDestroy(&acq->wake);
+        MutexDestroy(&acq->lock);
+        free(acq->slots);
+        acq->slots = NULL;
+        RealtimeQuery(&acq->status);
+        return false;
+    }
+    
+    MutexLock(&acq->lock);
+    while (!acq->started) CondWait(&acq->changed, &acq->lock);
+    MutexUnlock(&acq->lock);
+    return true;
+}
+
+void AcquirerSet(Acquirer* acq, bool active, int mode, bool continuous) {
+    if (!acq->running) return;
+    
+    MutexLock(&acq->lock);
+    bool wake = active != acq->active || continuous != acq->continuous;
+    acq->active = active;
+    acq->mode = mode;
+    acq->continuous = continuous;
+    if (wake) CondSignal(&acq->wake);
+    MutexUnlock(&acq->lock);
+}
+
+void AcquirerPause(Acquirer* acq) {
+    if (!acq->running) return;
+    
+    MutexLock(&acq->lock);
+    acq->active = false;
+    while (acq->busy) CondWait(&acq->changed, &acq->lock);
+    MutexUnlock(&acq->lock);
+}
+
+bool AcquirerNext(Acquirer* acq, AcquiredFrame* frame) {
+    uint64_t head = AtomicLoad64(&acq->head);
+    for (;;) {
+        if (head == AtomicLoad64(&acq->tail)) return false;
+        
+        memcpy(frame, acq->slots + (head % ACQUIRE_QUEUE) * acq->slot_size, acq->frame_bytes);
+        
+        // Fails only if the acquisition thread dropped this slot meanwhile; the copy may be torn
+        if (AtomicCompareExchange64(&acq->head, &head, head + 1)) return true;
+    }
+}
+
+void AcquirerGetStats(Acquirer* acq, FrameParserStats* stats) {
+    if (!acq->running) {
+        *stats = acq->parser->stats;
+        return;
+    }
+    MutexLock(&acq->lock);
+    *stats = acq->stats;
+    MutexUnlock(&acq->lock);
+}
+
+void AcquirerStop(Acquirer* acq) {
+    if (!acq->running) return;
+    
+    MutexLock(&acq->lock);
+    acq->running = false;
+    CondSignal(&acq->wake);
+    MutexUnlock(&acq->lock);
+    
+    ThreadJoin(&acq->thread);
+    CondDestroy(&acq->changed);
+    CondDestroy(&acq->wake);
+    MutexDestroy(&acq->lock);
+    
+    free(acq->slots);
+    acq->slots = NULL;
+    acq->head = acq->tail;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "serial.h"
+#include "capture.h"
+#include "calib.h"
+#include "pipeline.h"
+#include "realtime.h"
+#include "sync.h"
+#ifdef CURVEBUG_ALLOC_CHECK
+    #include "alloccheck.h"
+#endif
+
+// Acquisition on its own thread: the excitation command, serial reads,
+// framing and decode, paced at a fixed interval. With realtime on, this is
+// the only thread pinned and raised, so the window and GL loop, the sinks and
+// the audio thread keep the normal class. Every decoded frame is published to
+// the pipeline's sinks from this thread, then queued for the UI thread on a
+// single producer, single consumer ring it drains every loop. A UI that falls
+// behind loses its oldest queued frames; it never holds up acquisition or the sinks.
+#define ACQUIRE_QUEUE 16                // Power of two
+#define ACQUIRE_INTERVAL_MS 50.0        // Between commands unless running flat out
+#define ACQUIRE_TIMEOUT_MS 1000.0
+#define ACQUIRE_ALLOC_WARMUP 100        // Attempts before an allocation on this thread counts
+
+// The frame comes last: a queue slot holds only the samples of its geometry
+typedef struct {
+    uint64_t sequence;          // Counts every decoded frame, including ones the UI skipped
+    bool weak;
+    float rtt_ms;               // Command to last byte
+    uint64_t timestamp_us;      // When the last byte arrived
+    RawFrame frame;
+} AcquiredFrame;
+
+// Stands in for the device: recorded frames go back out as wire bytes and
+// through the parser, looping at the end of the file. Lets soak runs like
+// the allocation check go without hardware.
+typedef struct {
+    bool active;
+    CaptureReader reader;
+    uint64_t first_record;      // Offset to rewind to
+    FrameGeometry geometry;     // Of the first frame; others are skipped
+    uint64_t iterations;        // UI loop iterations before exiting, 0 = until closed
+} Replay;
+
+typedef struct {
+    SerialPort* port;
+    FrameParser* parser;
+    Replay* replay;             // Used instead of the port while active
+    Pipeline* pipeline;         // Sinks fed from the acquisition thread, NULL = none
+    const CalibrationTable* calib;  // Units of the published metrics, NULL = raw counts
+    
+    // Under DROP_OLDEST rules: when full the acquisition thread advances head
+    // itself, so the UI copies a slot out and keeps it only if its CAS on head wins.
+    // Slots are sized for the parser's geometry when the thread starts.
+    uint8_t* slots;             // ACQUIRE_QUEUE slots of slot_size bytes
+    size_t slot_size;
+    size_t frame_bytes;         // Used bytes of an AcquiredFrame at the geometry
+    volatile uint64_t head;     // Frames taken by the UI thread
+    volatile uint64_t tail;     // Frames queued by the acquisition thread
+    volatile uint64_t dropped;  // Frames overwritten before the UI took them, or too large for a slot
+    
+    // Everything below is under lock
+    Mutex lock;
+    Cond wake;                  // To the acquisition thread: settings changed
+    Cond changed;               // From it: started, or went idle
+    bool active;                // Acquire at all (not paused, in settings or reviewing)
+    int mode;                   // 0=4.7K, 1=100K, 2=ALT
+    bool continuous;            // Every frame the device gives, no pacing
+    bool busy;                  // Between the command and the last byte
+    bool started;
+    bool running;
+    FrameParserStats stats;     // Copied out after every attempt
+    
+    // Set before start, applied by the thread to itself
+    bool realtime;
+    int realtime_cpu;
+    int realtime_priority;
+    RealtimeStatus status;
+    
+    // Acquisition thread only until AcquirerStop returns
+    RealtimeJitter jitter;
+    bool alt_use_weak;
+    uint64_t sequence;
+    PipelineFrame published;    // Decoded into, then copied to the sinks and the UI
+    FrameSamples samples;
+    float voltage[FRAME_MAX_SAMPLES];
+    float current[FRAME_MAX_SAMPLES];
+#ifdef CURVEBUG_ALLOC_CHECK
+    uint64_t alloc_attempts;
+    AllocCounts allocs;         // After ACQUIRE_ALLOC_WARMUP attempts
+#endif
+    
+    Thread thread;
+} Acquirer;
+
+bool ReplayOpen(Replay* replay, const char* path, uint64_t iterations);
+void ReplayClose(Replay* replay);
+
+// Starts idle. Returns once the thread runs and has applied the realtime
+// settings, so status can be reported straight away. The pipeline's sinks must
+// all be added first and the parser's geometry set; calib is read by the
+// thread, so change it only while paused.
+bool AcquirerStart(Acquirer* acq, SerialPort* port, FrameParser* parser, Replay* replay,
+                   Pipeline* pipeline, const CalibrationTable* calib,
+                   bool realtime, int cpu, int priority);
+
+// Called by the UI thread every loop; cheap when nothing changed
+void AcquirerSet(Acquirer* acq, bool active, int mode, bool continuous);
+
+// Stops acquiring and waits out an acquisition in flight, so the port and
+// parser can be touched until the next AcquirerSet turns it back on
+void AcquirerPause(Acquirer* acq);
+
+// Oldest frame still queued, false if there is none
+bool AcquirerNext(Acquirer* acq, AcquiredFrame* frame);
+
+void AcquirerGetStats(Acquirer* acq, FrameParserStats* stats);
+
+// Joins the thread and drops anything still queued; jitter and the allocation
+// counts are final afterwards
+void AcquirerStop(Acquirer* acq);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "alloccheck.h"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__)
+
+// glibc exports its allocator under these names as well, so the wrappers can
+// forward to it without dlsym, which itself allocates
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+// Thread locals in the executable live in the static TLS block, so touching
+// them from inside malloc cannot recurse into malloc
+static __thread bool counting;
+static __thread AllocCounts counts;
+
+void* malloc(size_t size) {
+    if (counting) {
+        counts.allocs++;
+        counts.bytes += size;
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (counting) {
+        counts.allocs++;
+        counts.bytes += count * size;
+    }
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (counting) {
+        counts.allocs++;
+        counts.bytes += size;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    if (counting && ptr) counts.frees++;
+    __libc_free(ptr);
+}
+
+bool AllocCheckAvailable(void) {
+    return true;
+}
+
+void AllocCheckBegin(void) {
+    memset(&counts, 0, sizeof(counts));
+    counting = true;
+}
+
+void AllocCheckEnd(AllocCounts* out) {
+    counting = false;
+    *out = counts;
+}
+
+#else
+
+bool AllocCheckAvailable(void) {
+    return false;
+}
+
+void AllocCheckBegin(void) {
+}
+
+void AllocCheckEnd(AllocCounts* out) {
+    memset(out, 0, sizeof(*out));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef ALLOCCHECK_H
+#define ALLOCCHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Heap allocation counter for the CURVEBUG_ALLOC_CHECK build. malloc, calloc,
+// realloc and free are interposed and counted per thread, and only while that
+// thread has counting switched on, so the frame loop can be checked without
+// the sink threads, the audio thread or startup getting in the way.
+// Only glibc can be interposed this way; elsewhere nothing is ever counted.
+typedef struct {
+    uint64_t allocs;            // malloc, calloc and realloc calls
+    uint64_t frees;
+    uint64_t bytes;             // Requested, not what the allocator rounded up to
+} AllocCounts;
+
+bool AllocCheckAvailable(void);
+
+// Starts counting on the calling thread from zero
+void AllocCheckBegin(void);
+
+// Stops counting on the calling thread and returns what it did since AllocCheckBegin
+void AllocCheckEnd(AllocCounts* counts);
+
+#endif
\ No newline at end of file
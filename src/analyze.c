@@ -0,0 +1,452 @@
+#include "analyze.h"
+#include "codec.h"
+#include "metrics.h"
+#include "trigger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+const char* ANALYZE_STAT_NAMES[ANALYZE_STATS] = {
+    "r_small", "v_knee", "i_leak", "noise", "loop_area", "deviation"
+};
+
+void AnalyzerInit(Analyzer* analyzer, int max_outliers) {
+    memset(analyzer, 0, sizeof(*analyzer));
+    analyzer->max_outliers = max_outliers > 0 ? max_outliers : 0;
+}
+
+static bool AnalyzeAddTask(Analyzer* analyzer, const AnalyzeTask* task) {
+    if (analyzer->task_count == analyzer->task_capacity) {
+        int capacity = analyzer->task_capacity ? analyzer->task_capacity * 2 : 256;
+        AnalyzeTask* tasks = realloc(analyzer->tasks, sizeof(AnalyzeTask) * capacity);
+        if (!tasks) return false;
+        analyzer->tasks = tasks;
+        analyzer->task_capacity = capacity;
+    }
+    analyzer->tasks[analyzer->task_count++] = *task;
+    return true;
+}
+
+// Only record headers are read here; the first frame of each excitation is
+// decoded as the file's own reference
+bool AnalyzerAddFile(Analyzer* analyzer, const char* path) {
+    if (analyzer->file_count == analyzer->file_capacity) {
+        int capacity = analyzer->file_capacity ? analyzer->file_capacity * 2 : 16;
+        AnalyzeFile* files = realloc(analyzer->files, sizeof(AnalyzeFile) * capacity);
+        if (!files) return false;
+        analyzer->files = files;
+        analyzer->file_capacity = capacity;
+    }
+    
+    AnalyzeFile* file = &analyzer->files[analyzer->file_count];
+    memset(file, 0, sizeof(*file));
+    strncpy(file->path, path, sizeof(file->path) - 1);
+    if (!CaptureMapOpen(&file->map, path)) return false;
+    
+    AnalyzeTask task = {(uint32_t)analyzer->file_count, 0, 0, CAPTURE_HEADER_BYTES};
+    int first_task = analyzer->task_count;
+    bool ok = true;
+    uint64_t offset = CAPTURE_HEADER_BYTES;
+    CaptureFrameInfo info;
+    const uint8_t* payload;
+    size_t length;
+    
+    while (ok) {
+        uint64_t next = CaptureMapRecord(&file->map, offset, &info, &payload, &length);
+        if (next == 0) break;
+        
+        int e = info.excitation ? 1 : 0;
+        if (!file->has_first[e]) {
+            RawFrame frame;
+            if (CodecDecode(payload, length, &frame)) {
+                FrameSplit(&frame, &file->first[e]);
+                file->has_first[e] = true;
+            }
+        }
+        
+        if (task.count == ANALYZE_CHUNK_FRAMES) {
+            if (!AnalyzeAddTask(analyzer, &task)) {
+                ok = false;
+                break;
+            }
+            task.first_frame = file->frames;
+            task.count = 0;
+            task.offset = offset;
+        }
+        task.count++;
+        file->frames++;
+        offset = next;
+    }
+    
+    if (ok && task.count > 0) ok = AnalyzeAddTask(analyzer, &task);
+    if (!ok) {
+        // The file is not counted, so neither may its tasks be
+        analyzer->task_count = first_task;
+        CaptureMapClose(&file->map);
+        return false;
+    }
+    file->damaged = offset != file->map.size;
+    analyzer->file_count++;
+    return true;
+}
+
+bool AnalyzerSetReference(Analyzer* analyzer, const char* path) {
+    CaptureMap map;
+    if (!CaptureMapOpen(&map, path)) return false;
+    
+    static int64_t sums[2][3][FRAME_MAX_SAMPLES];
+    uint64_t counts[2] = {0, 0};
+    memset(sums, 0, sizeof(sums));
+    
+    uint64_t offset = CAPTURE_HEADER_BYTES;
+    CaptureFrameInfo info;
+    const uint8_t* payload;
+    size_t length;
+    RawFrame frame;
+    FrameSamples samples;
+    
+    while ((offset = CaptureMapRecord(&map, offset, &info, &payload, &length)) != 0) {
+        if (!CodecDecode(payload, length, &frame)) continue;
+        FrameSplit(&frame, &samples);
+        
+        // The first frame of each excitation sets the geometry averaged
+        int e = info.excitation ? 1 : 0;
+        FrameSamples* ref = &analyzer->reference[e];
+        if (counts[e] == 0) {
+            ref->count = samples.count;
+            ref->bits = samples.bits;
+            ref->origin = samples.origin;
+        } else if (samples.count != ref->count || samples.bits != ref->bits || samples.origin != ref->origin) {
+            continue;
+        }
+        for (int i = 0; i < samples.count; i++) {
+            sums[e][0][i] += samples.drive[i];
+            sums[e][1][i] += samples.ch1[i];
+            sums[e][2][i] += samples.ch2[i];
+        }
+        counts[e]++;
+    }
+    CaptureMapClose(&map);
+    
+    for (int e = 0; e < 2; e++) {
+        analyzer->has_reference[e] = counts[e] > 0;
+        if (!counts[e]) continue;
+        
+        FrameSamples* ref = &analyzer->reference[e];
+        int64_t half = (int64_t)(counts[e] / 2);
+        for (int i = 0; i < ref->count; i++) {
+            ref->drive[i] = (uint16_t)((sums[e][0][i] + half) / (int64_t)counts[e]);
+            ref->ch1[i] = (uint16_t)((sums[e][1][i] + half) / (int64_t)counts[e]);
+            ref->ch2[i] = (uint16_t)((sums[e][2][i] + half) / (int64_t)counts[e]);
+        }
+    }
+    return analyzer->has_reference[0] || analyzer->has_reference[1];
+}
+
+static void AnalyzeStatAdd(AnalyzeStat* s, float v) {
+    if (isnan(v)) return;
+    if (s->count == 0 || v < s->min) s->min = v;
+    if (s->count == 0 || v > s->max) s->max = v;
+    
+    s->count++;
+    double d = v - s->mean;
+    s->mean += d / (double)s->count;
+    s->m2 += d * (v - s->mean);
+}
+
+// Chan et al. pairwise combination of two running variances
+static void AnalyzeStatMerge(AnalyzeStat* into, const AnalyzeStat* s) {
+    if (s->count == 0) return;
+    if (into->count == 0) {
+        *into = *s;
+        return;
+    }
+    
+    double na = (double)into->count, nb = (double)s->count;
+    double d = s->mean - into->mean;
+    into->mean += d * nb / (na + nb);
+    into->m2 += s->m2 + d * d * na * nb / (na + nb);
+    into->count += s->count;
+    if (s->min < into->min) into->min = s->min;
+    if (s->max > into->max) into->max = s->max;
+}
+
+static void AnalyzeOutlierPush(AnalyzeWorker* worker, int capacity, const AnalyzeOutlier* o) {
+    AnalyzeOutlier* heap = worker->outliers;
+    int i;
+    
+    if (worker->outlier_count < capacity) {
+        // Sift up
+        i = worker->outlier_count++;
+        while (i > 0 && heap[(i - 1) / 2].deviation > o->deviation) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *o;
+        return;
+    }
+    if (capacity == 0 || o->deviation <= heap[0].deviation) return;
+    
+    // Replace the smallest and sift down
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= capacity) break;
+        if (child + 1 < capacity && heap[child + 1].deviation < heap[child].deviation) child++;
+        if (heap[child].deviation >= o->deviation) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = *o;
+}
+
+static void AnalyzeRunTask(Analyzer* analyzer, AnalyzeWorker* worker, const AnalyzeTask* task,
+                           uint64_t* frames, uint64_t* bad) {
+    const AnalyzeFile* file = &analyzer->files[task->file];
+    AnalyzeStat* file_stats = worker->stats + (size_t)task->file * 2 * 2 * ANALYZE_STATS;
+    
+    uint64_t offset = task->offset;
+    CaptureFrameInfo info;
+    const uint8_t* payload;
+    size_t length;
+    RawFrame frame;
+    FrameSamples samples;
+    float voltage[FRAME_MAX_SAMPLES], current[FRAME_MAX_SAMPLES];
+    
+    for (uint32_t k = 0; k < task->count; k++) {
+        offset = CaptureMapRecord(&file->map, offset, &info, &payload, &length);
+        if (offset == 0) break;
+        if (!CodecDecode(payload, length, &frame)) {
+            (*bad)++;
+            continue;
+        }
+        FrameSplit(&frame, &samples);
+        (*frames)++;
+        
+        int e = info.excitation ? 1 : 0;
+        const FrameSamples* ref = analyzer->has_reference[e] ? &analyzer->reference[e] :
+                                  file->has_first[e] ? &file->first[e] : NULL;
+        if (ref && (ref->count != samples.count || ref->bits != samples.bits || ref->origin != samples.origin)) {
+            ref = NULL;
+        }
+        const uint16_t* channels[2] = {samples.ch1, samples.ch2};
+        
+        MetricsParams params;
+        MetricsParamsRaw(&params, samples.bits, samples.origin, e == 1);
+        
+        for (int c = 0; c < 2; c++) {
+            AnalyzeStat* s = file_stats + (e * 2 + c) * ANALYZE_STATS;
+            
+            // Same raw view and kernel as the capture summaries
+            for (int i = 0; i < samples.count; i++) {
+                voltage[i] = (float)channels[c][i];
+                current[i] = (float)(samples.drive[i] - channels[c][i]);
+            }
+            MetricsResult m;
+            MetricsCompute(voltage, current, samples.drive, channels[c], samples.count, &params, &m);
+            AnalyzeStatAdd(&s[ANALYZE_R_SMALL], m.r_small);
+            AnalyzeStatAdd(&s[ANALYZE_V_KNEE], m.v_knee);
+            AnalyzeStatAdd(&s[ANALYZE_I_LEAK], m.i_leak);
+            AnalyzeStatAdd(&s[ANALYZE_NOISE], m.noise);
+            AnalyzeStatAdd(&s[ANALYZE_LOOP_AREA], m.loop_area);
+            
+            if (!ref) continue;
+            
+            int max_dev;
+            int64_t sum;
+            const uint16_t* ref_channel = c ? ref->ch2 : ref->ch1;
+            TriggerChannelDeviation(channels[c], ref_channel, samples.count, &max_dev, &sum);
+            
+            AnalyzeOutlier o = {task->file, task->first_frame + k, info.sequence, (uint8_t)e, (uint8_t)c,
+                                samples.count > 0 ? (float)sum / samples.count : 0};
+            AnalyzeStatAdd(&s[ANALYZE_DEVIATION], o.deviation);
+            AnalyzeOutlierPush(worker, analyzer->max_outliers, &o);
+        }
+    }
+}
+
+// Owner takes from the front of its run, thieves from the back. Both sides
+// CAS the same word, so a task is never handed out twice.
+static bool AnalyzeTakeFront(AnalyzeWorker* worker, uint32_t* task) {
+    uint64_t range = AtomicLoad64(&worker->range);
+    for (;;) {
+        uint32_t next = (uint32_t)range;
+        uint32_t end = (uint32_t)(range >> 32);
+        if (next >= end) return false;
+        if (AtomicCompareExchange64(&worker->range, &range, ((uint64_t)end << 32) | (next + 1))) {
+            *task = next;
+            return true;
+        }
+    }
+}
+
+static bool AnalyzeTakeBack(AnalyzeWorker* worker, uint32_t* task) {
+    uint64_t range = AtomicLoad64(&worker->range);
+    for (;;) {
+        uint32_t next = (uint32_t)range;
+        uint32_t end = (uint32_t)(range >> 32);
+        if (next >= end) return false;
+        if (AtomicCompareExchange64(&worker->range, &range, ((uint64_t)(end - 1) << 32) | next)) {
+            *task = end - 1;
+            return true;
+        }
+    }
+}
+
+static void AnalyzeWorkerMain(void* arg) {
+    AnalyzeWorker* worker = arg;
+    Analyzer* analyzer = worker->analyzer;
+    uint64_t frames = 0, bad = 0, steals = 0;
+    uint32_t task;
+    
+    for (;;) {
+        if (!AnalyzeTakeFront(worker, &task)) {
+            // Steal from whoever has the most left
+            AnalyzeWorker* victim = NULL;
+            uint32_t most = 0;
+            for (int i = 0; i < analyzer->worker_count; i++) {
+                uint64_t range = AtomicLoad64(&analyzer->workers[i].range);
+                uint32_t left = (uint32_t)(range >> 32) - (uint32_t)range;
+                if ((uint32_t)range < (uint32_t)(range >> 32) && left > most) {
+                    most = left;
+                    victim = &analyzer->workers[i];
+                }
+            }
+            if (!victim) break;
+            if (!AnalyzeTakeBack(victim, &task)) continue;
+            steals++;
+        }
+        AnalyzeRunTask(analyzer, worker, &analyzer->tasks[task], &frames, &bad);
+    }
+    
+    worker->frames = frames;
+    worker->bad_frames = bad;
+    worker->steals = steals;
+}
+
+// Worst first; ties in file order so results do not depend on thread count
+static int AnalyzeOutlierCompare(const void* a, const void* b) {
+    const AnalyzeOutlier* x = a;
+    const AnalyzeOutlier* y = b;
+    if (x->deviation != y->deviation) return x->deviation < y->deviation ? 1 : -1;
+    if (x->file != y->file) return x->file < y->file ? -1 : 1;
+    if (x->frame != y->frame) return x->frame < y->frame ? -1 : 1;
+    return (int)x->channel - (int)y->channel;
+}
+
+bool AnalyzerRun(Analyzer* analyzer, int threads) {
+    if (threads <= 0) threads = ThreadCpuCount();
+    if (threads > ANALYZE_MAX_THREADS) threads = ANALYZE_MAX_THREADS;
+    if (threads > analyzer->task_count) threads = analyzer->task_count > 0 ? analyzer->task_count : 1;
+    
+    size_t stat_count = (size_t)analyzer->file_count * 2 * 2 * ANALYZE_STATS;
+    analyzer->stats = calloc(stat_count ? stat_count : 1, sizeof(AnalyzeStat));
+    analyzer->workers = calloc(threads, sizeof(AnalyzeWorker));
+    analyzer->outliers = malloc(sizeof(AnalyzeOutlier) * ((size_t)analyzer->max_outliers * threads + 1));
+    if (!analyzer->stats || !analyzer->workers || !analyzer->outliers) return false;
+    
+    // Counted before their buffers, so AnalyzerFree releases whatever a failed allocation left
+    analyzer->worker_count = threads;
+    
+    // Contiguous runs keep each worker on neighbouring chunks of the same file
+    for (int i = 0; i < threads; i++) {
+        AnalyzeWorker* worker = &analyzer->workers[i];
+        uint32_t begin = (uint32_t)((uint64_t)analyzer->task_count * i / threads);
+        uint32_t end = (uint32_t)((uint64_t)analyzer->task_count * (i + 1) / threads);
+        worker->range = ((uint64_t)end << 32) | begin;
+        worker->analyzer = analyzer;
+        worker->stats = calloc(stat_count ? stat_count : 1, sizeof(AnalyzeStat));
+        worker->outliers = malloc(sizeof(AnalyzeOutlier) * (analyzer->max_outliers + 1));
+        if (!worker->stats || !worker->outliers) return false;
+    }
+    
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (!ThreadCreate(&analyzer->workers[i].thread, AnalyzeWorkerMain, &analyzer->workers[i])) break;
+        started++;
+    }
+    // Runs of threads that failed to start are stolen by the others
+    if (started == 0) AnalyzeWorkerMain(&analyzer->workers[0]);
+    for (int i = 0; i < started; i++) {
+        ThreadJoin(&analyzer->workers[i].thread);
+    }
+    
+    analyzer->outlier_count = 0;
+    for (int i = 0; i < threads; i++) {
+        AnalyzeWorker* worker = &analyzer->workers[i];
+        for (size_t s = 0; s < stat_count; s++) {
+            AnalyzeStatMerge(&analyzer->stats[s], &worker->stats[s]);
+        }
+        memcpy(analyzer->outliers + analyzer->outlier_count, worker->outliers,
+               sizeof(AnalyzeOutlier) * worker->outlier_count);
+        analyzer->outlier_count += worker->outlier_count;
+        analyzer->frames += worker->frames;
+        analyzer->bad_frames += worker->bad_frames;
+        analyzer->steals += worker->steals;
+    }
+    
+    qsort(analyzer->outliers, analyzer->outlier_count, sizeof(AnalyzeOutlier), AnalyzeOutlierCompare);
+    if (analyzer->outlier_count > analyzer->max_outliers) analyzer->outlier_count = analyzer->max_outliers;
+    return true;
+}
+
+const AnalyzeStat* AnalyzerStat(const Analyzer* analyzer, int file, int excitation, int channel, int key) {
+    return &analyzer->stats[((size_t)file * 4 + excitation * 2 + channel) * ANALYZE_STATS + key];
+}
+
+// One row per file, excitation and channel that has frames
+void AnalyzerWriteTable(const Analyzer* analyzer, FILE* f) {
+    fprintf(f, "file,excitation,channel,frames");
+    for (int k = 0; k < ANALYZE_STATS; k++) {
+        fprintf(f, ",%s_mean,%s_std,%s_min,%s_max", ANALYZE_STAT_NAMES[k], ANALYZE_STAT_NAMES[k],
+                ANALYZE_STAT_NAMES[k], ANALYZE_STAT_NAMES[k]);
+    }
+    fprintf(f, "\n");
+    
+    for (int file = 0; file < analyzer->file_count; file++) {
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 2; c++) {
+                // i_leak is never NAN, so its count is the frame count
+                uint64_t frames = AnalyzerStat(analyzer, file, e, c, ANALYZE_I_LEAK)->count;
+                if (frames == 0) continue;
+                
+                fprintf(f, "%s,%d,%d,%llu", analyzer->files[file].path, e, c + 1, (unsigned long long)frames);
+                for (int k = 0; k < ANALYZE_STATS; k++) {
+                    const AnalyzeStat* s = AnalyzerStat(analyzer, file, e, c, k);
+                    if (s->count == 0) {
+                        fprintf(f, ",,,,");
+                        continue;
+                    }
+                    double std = s->count > 1 ? sqrt(s->m2 / (double)(s->count - 1)) : 0.0;
+                    fprintf(f, ",%g,%g,%g,%g", s->mean, std, s->min, s->max);
+                }
+                fprintf(f, "\n");
+            }
+        }
+    }
+}
+
+void AnalyzerWriteOutliers(const Analyzer* analyzer, FILE* f) {
+    fprintf(f, "file,frame,sequence,excitation,channel,deviation\n");
+    for (int i = 0; i < analyzer->outlier_count; i++) {
+        const AnalyzeOutlier* o = &analyzer->outliers[i];
+        fprintf(f, "%s,%u,%u,%d,%d,%g\n", analyzer->files[o->file].path, o->frame, o->sequence,
+                o->excitation, o->channel + 1, o->deviation);
+    }
+}
+
+void AnalyzerFree(Analyzer* analyzer) {
+    for (int i = 0; i < analyzer->file_count; i++) {
+        CaptureMapClose(&analyzer->files[i].map);
+    }
+    for (int i = 0; i < analyzer->worker_count; i++) {
+        free(analyzer->workers[i].stats);
+        free(analyzer->workers[i].outliers);
+    }
+    free(analyzer->files);
+    free(analyzer->tasks);
+    free(analyzer->workers);
+    free(analyzer->stats);
+    free(analyzer->outliers);
+    memset(analyzer, 0, sizeof(*analyzer));
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "capture.h"
+#include "sync.h"
+
+// Offline metrics over many capture files. Files are memory mapped and cut
+// into chunks of consecutive frames; each worker owns a contiguous run of
+// chunks and steals from the far end of another worker's run when its own
+// is empty. Workers keep private aggregates that are merged once at the end.
+//
+// Values are in raw ADC units like the capture summaries, so results do not
+// depend on calibration. Deviation is the mean |sample - reference| per
+// sample, against the reference capture if one is given, otherwise against
+// the file's first frame of the same excitation. Frames of another geometry
+// than their reference get no deviation.
+#define ANALYZE_CHUNK_FRAMES 1024
+#define ANALYZE_MAX_THREADS 64
+
+typedef enum {
+    ANALYZE_R_SMALL,
+    ANALYZE_V_KNEE,
+    ANALYZE_I_LEAK,
+    ANALYZE_NOISE,
+    ANALYZE_LOOP_AREA,
+    ANALYZE_DEVIATION,
+    ANALYZE_STATS
+} AnalyzeStatKey;
+
+extern const char* ANALYZE_STAT_NAMES[ANALYZE_STATS];
+
+// Running count, mean and sum of squared differences; NAN values are skipped
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;
+    float min;
+    float max;
+} AnalyzeStat;
+
+typedef struct {
+    uint32_t file;
+    uint32_t frame;
+    uint32_t sequence;
+    uint8_t excitation;
+    uint8_t channel;
+    float deviation;
+} AnalyzeOutlier;
+
+typedef struct {
+    char path[256];
+    CaptureMap map;
+    uint32_t frames;
+    bool damaged;               // Stopped at a bad record before the end of the file
+    FrameSamples first[2];      // First frame of each excitation, the default reference
+    bool has_first[2];
+} AnalyzeFile;
+
+typedef struct {
+    uint32_t file;
+    uint32_t first_frame;
+    uint32_t count;
+    uint64_t offset;
+} AnalyzeTask;
+
+typedef struct {
+    volatile uint64_t range;    // Task indices still owned, high 32 bits end, low 32 bits next
+    uint8_t pad[56];            // Keep each worker's range on its own cache line
+    
+    void* analyzer;
+    Thread thread;
+    AnalyzeStat* stats;         // [file][excitation][channel][key]
+    AnalyzeOutlier* outliers;   // Min-heap on deviation, worst max_outliers seen
+    int outlier_count;
+    uint64_t frames;
+    uint64_t bad_frames;
+    uint64_t steals;
+} AnalyzeWorker;
+
+typedef struct {
+    AnalyzeFile* files;
+    int file_count;
+    int file_capacity;
+    
+    AnalyzeTask* tasks;
+    int task_count;
+    int task_capacity;
+    
+    FrameSamples reference[2];
+    bool has_reference[2];
+    int max_outliers;
+    
+    AnalyzeWorker* workers;
+    int worker_count;
+    
+    // Merged results
+    AnalyzeStat* stats;
+    AnalyzeOutlier* outliers;   // Worst first
+    int outlier_count;
+    uint64_t frames;
+    uint64_t bad_frames;
+    uint64_t steals;
+} Analyzer;
+
+void AnalyzerInit(Analyzer* analyzer, int max_outliers);
+
+// Maps the file and walks its record headers to cut it into tasks
+bool AnalyzerAddFile(Analyzer* analyzer, const char* path);
+
+// Averages every frame of a capture per excitation into the reference
+bool AnalyzerSetReference(Analyzer* analyzer, const char* path);
+
+// threads <= 0 uses one per core
+bool AnalyzerRun(Analyzer* analyzer, int threads);
+
+const AnalyzeStat* AnalyzerStat(const Analyzer* analyzer, int file, int excitation, int channel, int key);
+void AnalyzerWriteTable(const Analyzer* analyzer, FILE* f);
+void AnalyzerWriteOutliers(const Analyzer* analyzer, FILE* f);
+void AnalyzerFree(Analyzer* analyzer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "calib.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+void CalibrationSetDefaults(CalibrationProfile* profile) {
+    memset(profile, 0, sizeof(*profile));
+    profile->offset = 2048.0f;
+    profile->gain = 3.3f / 4096.0f;
+    profile->nonlinearity = 0.0f;
+    profile->r_std = 4700.0f;
+    profile->r_weak = 100000.0f;
+}
+
+bool CalibrationLoadProfile(const char* filename, const char* serial, CalibrationProfile* profile) {
+    CalibrationSetDefaults(profile);
+    strncpy(profile->serial, serial, sizeof(profile->serial) - 1);
+    
+    FILE* f = fopen(filename, "r");
+    if (!f) return false;
+    
+    bool found = false;
+    bool in_section = false;
+    char line[512];
+    
+    while (fgets(line, sizeof(line), f)) {
+        char section[128];
+        if (sscanf(line, " [%127[^]]]", section) == 1) {
+            in_section = strcmp(section, serial) == 0;
+            found = found || in_section;
+            continue;
+        }
+        if (!in_section) continue;
+        
+        char key[128], value[384];
+        if (sscanf(line, "%127[^=]=%383[^\n]", key, value) == 2) {
+            if (strcmp(key, "offset") == 0) {
+                profile->offset = (float)atof(value);
+            } else if (strcmp(key, "gain") == 0) {
+                profile->gain = (float)atof(value);
+            } else if (strcmp(key, "nonlinearity") == 0) {
+                profile->nonlinearity = (float)atof(value);
+            } else if (strcmp(key, "r_std") == 0) {
+                profile->r_std = (float)atof(value);
+            } else if (strcmp(key, "r_weak") == 0) {
+                profile->r_weak = (float)atof(value);
+            }
+        }
+    }
+    
+    fclose(f);
+    return found;
+}
+
+void CalibrationBuild(CalibrationTable* table, const CalibrationProfile* profile) {
+    table->profile = *profile;
+    
+    for (int code = 0; code < CALIB_LUT_SIZE; code++) {
+        double x = code - profile->offset;
+        table->volts[code] = (float)(profile->gain * x + profile->nonlinearity * x * x);
+    }
+    
+    table->ma_per_volt[0] = profile->r_std > 0 ? 1000.0f / profile->r_std : 0.0f;
+    table->ma_per_volt[1] = profile->r_weak > 0 ? 1000.0f / profile->r_weak : 0.0f;
+    table->valid = true;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef CALIB_H
+#define CALIB_H
+
+#include <stdbool.h>
+#include "frame.h"
+
+// Every code of the deepest frame; the profile is in the device's own codes
+#define CALIB_LUT_SIZE (1 << FRAME_MAX_BITS)
+
+// Per-device calibration, keyed by USB serial number in calibration.cfg:
+//   [serial]
+//   offset=2048          ADC code at 0 V
+//   gain=0.000806        Volts per count
+//   nonlinearity=0       Volts per count squared
+//   r_std=4700           Excitation resistor for T, ohms
+//   r_weak=100000        Excitation resistor for W, ohms
+typedef struct {
+    char serial[64];
+    float offset;
+    float gain;
+    float nonlinearity;
+    float r_std;
+    float r_weak;
+} CalibrationProfile;
+
+// Profile compiled to lookup tables, so conversion is a gather per sample
+typedef struct {
+    bool valid;
+    CalibrationProfile profile;
+    float volts[CALIB_LUT_SIZE];
+    float ma_per_volt[2];       // Indexed by excitation, 0=4.7K, 1=100K
+} CalibrationTable;
+
+void CalibrationSetDefaults(CalibrationProfile* profile);
+bool CalibrationLoadProfile(const char* filename, const char* serial, CalibrationProfile* profile);
+void CalibrationBuild(CalibrationTable* table, const CalibrationProfile* profile);
+
+#endif
\ No newline at end of file
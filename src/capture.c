@@ -0,0 +1,236 @@
+#include "capture.h"
+#include <string.h>
+#include <time.h>
+
+#define CAPTURE_VERSION 2         // 1 only ever held default geometry frames
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define CaptureFileSeek _fseeki64
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CaptureFileSeek fseeko
+#endif
+
+static void CapturePut16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void CapturePut32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static void CapturePut64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static uint32_t CaptureGet32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t CaptureGet64(const uint8_t* p) {
+    return (uint64_t)CaptureGet32(p) | ((uint64_t)CaptureGet32(p + 4) << 32);
+}
+
+bool CaptureWriterOpen(CaptureWriter* writer, const char* path, CodecMode mode) {
+    memset(writer, 0, sizeof(*writer));
+    
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+    
+    strncpy(writer->path, path, sizeof(writer->path) - 1);
+    writer->mode = mode;
+    
+    uint8_t header[CAPTURE_HEADER_BYTES];
+    memcpy(header, CAPTURE_MAGIC, 8);
+    CapturePut64(header + 8, (uint64_t)time(NULL));
+    CapturePut32(header + 16, FRAME_MAX_VALUES);
+    CapturePut32(header + 20, CAPTURE_VERSION);
+    
+    if (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) {
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    
+    writer->bytes = sizeof(header);
+    return true;
+}
+
+bool CaptureWriterAppend(CaptureWriter* writer, const RawFrame* frame, const CaptureFrameInfo* info) {
+    if (!writer->file) return false;
+    
+    uint8_t record[CAPTURE_RECORD_BYTES + CODEC_MAX_BYTES];
+    size_t payload = CodecEncode(frame, writer->mode, record + CAPTURE_RECORD_BYTES, CODEC_MAX_BYTES);
+    if (payload == 0) return false;
+    
+    CapturePut16(record, (uint16_t)payload);
+    record[2] = info->excitation;
+    record[3] = 0;
+    CapturePut32(record + 4, info->sequence);
+    CapturePut64(record + 8, info->timestamp_us);
+    
+    size_t total = CAPTURE_RECORD_BYTES + payload;
+    if (fwrite(record, 1, total, writer->file) != total) return false;
+    
+    writer->frames++;
+    writer->bytes += total;
+    return true;
+}
+
+void CaptureWriterClose(CaptureWriter* writer) {
+    if (writer->file) {
+        fclose(writer->file);
+        writer->file = NULL;
+    }
+}
+
+static bool CaptureParseHeader(const uint8_t* header, CaptureHeader* out) {
+    if (memcmp(header, CAPTURE_MAGIC, 8) != 0) return false;
+    out->start_time = CaptureGet64(header + 8);
+    out->frame_values = CaptureGet32(header + 16);
+    out->version = CaptureGet32(header + 20);
+    return out->frame_values >= FRAME_VALUES && out->frame_values <= FRAME_MAX_VALUES;
+}
+
+bool CaptureReaderOpen(CaptureReader* reader, const char* path) {
+    memset(reader, 0, sizeof(*reader));
+    
+    reader->file = fopen(path, "rb");
+    if (!reader->file) return false;
+    
+    uint8_t header[CAPTURE_HEADER_BYTES];
+    if (fread(header, 1, sizeof(header), reader->file) != sizeof(header) ||
+        !CaptureParseHeader(header, &reader->header)) {
+        CaptureReaderClose(reader);
+        return false;
+    }
+    
+    reader->offset = CAPTURE_HEADER_BYTES;
+    return true;
+}
+
+bool CaptureReaderNext(CaptureReader* reader, RawFrame* frame, CaptureFrameInfo* info) {
+    if (!reader->file) return false;
+    
+    uint8_t record[CAPTURE_RECORD_BYTES];
+    if (fread(record, 1, sizeof(record), reader->file) != sizeof(record)) return false;
+    
+    size_t payload = record[0] | (record[1] << 8);
+    if (payload > CODEC_MAX_BYTES) return false;
+    
+    uint8_t data[CODEC_MAX_BYTES];
+    if (fread(data, 1, payload, reader->file) != payload) return false;
+    
+    info->excitation = record[2];
+    info->sequence = CaptureGet32(record + 4);
+    info->timestamp_us = CaptureGet64(record + 8);
+    
+    reader->offset += CAPTURE_RECORD_BYTES + payload;
+    return CodecDecode(data, payload, frame);
+}
+
+bool CaptureReaderSkip(CaptureReader* reader) {
+    if (!reader->file) return false;
+    
+    uint8_t record[CAPTURE_RECORD_BYTES];
+    if (fread(record, 1, sizeof(record), reader->file) != sizeof(record)) return false;
+    
+    size_t payload = record[0] | (record[1] << 8);
+    if (payload > CODEC_MAX_BYTES) return false;
+    
+    return CaptureReaderSeek(reader, reader->offset + CAPTURE_RECORD_BYTES + payload);
+}
+
+bool CaptureReaderSeek(CaptureReader* reader, uint64_t offset) {
+    if (!reader->file || CaptureFileSeek(reader->file, (long long)offset, SEEK_SET) != 0) return false;
+    reader->offset = offset;
+    return true;
+}
+
+void CaptureReaderClose(CaptureReader* reader) {
+    if (reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+bool CaptureMapOpen(CaptureMap* map, const char* path) {
+    memset(map, 0, sizeof(*map));
+    
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= CAPTURE_HEADER_BYTES) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    
+    map->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    map->size = (uint64_t)size.QuadPart;
+    map->file = file;
+    map->mapping = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < CAPTURE_HEADER_BYTES) {
+        close(fd);
+        return false;
+    }
+    
+    // The mapping keeps its own reference to the file
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    
+    map->data = data;
+    map->size = (uint64_t)st.st_size;
+#endif
+    
+    if (!map->data || !CaptureParseHeader(map->data, &map->header)) {
+        CaptureMapClose(map);
+        return false;
+    }
+    return true;
+}
+
+void CaptureMapClose(CaptureMap* map) {
+#ifdef _WIN32
+    if (map->data) UnmapViewOfFile(map->data);
+    if (map->mapping) CloseHandle(map->mapping);
+    if (map->file) CloseHandle(map->file);
+#else
+    if (map->data) munmap((void*)map->data, (size_t)map->size);
+#endif
+    memset(map, 0, sizeof(*map));
+}
+
+uint64_t CaptureMapRecord(const CaptureMap* map, uint64_t offset, CaptureFrameInfo* info,
+                          const uint8_t** payload, size_t* payload_len) {
+    if (offset + CAPTURE_RECORD_BYTES > map->size) return 0;
+    
+    const uint8_t* record = map->data + offset;
+    size_t length = record[0] | (record[1] << 8);
+    if (length > CODEC_MAX_BYTES || offset + CAPTURE_RECORD_BYTES + length > map->size) return 0;
+    
+    info->excitation = record[2];
+    info->sequence = CaptureGet32(record + 4);
+    info->timestamp_us = CaptureGet64(record + 8);
+    *payload = record + CAPTURE_RECORD_BYTES;
+    *payload_len = length;
+    return offset + CAPTURE_RECORD_BYTES + length;
+}
\ No newline at end of file
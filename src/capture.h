@@ -0,0 +1,72 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include "frame.h"
+#include "codec.h"
+
+// File layout: 24 byte header, then one record per frame:
+//   u16 payload length, u8 excitation, u8 reserved, u32 sequence,
+//   u64 timestamp in microseconds since start, codec payload.
+// All fields are little endian. Each payload carries its frame's geometry.
+#define CAPTURE_MAGIC "CBUGCAP1"
+#define CAPTURE_HEADER_BYTES 24
+#define CAPTURE_RECORD_BYTES 16
+
+typedef struct {
+    uint64_t start_time;        // Unix time when recording started
+    uint32_t frame_values;      // Largest frame the records may hold
+    uint32_t version;
+} CaptureHeader;
+
+typedef struct {
+    uint64_t timestamp_us;
+    uint32_t sequence;
+    uint8_t excitation;         // 0=4.7K, 1=100K
+} CaptureFrameInfo;
+
+typedef struct {
+    FILE* file;
+    CodecMode mode;
+    uint32_t frames;
+    uint64_t bytes;
+    char path[256];
+} CaptureWriter;
+
+typedef struct {
+    FILE* file;
+    CaptureHeader header;
+    uint64_t offset;            // File offset of the next record
+} CaptureReader;
+
+// Read-only mapping of a whole capture, for tools that scan many frames
+// from several threads without copying them through stdio
+typedef struct {
+    const uint8_t* data;
+    uint64_t size;
+    CaptureHeader header;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+} CaptureMap;
+
+bool CaptureWriterOpen(CaptureWriter* writer, const char* path, CodecMode mode);
+bool CaptureWriterAppend(CaptureWriter* writer, const RawFrame* frame, const CaptureFrameInfo* info);
+void CaptureWriterClose(CaptureWriter* writer);
+
+bool CaptureReaderOpen(CaptureReader* reader, const char* path);
+bool CaptureReaderNext(CaptureReader* reader, RawFrame* frame, CaptureFrameInfo* info);
+bool CaptureReaderSkip(CaptureReader* reader);
+bool CaptureReaderSeek(CaptureReader* reader, uint64_t offset);
+void CaptureReaderClose(CaptureReader* reader);
+
+bool CaptureMapOpen(CaptureMap* map, const char* path);
+void CaptureMapClose(CaptureMap* map);
+
+// Parses the record at offset without decoding it. Returns the offset of the
+// next record, or 0 at the end of the file or on a damaged record.
+uint64_t CaptureMapRecord(const CaptureMap* map, uint64_t offset, CaptureFrameInfo* info,
+                          const uint8_t** payload, size_t* payload_len);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "classify.h"
+#include "frame.h"
+#include <math.h>
+
+const char* CLASSIFY_LABEL_NAMES[CLASS_COUNT] = {
+    "UNKNOWN", "OPEN", "SHORT", "RESISTOR", "DIODE", "CAPACITOR", "ESD CLAMP"
+};
+
+void ClassifyParamsRaw(ClassifyParams* params, int bits, int origin) {
+    params->v_origin = (float)origin;
+    params->volts_per_current = 1.0f;       // current is drive - raw in the same counts
+    params->rail_lo = 0;
+    params->rail_hi = (float)FrameCodeMax(bits);
+}
+
+void ClassifyParamsCalibrated(ClassifyParams* params, const CalibrationTable* calib, int bits, int origin, bool weak) {
+    float ma_per_volt = calib->ma_per_volt[weak ? 1 : 0];
+    int code_max = FrameCodeMax(bits);
+    params->v_origin = calib->volts[origin];
+    params->volts_per_current = ma_per_volt > 0 ? 1.0f / ma_per_volt : 0.0f;
+    params->rail_lo = fminf(calib->volts[0], calib->volts[code_max]);
+    params->rail_hi = fmaxf(calib->volts[0], calib->volts[code_max]);
+}
+
+// Two passes over the sweep: one for the extremes, one for everything else
+void ClassifyFeaturesCompute(const float* voltage, const float* current, int count,
+                             const ClassifyParams* params, ClassifyFeatures* features) {
+    float drive_peak = 0;
+    float v_lo = INFINITY, v_hi = -INFINITY, u_lo = INFINITY, u_hi = -INFINITY;
+    
+    for (int k = 0; k < count; k++) {
+        float v = voltage[k] - params->v_origin;
+        float u = current[k] * params->volts_per_current;
+        float d = fabsf(v + u);
+        if (d > drive_peak) drive_peak = d;
+        if (v < v_lo) v_lo = v;
+        if (v > v_hi) v_hi = v;
+        if (u < u_lo) u_lo = u;
+        if (u > u_hi) u_hi = u;
+    }
+    
+    float inner_sum[2] = {0, 0}, outer_sum[2] = {0, 0};
+    int inner_n[2] = {0, 0}, outer_n[2] = {0, 0};
+    float rail_lo = params->rail_lo - params->v_origin;
+    float rail_hi = params->rail_hi - params->v_origin;
+    float tolerance = (rail_hi - rail_lo) * 0.001f;
+    double area = 0;
+    int pinned = 0;
+    
+    for (int k = 0; k < count && drive_peak > 0; k++) {
+        float v = voltage[k] - params->v_origin;
+        float u = current[k] * params->volts_per_current;
+        float d = v + u;
+        float level = fabsf(d) / drive_peak;
+        int side = d < 0;
+        
+        if (level >= 0.2f && level <= 0.5f) {
+            inner_sum[side] += v / d;
+            inner_n[side]++;
+        } else if (level >= 0.7f) {
+            outer_sum[side] += v / d;
+            outer_n[side]++;
+        }
+        
+        pinned += v <= rail_lo + tolerance || v >= rail_hi - tolerance ||
+                  d <= rail_lo + tolerance || d >= rail_hi - tolerance;
+        
+        int prev = k ? k - 1 : count - 1;
+        float v_prev = voltage[prev] - params->v_origin;
+        float u_prev = current[prev] * params->volts_per_current;
+        area += (double)v_prev * u - (double)v * u_prev;
+    }
+    
+    // A side the sweep never reaches reads as open
+    for (int s = 0; s < 2; s++) {
+        features->fraction_inner[s] = inner_n[s] ? inner_sum[s] / inner_n[s] : 1.0f;
+        features->fraction_outer[s] = outer_n[s] ? outer_sum[s] / outer_n[s] : features->fraction_inner[s];
+    }
+    
+    float box = (v_hi - v_lo) * (u_hi - u_lo);
+    features->loop = box > 0 ? (float)(fabs(area) * 0.5 / box) : 0.0f;
+    features->pinned = count ? (float)pinned / count : 0.0f;
+}
+
+// 0 at from, 1 at to, either direction
+static float ClassifyRamp(float x, float from, float to) {
+    float t = (x - from) / (to - from);
+    return t < 0 ? 0 : (t > 1 ? 1 : t);
+}
+
+void ClassifyCurve(const float* voltage, const float* current, int count,
+                   const ClassifyParams* params, ClassifyResult* result) {
+    ClassifyFeatures* f = &result->features;
+    ClassifyFeaturesCompute(voltage, current, count, params, f);
+    
+    float score[CLASS_COUNT] = {0};
+    float knee[2], blocking[2], linear[2];
+    for (int s = 0; s < 2; s++) {
+        // A junction blocks at low drive and conducts at high drive
+        knee[s] = ClassifyRamp(f->fraction_inner[s] - f->fraction_outer[s], 0.1f, 0.3f) *
+                  ClassifyRamp(f->fraction_outer[s], 0.7f, 0.4f);
+        blocking[s] = ClassifyRamp(f->fraction_outer[s], 0.8f, 0.93f);
+        linear[s] = ClassifyRamp(fabsf(f->fraction_inner[s] - f->fraction_outer[s]), 0.12f, 0.04f);
+    }
+    
+    float lowest = fminf(fminf(f->fraction_outer[0], f->fraction_outer[1]),
+                         fminf(f->fraction_inner[0], f->fraction_inner[1]));
+    float highest = fmaxf(fmaxf(f->fraction_outer[0], f->fraction_outer[1]),
+                          fmaxf(f->fraction_inner[0], f->fraction_inner[1]));
+    float not_loop = 1.0f - ClassifyRamp(f->loop, 0.04f, 0.15f);
+    
+    score[CLASS_CAPACITOR] = ClassifyRamp(f->loop, 0.04f, 0.15f);
+    score[CLASS_OPEN] = ClassifyRamp(lowest, 0.85f, 0.95f) * not_loop;
+    score[CLASS_SHORT] = ClassifyRamp(highest, 0.1f, 0.03f) * not_loop;
+    score[CLASS_RESISTOR] = linear[0] * linear[1] *
+                            ClassifyRamp(fabsf(f->fraction_outer[0] - f->fraction_outer[1]), 0.12f, 0.04f) *
+                            (1.0f - score[CLASS_OPEN]) * (1.0f - score[CLASS_SHORT]) * not_loop;
+    score[CLASS_DIODE] = fmaxf(knee[0] * blocking[1], knee[1] * blocking[0]) * not_loop;
+    score[CLASS_ESD] = knee[0] * knee[1] * not_loop;
+    
+    result->label = CLASS_UNKNOWN;
+    result->confidence = 0;
+    for (int c = 1; c < CLASS_COUNT; c++) {
+        if (score[c] > result->confidence) {
+            result->confidence = score[c];
+            result->label = (ClassifyLabel)c;
+        }
+    }
+    
+    // A curve running into the rails is only partly seen
+    result->confidence *= 1.0f - 0.5f * ClassifyRamp(f->pinned, 0.1f, 0.4f);
+    if (result->confidence < 0.4f) result->label = CLASS_UNKNOWN;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include <stdbool.h>
+#include "calib.h"
+
+// What the probe is most likely touching, judged from the shape of one sweep.
+// Pure computation on the plotted arrays, so it runs on recorded or synthetic
+// curves as easily as on live frames.
+typedef enum {
+    CLASS_UNKNOWN = 0,
+    CLASS_OPEN,
+    CLASS_SHORT,
+    CLASS_RESISTOR,
+    CLASS_DIODE,
+    CLASS_CAPACITOR,
+    CLASS_ESD,              // Clamps in both directions, e.g. a protected IC pin
+    CLASS_COUNT
+} ClassifyLabel;
+
+extern const char* CLASSIFY_LABEL_NAMES[CLASS_COUNT];
+
+// Converts the plot's units to a voltage divider: drive = (v - v_origin) + current * volts_per_current
+typedef struct {
+    float v_origin;
+    float volts_per_current;
+    float rail_lo, rail_hi;     // ADC limits at the frame's depth, in plot voltage units
+} ClassifyParams;
+
+// Shape features, all unitless. The divider fraction is DUT voltage over drive:
+// 1 for an open, 0 for a short, constant for a resistor.
+typedef struct {
+    float fraction_inner[2];    // Mean fraction at 20-50% of peak drive, [0]=positive, [1]=negative side
+    float fraction_outer[2];    // Mean fraction at 70-100% of peak drive
+    float loop;                 // Enclosed area over the bounding box area
+    float pinned;               // Share of samples with DUT or drive voltage at an ADC rail
+} ClassifyFeatures;
+
+typedef struct {
+    ClassifyLabel label;
+    float confidence;           // 0..1
+    ClassifyFeatures features;
+} ClassifyResult;
+
+void ClassifyParamsRaw(ClassifyParams* params, int bits, int origin);
+void ClassifyParamsCalibrated(ClassifyParams* params, const CalibrationTable* calib, int bits, int origin, bool weak);
+
+void ClassifyFeaturesCompute(const float* voltage, const float* current, int count,
+                             const ClassifyParams* params, ClassifyFeatures* features);
+void ClassifyCurve(const float* voltage, const float* current, int count,
+                   const ClassifyParams* params, ClassifyResult* result);
+                   
+#endif
\ No newline at end of file
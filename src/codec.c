@@ -0,0 +1,416 @@
+#include "codec.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define CODEC_SSE2
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+_Static_assert(FRAME_VALUES % CODEC_BLOCK == 0, "the default frame has no partial blocks");
+
+static int CodecBitWidth(uint32_t v) {
+    if (v == 0) return 0;
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, v);
+    return (int)index + 1;
+#else
+    return 32 - __builtin_clz(v);
+#endif
+}
+
+static uint32_t CodecLoad32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void CodecStore32(uint8_t* p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static uint64_t CodecLoad64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void CodecStore64(uint8_t* p, uint64_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Four 12-bit samples per 6 bytes. Stores write 8 bytes, so the output needs
+// two bytes of slack past the packed data, which CodecMaxBytes covers.
+static size_t CodecPack12(const uint16_t* values, uint8_t* out) {
+    for (int i = 0; i < FRAME_VALUES; i += 4) {
+        uint64_t v = (uint64_t)values[i] |
+                     ((uint64_t)values[i + 1] << 12) |
+                     ((uint64_t)values[i + 2] << 24) |
+                     ((uint64_t)values[i + 3] << 36);
+        CodecStore64(out + i / 4 * 6, v);
+    }
+    return CODEC_PACKED12_BYTES;
+}
+
+static void CodecUnpack12(const uint8_t* in, uint16_t* values) {
+    int i = 0;
+    for (; i + 4 < FRAME_VALUES; i += 4) {
+        uint64_t v = CodecLoad64(in + i / 4 * 6);
+        values[i]     = v & 0x0FFF;
+        values[i + 1] = (v >> 12) & 0x0FFF;
+        values[i + 2] = (v >> 24) & 0x0FFF;
+        values[i + 3] = (v >> 36) & 0x0FFF;
+    }
+    
+    // Last group without reading past the end of the input
+    uint8_t tail[8] = {0};
+    memcpy(tail, in + i / 4 * 6, 6);
+    uint64_t v = CodecLoad64(tail);
+    values[i]     = v & 0x0FFF;
+    values[i + 1] = (v >> 12) & 0x0FFF;
+    values[i + 2] = (v >> 24) & 0x0FFF;
+    values[i + 3] = (v >> 36) & 0x0FFF;
+}
+
+// Difference against the same channel one triple back, zigzag mapped so small
+// moves in either direction become small unsigned codes. At 16 bits the
+// difference wraps, which the running sum on decode undoes exactly.
+static void CodecDeltaZigzag(const uint16_t* values, int count, int origin, uint16_t* codes) {
+    const uint16_t prev[3] = {(uint16_t)origin, (uint16_t)origin, (uint16_t)origin};
+    int i = 0;
+    
+    for (; i < 3; i++) {
+        int16_t d = (int16_t)(values[i] - prev[i]);
+        codes[i] = (uint16_t)(((uint16_t)d << 1) ^ (d >> 15));
+    }
+    
+#ifdef CODEC_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i cur = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i back = _mm_loadu_si128((const __m128i*)(values + i - 3));
+        __m128i d = _mm_sub_epi16(cur, back);
+        __m128i z = _mm_xor_si128(_mm_slli_epi16(d, 1), _mm_srai_epi16(d, 15));
+        _mm_storeu_si128((__m128i*)(codes + i), z);
+    }
+#endif
+    
+    for (; i < count; i++) {
+        int16_t d = (int16_t)(values[i] - values[i - 3]);
+        codes[i] = (uint16_t)(((uint16_t)d << 1) ^ (d >> 15));
+    }
+}
+
+static int CodecBlockWidth(const uint16_t* codes, int count) {
+    uint32_t bits = 0;
+    int i = 0;
+    
+#ifdef CODEC_SSE2
+    if (count == CODEC_BLOCK) {
+        __m128i acc = _mm_or_si128(_mm_loadu_si128((const __m128i*)codes),
+                                   _mm_loadu_si128((const __m128i*)(codes + 8)));
+        acc = _mm_or_si128(acc, _mm_srli_si128(acc, 8));
+        acc = _mm_or_si128(acc, _mm_srli_si128(acc, 4));
+        acc = _mm_or_si128(acc, _mm_srli_si128(acc, 2));
+        bits = (uint32_t)_mm_cvtsi128_si32(acc) & 0xFFFF;
+        i = count;
+    }
+#endif
+    
+    for (; i < count; i++) {
+        bits |= codes[i];
+    }
+    return CodecBitWidth(bits);
+}
+
+// A block of 16 codes at width w is 2w bytes, so every block starts on a
+// byte and can be packed and unpacked on its own. One pair of functions per
+// width, written out per code, lets every shift, offset and flush fold into
+// a constant without relying on the optimizer to unroll.
+#define CODEC_EACH_CODE(step, w) \
+    step(w, 0) step(w, 1) step(w, 2) step(w, 3) step(w, 4) step(w, 5) step(w, 6) step(w, 7) \
+    step(w, 8) step(w, 9) step(w, 10) step(w, 11) step(w, 12) step(w, 13) step(w, 14) step(w, 15)
+
+#define CODEC_PACK_CODE(w, i) \
+    acc |= (uint64_t)codes[i] << ((i) * (w) % 32); \
+    if (((i) + 1) * (w) / 32 != (i) * (w) / 32) { \
+        CodecStore32(dst + (i) * (w) / 32 * 4, (uint32_t)acc); \
+        acc >>= 32; \
+    }
+
+#define CODEC_UNPACK_CODE(w, i) \
+    codes[i] = (uint16_t)((CodecLoad32(src + (i) * (w) / 8) >> ((i) * (w) % 8)) & ((1u << (w)) - 1));
+
+#define CODEC_BLOCK_CODERS(w) \
+    static void CodecPackBlock##w(const uint16_t* codes, uint8_t* dst) { \
+        uint64_t acc = 0; \
+        CODEC_EACH_CODE(CODEC_PACK_CODE, w) \
+        if ((16 * (w)) % 32) { \
+            dst[16 * (w) / 32 * 4] = (uint8_t)acc; \
+            dst[16 * (w) / 32 * 4 + 1] = (uint8_t)(acc >> 8); \
+        } \
+    } \
+    static void CodecUnpackBlock##w(const uint8_t* src, uint16_t* codes) { \
+        CODEC_EACH_CODE(CODEC_UNPACK_CODE, w) \
+    }
+
+CODEC_BLOCK_CODERS(1)
+CODEC_BLOCK_CODERS(2)
+CODEC_BLOCK_CODERS(3)
+CODEC_BLOCK_CODERS(4)
+CODEC_BLOCK_CODERS(5)
+CODEC_BLOCK_CODERS(6)
+CODEC_BLOCK_CODERS(7)
+CODEC_BLOCK_CODERS(8)
+CODEC_BLOCK_CODERS(9)
+CODEC_BLOCK_CODERS(10)
+CODEC_BLOCK_CODERS(11)
+CODEC_BLOCK_CODERS(12)
+CODEC_BLOCK_CODERS(13)
+CODEC_BLOCK_CODERS(14)
+CODEC_BLOCK_CODERS(15)
+CODEC_BLOCK_CODERS(16)
+
+typedef void (*CodecPackFn)(const uint16_t* codes, uint8_t* dst);
+typedef void (*CodecUnpackFn)(const uint8_t* src, uint16_t* codes);
+
+// Width 0 blocks take no bytes and never reach these tables
+static const CodecPackFn CODEC_PACKERS[17] = {
+    NULL, CodecPackBlock1, CodecPackBlock2, CodecPackBlock3, CodecPackBlock4, CodecPackBlock5,
+    CodecPackBlock6, CodecPackBlock7, CodecPackBlock8, CodecPackBlock9, CodecPackBlock10,
+    CodecPackBlock11, CodecPackBlock12, CodecPackBlock13, CodecPackBlock14, CodecPackBlock15,
+    CodecPackBlock16
+};
+
+static const CodecUnpackFn CODEC_UNPACKERS[17] = {
+    NULL, CodecUnpackBlock1, CodecUnpackBlock2, CodecUnpackBlock3, CodecUnpackBlock4, CodecUnpackBlock5,
+    CodecUnpackBlock6, CodecUnpackBlock7, CodecUnpackBlock8, CodecUnpackBlock9, CodecUnpackBlock10,
+    CodecUnpackBlock11, CodecUnpackBlock12, CodecUnpackBlock13, CodecUnpackBlock14, CodecUnpackBlock15,
+    CodecUnpackBlock16
+};
+
+// Each code is read as four bytes, up to three past the block, so one near
+// the end of the input goes through a padded copy
+static bool CodecUnpackBlock(const uint8_t** src, const uint8_t* end, int width, uint16_t* block) {
+    size_t bytes = 2 * (size_t)width;
+    if ((size_t)(end - *src) < bytes) return false;
+    
+    if ((size_t)(end - *src) >= bytes + 3) {
+        CODEC_UNPACKERS[width](*src, block);
+    } else {
+        uint8_t padded[2 * 16 + 3] = {0};
+        memcpy(padded, *src, bytes);
+        CODEC_UNPACKERS[width](padded, block);
+    }
+    *src += bytes;
+    return true;
+}
+
+// Frames outside the default geometry: every block of 16 codes at the
+// frame's depth, the last one padded with zeros
+static size_t CodecPackBits(const RawFrame* frame, uint8_t* out) {
+    int count = frame->samples * 3;
+    int width = frame->bits;
+    uint8_t* dst = out;
+    
+    for (int i = 0; i < count; i += CODEC_BLOCK) {
+        uint16_t padded[CODEC_BLOCK] = {0};
+        const uint16_t* block = frame->values + i;
+        if (count - i < CODEC_BLOCK) {
+            memcpy(padded, block, sizeof(uint16_t) * (count - i));
+            block = padded;
+        }
+        CODEC_PACKERS[width](block, dst);
+        dst += 2 * width;
+    }
+    return (size_t)(dst - out);
+}
+
+static bool CodecUnpackBits(const uint8_t* in, size_t len, RawFrame* frame) {
+    int count = frame->samples * 3;
+    const uint8_t* end = in + len;
+    
+    for (int i = 0; i < count; i += CODEC_BLOCK) {
+        uint16_t block[CODEC_BLOCK];
+        if (!CodecUnpackBlock(&in, end, frame->bits, block)) return false;
+        int n = count - i < CODEC_BLOCK ? count - i : CODEC_BLOCK;
+        memcpy(frame->values + i, block, sizeof(uint16_t) * n);
+    }
+    return true;
+}
+
+// Block widths are nibbles: 0 to 14 as is, 15 for 16 bits. Only frames
+// deeper than 13 bits ever need more than 13.
+static size_t CodecEncodeDelta(const RawFrame* frame, uint8_t* out) {
+    int count = frame->samples * 3;
+    int blocks = (count + CODEC_BLOCK - 1) / CODEC_BLOCK;
+    
+    uint16_t codes[CODEC_MAX_BLOCKS * CODEC_BLOCK];
+    CodecDeltaZigzag(frame->values, count, frame->origin, codes);
+    memset(codes + count, 0, sizeof(uint16_t) * (blocks * CODEC_BLOCK - count));
+    
+    uint8_t* widths = out;
+    uint8_t* dst = out + (blocks + 1) / 2;
+    memset(widths, 0, (blocks + 1) / 2);
+    
+    for (int b = 0; b < blocks; b++) {
+        const uint16_t* block = codes + b * CODEC_BLOCK;
+        int width = CodecBlockWidth(block, CODEC_BLOCK);
+        if (width == 15) width = 16;
+        widths[b / 2] |= (uint8_t)((width == 16 ? 15 : width) << ((b & 1) * 4));
+        
+        if (width == 0) continue;
+        CODEC_PACKERS[width](block, dst);
+        dst += 2 * width;
+    }
+    return (size_t)(dst - out);
+}
+
+// Zigzag back to differences, then a running sum per channel. Within eight
+// lanes that is a sum at lags 3 and 6; the last triple of each vector carries
+// into the next in lane order 5 6 7 5 6 7 5 6.
+static bool CodecUndoDelta(const uint16_t* codes, RawFrame* frame) {
+    uint16_t* values = frame->values;
+    int count = frame->samples * 3;
+    int i = 0;
+    uint16_t overflow = 0;
+    uint16_t prev[3] = {(uint16_t)frame->origin, (uint16_t)frame->origin, (uint16_t)frame->origin};
+    
+#ifdef CODEC_SSE2
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i carry = _mm_set1_epi16((short)frame->origin);
+    __m128i bits = _mm_setzero_si128();
+    
+    for (; i + 8 <= count; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(codes + i));
+        __m128i d = _mm_xor_si128(_mm_srli_epi16(c, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(c, one)));
+        d = _mm_add_epi16(d, _mm_slli_si128(d, 6));
+        d = _mm_add_epi16(d, _mm_slli_si128(d, 12));
+        __m128i v = _mm_add_epi16(d, carry);
+        _mm_storeu_si128((__m128i*)(values + i), v);
+        bits = _mm_or_si128(bits, v);
+        
+        __m128i last = _mm_srli_si128(v, 10);
+        carry = _mm_or_si128(_mm_or_si128(last, _mm_slli_si128(last, 6)), _mm_slli_si128(last, 12));
+    }
+    
+    bits = _mm_or_si128(bits, _mm_srli_si128(bits, 8));
+    bits = _mm_or_si128(bits, _mm_srli_si128(bits, 4));
+    bits = _mm_or_si128(bits, _mm_srli_si128(bits, 2));
+    overflow = (uint16_t)_mm_cvtsi128_si32(bits);
+    if (i > 0) {
+        prev[i % 3] = values[i - 3];
+        prev[(i + 1) % 3] = values[i - 2];
+        prev[(i + 2) % 3] = values[i - 1];
+    }
+#endif
+    
+    for (; i < count; i++) {
+        uint16_t* p = &prev[i % 3];
+        *p = (uint16_t)(*p + (uint16_t)((codes[i] >> 1) ^ -(codes[i] & 1)));
+        values[i] = *p;
+        overflow |= *p;
+    }
+    
+    // The range is checked once at the end; at 16 bits there is nothing above it
+    return (overflow & ~FrameCodeMax(frame->bits)) == 0;
+}
+
+static bool CodecDecodeDelta(const uint8_t* in, size_t len, RawFrame* frame) {
+    int count = frame->samples * 3;
+    int blocks = (count + CODEC_BLOCK - 1) / CODEC_BLOCK;
+    int max_width = frame->bits < 15 ? frame->bits + 1 : 16;
+    
+    const uint8_t* widths = in;
+    const uint8_t* src = in + (blocks + 1) / 2;
+    const uint8_t* end = in + len;
+    if (src > end) return false;
+    
+    uint16_t codes[CODEC_MAX_BLOCKS * CODEC_BLOCK];
+    
+    for (int b = 0; b < blocks; b++) {
+        uint16_t* block = codes + b * CODEC_BLOCK;
+        int width = (widths[b / 2] >> ((b & 1) * 4)) & 0x0F;
+        if (width == 15) width = 16;
+        if (width == 0) {
+            memset(block, 0, sizeof(uint16_t) * CODEC_BLOCK);
+            continue;
+        }
+        if (width > max_width || !CodecUnpackBlock(&src, end, width, block)) return false;
+    }
+    
+    return CodecUndoDelta(codes, frame);
+}
+
+static bool CodecDefaultGeometry(const RawFrame* frame) {
+    return frame->samples == FRAME_SAMPLES && frame->bits == 12 && frame->origin == FRAME_ORIGIN;
+}
+
+size_t CodecMaxBytes(int samples) {
+    size_t blocks = samples > 0 ? ((size_t)samples * 3 + CODEC_BLOCK - 1) / CODEC_BLOCK : 0;
+    return 1 + CODEC_GEOMETRY_BYTES + (blocks + 1) / 2 + blocks * CODEC_BLOCK * 2 + 8;
+}
+
+size_t CodecEncode(const RawFrame* frame, CodecMode mode, uint8_t* out, size_t capacity) {
+    if (capacity < CodecMaxBytes(frame->samples)) return 0;
+    
+    if (CodecDefaultGeometry(frame)) {
+        out[0] = (uint8_t)mode;
+        if (mode == CODEC_DELTA) {
+            return 1 + CodecEncodeDelta(frame, out + 1);
+        }
+        return 1 + CodecPack12(frame->values, out + 1);
+    }
+    
+    FrameGeometry geometry = {frame->samples, 3, frame->bits, frame->origin};
+    if (!FrameGeometryValid(&geometry)) return 0;
+    
+    out[0] = (uint8_t)(mode | CODEC_GEOMETRY);
+    out[1] = (uint8_t)frame->samples;
+    out[2] = (uint8_t)(frame->samples >> 8);
+    out[3] = (uint8_t)frame->bits;
+    out[4] = (uint8_t)frame->origin;
+    out[5] = (uint8_t)(frame->origin >> 8);
+    
+    uint8_t* body = out + 1 + CODEC_GEOMETRY_BYTES;
+    if (mode == CODEC_DELTA) {
+        return 1 + CODEC_GEOMETRY_BYTES + CodecEncodeDelta(frame, body);
+    }
+    return 1 + CODEC_GEOMETRY_BYTES + CodecPackBits(frame, body);
+}
+
+bool CodecDecode(const uint8_t* in, size_t len, RawFrame* frame) {
+    if (len < 1) return false;
+    
+    int mode = in[0] & ~CODEC_GEOMETRY;
+    if (mode != CODEC_PACKED && mode != CODEC_DELTA) return false;
+    
+    if (!(in[0] & CODEC_GEOMETRY)) {
+        frame->samples = FRAME_SAMPLES;
+        frame->bits = 12;
+        frame->origin = FRAME_ORIGIN;
+        
+        if (mode == CODEC_PACKED) {
+            if (len - 1 < CODEC_PACKED12_BYTES) return false;
+            CodecUnpack12(in + 1, frame->values);
+            return true;
+        }
+        return CodecDecodeDelta(in + 1, len - 1, frame);
+    }
+    
+    if (len - 1 < CODEC_GEOMETRY_BYTES) return false;
+    FrameGeometry geometry = {in[1] | (in[2] << 8), 3, in[3], in[4] | (in[5] << 8)};
+    if (!FrameGeometryValid(&geometry)) return false;
+    
+    frame->samples = geometry.samples;
+    frame->bits = geometry.bits;
+    frame->origin = geometry.origin;
+    
+    const uint8_t* body = in + 1 + CODEC_GEOMETRY_BYTES;
+    size_t body_len = len - 1 - CODEC_GEOMETRY_BYTES;
+    if (mode == CODEC_PACKED) return CodecUnpackBits(body, body_len, frame);
+    return CodecDecodeDelta(body, body_len, frame);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include "frame.h"
+
+// Encoded frames start with a one byte mode tag. A frame in the default
+// geometry (FRAME_SAMPLES points of 12 bits around FRAME_ORIGIN) follows it
+// directly; any other has CODEC_GEOMETRY set in the tag, followed by u16
+// samples, u8 bits and u16 origin, little endian.
+typedef enum {
+    CODEC_PACKED = 0,       // Raw codes bit packed at the frame's depth
+    CODEC_DELTA = 1         // Per-channel delta, zigzag, then per-block bit packing
+} CodecMode;
+
+#define CODEC_GEOMETRY 0x80
+#define CODEC_GEOMETRY_BYTES 5
+
+#define CODEC_BLOCK 16
+#define CODEC_BLOCKS (FRAME_VALUES / CODEC_BLOCK)     // A default frame is a whole number of blocks
+#define CODEC_MAX_BLOCKS ((FRAME_MAX_VALUES + CODEC_BLOCK - 1) / CODEC_BLOCK)
+#define CODEC_PACKED12_BYTES (FRAME_VALUES * 3 / 2)
+
+// Worst case: a tag and geometry, block widths as nibbles, 16-bit codes, word slack
+#define CODEC_MAX_BYTES (1 + CODEC_GEOMETRY_BYTES + (CODEC_MAX_BLOCKS + 1) / 2 + CODEC_MAX_BLOCKS * CODEC_BLOCK * 2 + 8)
+
+// The same worst case for a frame of samples triples; buffers kept per frame
+// of a known geometry need only this much
+size_t CodecMaxBytes(int samples);
+
+// Needs CodecMaxBytes(frame->samples) of capacity, returns 0 otherwise
+size_t CodecEncode(const RawFrame* frame, CodecMode mode, uint8_t* out, size_t capacity);
+bool CodecDecode(const uint8_t* in, size_t len, RawFrame* frame);
+
+#endif
\ No newline at end of file
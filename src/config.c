@@ -1,4 +1,5 @@
 #include "config.h"
+#include "frame.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -36,6 +37,37 @@ void ConfigSetDefaults(Config* config) {
     config->window_width = 1080;
     config->window_height = 1080;
     
+    config->baud_rate = 115200;
+    config->low_latency = false;
+    
+    config->frame_samples = FRAME_SAMPLES;
+    config->frame_channels = 3;
+    config->frame_bits = 12;
+    config->frame_origin = FRAME_ORIGIN;
+    
+    config->realtime = false;
+    config->realtime_cpu = -1;
+    config->realtime_priority = 20;
+    
+    config->diff_window = 16;
+    config->diff_rms_alarm = 40.0f;
+    config->diff_max_alarm = 120.0f;
+    config->diff_alarm_sound = true;
+    
+    config->shm_ring = false;
+    config->control_socket[0] = '\0';
+    config->smooth_traces = false;
+    config->test_plan[0] = '\0';
+    strcpy(config->export_format, "csv");
+    config->export_samples = false;
+    config->export_rotate_mb = 100;
+    config->export_rotate_minutes = 60;
+    
+    config->trigger_max_dev = 60;
+    config->trigger_mean_dev = 15.0f;
+    config->trigger_pre = 32;
+    config->trigger_post = 32;
+    
     ConfigSetDarkMode(config);
     
     strcpy(config->keybinds[0], "P");
@@ -48,6 +80,12 @@ void ConfigSetDefaults(Config* config) {
     strcpy(config->keybinds[7], "ESC");
 }
 
+// A value too long for its field is ignored; cut short, a path would name another file
+static void ConfigSetString(char* field, size_t size, const char* value) {
+    size_t len = strlen(value);
+    if (len < size) memcpy(field, value, len + 1);
+}
+
 void ConfigLoad(Config* config, const char* filename) {
     ConfigSetDefaults(config);
     
@@ -64,6 +102,56 @@ void ConfigLoad(Config* config, const char* filename) {
                 config->window_width = atoi(value);
             } else if (strcmp(key, "window_height") == 0) {
                 config->window_height = atoi(value);
+            } else if (strcmp(key, "baud_rate") == 0) {
+                config->baud_rate = atoi(value);
+            } else if (strcmp(key, "low_latency") == 0) {
+                config->low_latency = atoi(value) != 0;
+            } else if (strcmp(key, "frame_samples") == 0) {
+                config->frame_samples = atoi(value);
+            } else if (strcmp(key, "frame_channels") == 0) {
+                config->frame_channels = atoi(value);
+            } else if (strcmp(key, "frame_bits") == 0) {
+                config->frame_bits = atoi(value);
+            } else if (strcmp(key, "frame_origin") == 0) {
+                config->frame_origin = atoi(value);
+            } else if (strcmp(key, "realtime") == 0) {
+                config->realtime = atoi(value) != 0;
+            } else if (strcmp(key, "realtime_cpu") == 0) {
+                config->realtime_cpu = atoi(value);
+            } else if (strcmp(key, "realtime_priority") == 0) {
+                config->realtime_priority = atoi(value);
+            } else if (strcmp(key, "diff_window") == 0) {
+                config->diff_window = atoi(value);
+            } else if (strcmp(key, "diff_rms_alarm") == 0) {
+                config->diff_rms_alarm = (float)atof(value);
+            } else if (strcmp(key, "diff_max_alarm") == 0) {
+                config->diff_max_alarm = (float)atof(value);
+            } else if (strcmp(key, "diff_alarm_sound") == 0) {
+                config->diff_alarm_sound = atoi(value) != 0;
+            } else if (strcmp(key, "shm_ring") == 0) {
+                config->shm_ring = atoi(value) != 0;
+            } else if (strcmp(key, "trigger_max_dev") == 0) {
+                config->trigger_max_dev = atoi(value);
+            } else if (strcmp(key, "trigger_mean_dev") == 0) {
+                config->trigger_mean_dev = (float)atof(value);
+            } else if (strcmp(key, "trigger_pre") == 0) {
+                config->trigger_pre = atoi(value);
+            } else if (strcmp(key, "trigger_post") == 0) {
+                config->trigger_post = atoi(value);
+            } else if (strcmp(key, "control_socket") == 0) {
+                ConfigSetString(config->control_socket, sizeof(config->control_socket), value);
+            } else if (strcmp(key, "smooth_traces") == 0) {
+                config->smooth_traces = atoi(value) != 0;
+            } else if (strcmp(key, "test_plan") == 0) {
+                ConfigSetString(config->test_plan, sizeof(config->test_plan), value);
+            } else if (strcmp(key, "export_format") == 0) {
+                ConfigSetString(config->export_format, sizeof(config->export_format), value);
+            } else if (strcmp(key, "export_samples") == 0) {
+                config->export_samples = atoi(value) != 0;
+            } else if (strcmp(key, "export_rotate_mb") == 0) {
+                config->export_rotate_mb = atoi(value);
+            } else if (strcmp(key, "export_rotate_minutes") == 0) {
+                config->export_rotate_minutes = atoi(value);
             } else if (strcmp(key, "bg_color") == 0) {
                 sscanf(value, "%hhu,%hhu,%hhu", &config->bg_color.r, &config->bg_color.g, &config->bg_color.b);
             } else if (strcmp(key, "dut1_trace") == 0) {
@@ -105,6 +193,31 @@ void ConfigSave(const Config* config, const char* filename) {
     fprintf(f, "serial_port=%s\n", config->serial_port);
     fprintf(f, "window_width=%d\n", config->window_width);
     fprintf(f, "window_height=%d\n", config->window_height);
+    fprintf(f, "baud_rate=%d\n", config->baud_rate);
+    fprintf(f, "low_latency=%d\n", config->low_latency ? 1 : 0);
+    fprintf(f, "frame_samples=%d\n", config->frame_samples);
+    fprintf(f, "frame_channels=%d\n", config->frame_channels);
+    fprintf(f, "frame_bits=%d\n", config->frame_bits);
+    fprintf(f, "frame_origin=%d\n", config->frame_origin);
+    fprintf(f, "realtime=%d\n", config->realtime ? 1 : 0);
+    fprintf(f, "realtime_cpu=%d\n", config->realtime_cpu);
+    fprintf(f, "realtime_priority=%d\n", config->realtime_priority);
+    fprintf(f, "diff_window=%d\n", config->diff_window);
+    fprintf(f, "diff_rms_alarm=%g\n", config->diff_rms_alarm);
+    fprintf(f, "diff_max_alarm=%g\n", config->diff_max_alarm);
+    fprintf(f, "diff_alarm_sound=%d\n", config->diff_alarm_sound ? 1 : 0);
+    fprintf(f, "shm_ring=%d\n", config->shm_ring ? 1 : 0);
+    fprintf(f, "trigger_max_dev=%d\n", config->trigger_max_dev);
+    fprintf(f, "trigger_mean_dev=%g\n", config->trigger_mean_dev);
+    fprintf(f, "trigger_pre=%d\n", config->trigger_pre);
+    fprintf(f, "trigger_post=%d\n", config->trigger_post);
+    fprintf(f, "control_socket=%s\n", config->control_socket);
+    fprintf(f, "smooth_traces=%d\n", config->smooth_traces ? 1 : 0);
+    fprintf(f, "test_plan=%s\n", config->test_plan);
+    fprintf(f, "export_format=%s\n", config->export_format);
+    fprintf(f, "export_samples=%d\n", config->export_samples ? 1 : 0);
+    fprintf(f, "export_rotate_mb=%d\n", config->export_rotate_mb);
+    fprintf(f, "export_rotate_minutes=%d\n", config->export_rotate_minutes);
     
     fprintf(f, "bg_color=%d,%d,%d\n", config->bg_color.r, config->bg_color.g, config->bg_color.b);
     fprintf(f, "dut1_trace=%d,%d,%d\n", config->dut1_trace.r, config->dut1_trace.g, config->dut1_trace.b);
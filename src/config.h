@@ -9,6 +9,43 @@ typedef struct {
     int window_width;
     int window_height;
     
+    int baud_rate;
+    bool low_latency;       // Opt-in low latency serial transport
+    
+    // Frame layout the firmware sends, see FrameGeometry
+    int frame_samples;
+    int frame_channels;
+    int frame_bits;
+    int frame_origin;
+    
+    // Opt-in real-time acquisition: pinned core (-1 = last), SCHED_FIFO priority
+    bool realtime;
+    int realtime_cpu;
+    int realtime_priority;
+    
+    // DUT1 - DUT2 mismatch alarm, thresholds in ADC counts
+    int diff_window;
+    float diff_rms_alarm;
+    float diff_max_alarm;
+    bool diff_alarm_sound;
+    
+    bool shm_ring;          // Publish frames to shared memory for other processes
+    // Change trigger, deviations in ADC counts against the last stable frame
+    int trigger_max_dev;
+    float trigger_mean_dev;
+    int trigger_pre;
+    int trigger_post;
+    
+    char control_socket[108];   // Unix-domain control socket path, empty = disabled
+    bool smooth_traces;     // Spline interpolation between samples when zoomed in
+    char test_plan[256];    // Test-point sequencer plan, empty = none
+    
+    // Live text export: csv or jsonl, files rotate at whichever limit comes first (0 = none)
+    char export_format[8];
+    bool export_samples;    // Raw sweeps as well as metrics
+    int export_rotate_mb;
+    int export_rotate_minutes;
+    
     Color bg_color;
     Color dut1_trace;
     Color dut2_trace;
@@ -0,0 +1,444 @@
+#include "control.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+
+static void ControlPut32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static void ControlPut64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static ControlQueued* ControlQueuedAt(uint8_t* entries, size_t size, int index) {
+    return (ControlQueued*)(entries + (size_t)index * size);
+}
+
+void ControlServerPublish(ControlServer* server, const RawFrame* frame, uint64_t sequence,
+                          uint64_t timestamp_us, int excitation, const MetricsResult metrics[2]) {
+    if (!server->running || frame->samples > server->samples) return;
+    
+    MutexLock(&server->lock);
+    
+    // A full queue means the loop is behind; the oldest frame goes first
+    int slot = (server->queue_head + server->queue_count) % CONTROL_QUEUE;
+    if (server->queue_count == CONTROL_QUEUE) {
+        server->queue_head = (server->queue_head + 1) % CONTROL_QUEUE;
+    } else {
+        server->queue_count++;
+    }
+    
+    ControlQueued* q = ControlQueuedAt(server->queue, server->queued_size, slot);
+    q->sequence = sequence;
+    q->timestamp_us = timestamp_us;
+    q->excitation = (uint32_t)excitation;
+    q->payload_len = (uint32_t)CodecEncode(frame, CODEC_DELTA, q->payload,
+                                           server->queued_size - sizeof(ControlQueued));
+    q->metrics[0] = metrics[0];
+    q->metrics[1] = metrics[1];
+    
+    MutexUnlock(&server->lock);
+    
+#ifndef _WIN32
+    char wake = 1;
+    if (write(server->wake_fds[1], &wake, 1) < 0) {
+        // Pipe already full, the loop is awake anyway
+    }
+#endif
+}
+
+void ControlServerSetStatus(ControlServer* server, const ControlStatus* status) {
+    if (!server->running) return;
+    
+    MutexLock(&server->lock);
+    server->status = *status;
+    MutexUnlock(&server->lock);
+}
+
+bool ControlServerPollCommand(ControlServer* server, ControlCommand* command) {
+    if (!server->running) return false;
+    
+    bool found = false;
+    MutexLock(&server->lock);
+    if (server->command_count > 0) {
+        *command = server->commands[0];
+        server->command_count--;
+        memmove(server->commands, server->commands + 1, sizeof(ControlCommand) * server->command_count);
+        found = true;
+    }
+    MutexUnlock(&server->lock);
+    return found;
+}
+
+#ifdef _WIN32
+
+// Unix-domain sockets in Winsock need a separate code path; not supported yet
+bool ControlServerStart(ControlServer* server, const char* path, const FrameGeometry* geometry) {
+    (void)path;
+    (void)geometry;
+    memset(server, 0, sizeof(*server));
+    return false;
+}
+
+void ControlServerStop(ControlServer* server) {
+    (void)server;
+}
+
+#else
+
+static bool ControlQueue(ControlClient* client, const void* data, size_t len) {
+    if (client->out_len + len > CONTROL_OUT_BUFFER) return false;
+    memcpy(client->out + client->out_len, data, len);
+    client->out_len += len;
+    return true;
+}
+
+static void ControlReply(ControlClient* client, const char* text) {
+    // Control replies are small; if even these don't fit, the client is gone
+    ControlQueue(client, text, strlen(text));
+}
+
+static void ControlCloseClient(ControlClient* client) {
+    close(client->fd);
+    free(client->out);
+    memset(client, 0, sizeof(*client));
+    client->fd = -1;
+}
+
+static void ControlPushCommand(ControlServer* server, ControlClient* client, ControlCommandType type, int value) {
+    bool queued = false;
+    
+    MutexLock(&server->lock);
+    if (server->command_count < CONTROL_MAX_COMMANDS) {
+        server->commands[server->command_count].type = type;
+        server->commands[server->command_count].value = value;
+        server->command_count++;
+        queued = true;
+    }
+    MutexUnlock(&server->lock);
+    
+    ControlReply(client, queued ? "OK\n" : "ERR busy\n");
+}
+
+static void ControlHandleLine(ControlServer* server, ControlClient* client, char* line) {
+    char cmd[32] = {0}, arg[32] = {0};
+    if (sscanf(line, "%31s %31s", cmd, arg) < 1) return;
+    
+    if (strcmp(cmd, "mode") == 0) {
+        if (strcmp(arg, "T") == 0) ControlPushCommand(server, client, CONTROL_SET_MODE, 0);
+        else if (strcmp(arg, "W") == 0) ControlPushCommand(server, client, CONTROL_SET_MODE, 1);
+        else if (strcmp(arg, "ALT") == 0) ControlPushCommand(server, client, CONTROL_SET_MODE, 2);
+        else ControlReply(client, "ERR mode must be T, W or ALT\n");
+    } else if (strcmp(cmd, "pause") == 0) {
+        ControlPushCommand(server, client, CONTROL_PAUSE, 0);
+    } else if (strcmp(cmd, "resume") == 0) {
+        ControlPushCommand(server, client, CONTROL_RESUME, 0);
+    } else if (strcmp(cmd, "capture") == 0) {
+        if (strcmp(arg, "start") == 0) ControlPushCommand(server, client, CONTROL_CAPTURE_START, 0);
+        else if (strcmp(arg, "stop") == 0) ControlPushCommand(server, client, CONTROL_CAPTURE_STOP, 0);
+        else ControlReply(client, "ERR capture start|stop\n");
+    } else if (strcmp(cmd, "subscribe") == 0 || strcmp(cmd, "unsubscribe") == 0) {
+        if (strcmp(arg, "metrics") == 0) {
+            client->metrics = cmd[0] == 's';
+            ControlReply(client, "OK\n");
+        } else {
+            ControlReply(client, "ERR only metrics can be subscribed here, frames stream on <path>.frames\n");
+        }
+    } else if (strcmp(cmd, "status") == 0) {
+        const char* modes[] = {"T", "W", "ALT"};
+        MutexLock(&server->lock);
+        ControlStatus st = server->status;
+        MutexUnlock(&server->lock);
+        
+        char reply[128];
+        snprintf(reply, sizeof(reply), "OK mode=%s paused=%d recording=%d frames=%u\n",
+                 modes[st.mode % 3], st.paused, st.recording, st.frames);
+        ControlReply(client, reply);
+    } else if (strcmp(cmd, "help") == 0) {
+        ControlReply(client, "OK mode T|W|ALT, pause, resume, capture start|stop, status, "
+                             "subscribe metrics, unsubscribe metrics\n");
+    } else {
+        ControlReply(client, "ERR unknown command\n");
+    }
+}
+
+static void ControlReadClient(ControlServer* server, ControlClient* client) {
+    ssize_t n = read(client->fd, client->in + client->in_len, sizeof(client->in) - 1 - client->in_len);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        ControlCloseClient(client);
+        return;
+    }
+    
+    // The frame stream is one way, anything sent on it is ignored
+    if (client->frame_stream) return;
+    
+    client->in_len += (size_t)n;
+    client->in[client->in_len] = '\0';
+    
+    char* start = client->in;
+    char* newline;
+    while ((newline = strchr(start, '\n')) != NULL) {
+        *newline = '\0';
+        ControlHandleLine(server, client, start);
+        start = newline + 1;
+    }
+    
+    client->in_len -= (size_t)(start - client->in);
+    memmove(client->in, start, client->in_len);
+    
+    if (client->in_len == sizeof(client->in) - 1) {
+        ControlReply(client, "ERR line too long\n");
+        client->in_len = 0;
+    }
+}
+
+static void ControlWriteClient(ControlClient* client) {
+    ssize_t n = send(client->fd, client->out, client->out_len, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EINTR) ControlCloseClient(client);
+        return;
+    }
+    
+    client->out_len -= (size_t)n;
+    memmove(client->out, client->out + n, client->out_len);
+}
+
+static void ControlAccept(ControlServer* server, int listen_fd, bool frame_stream) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd == -1) return;
+    
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        ControlClient* client = &server->clients[i];
+        if (client->fd != -1) continue;
+        
+        client->out = malloc(CONTROL_OUT_BUFFER);
+        if (!client->out) break;
+        
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        client->fd = fd;
+        client->frame_stream = frame_stream;
+        return;
+    }
+    
+    close(fd);
+}
+
+// Append whole messages only. A client without room for the next frame loses
+// it, so one stalled reader costs nothing but its own frames.
+static void ControlDeliver(ControlServer* server, const ControlQueued* q) {
+    uint8_t header[32];
+    ControlPut32(header, CONTROL_FRAME_MAGIC);
+    ControlPut32(header + 4, q->payload_len);
+    ControlPut64(header + 8, q->sequence);
+    ControlPut64(header + 16, q->timestamp_us);
+    ControlPut32(header + 24, q->excitation);
+    
+    char lines[512];
+    int lines_len = 0;
+    for (int c = 0; c < 2; c++) {
+        const MetricsResult* m = &q->metrics[c];
+        lines_len += snprintf(lines + lines_len, sizeof(lines) - lines_len,
+                              "METRICS %llu %u %d %g %g %g %g %g %g %g %d\n",
+                              (unsigned long long)q->sequence, q->excitation, c,
+                              m->r_small, m->v_knee, m->i_leak, m->v_zero, m->i_zero,
+                              m->noise, m->loop_area, m->clipped);
+    }
+    
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        ControlClient* client = &server->clients[i];
+        if (client->fd == -1) continue;
+        
+        if (client->frame_stream) {
+            if (client->out_len + sizeof(header) + q->payload_len > CONTROL_OUT_BUFFER) {
+                client->dropped++;
+                continue;
+            }
+            ControlPut32(header + 28, client->dropped);
+            ControlQueue(client, header, sizeof(header));
+            ControlQueue(client, q->payload, q->payload_len);
+        } else if (client->metrics) {
+            ControlQueue(client, lines, (size_t)lines_len);
+        }
+    }
+}
+
+static void ControlLoop(void* arg) {
+    ControlServer* server = arg;
+    struct pollfd fds[3 + CONTROL_MAX_CLIENTS];
+    uint8_t* batch = malloc(server->queued_size * CONTROL_QUEUE);
+    if (!batch) return;
+#ifdef CURVEBUG_ALLOC_CHECK
+    uint64_t delivered = 0;
+#endif
+    
+    while (server->running) {
+        fds[0] = (struct pollfd){server->wake_fds[0], POLLIN, 0};
+        fds[1] = (struct pollfd){server->listen_fd, POLLIN, 0};
+        fds[2] = (struct pollfd){server->frames_listen_fd, POLLIN, 0};
+        for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+            ControlClient* client = &server->clients[i];
+            fds[3 + i].fd = client->fd;
+            fds[3 + i].events = POLLIN | (client->out_len > 0 ? POLLOUT : 0);
+            fds[3 + i].revents = 0;
+        }
+        
+        if (poll(fds, 3 + CONTROL_MAX_CLIENTS, 500) < 0) continue;
+        
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(server->wake_fds[0], drain, sizeof(drain)) > 0) {}
+            
+            MutexLock(&server->lock);
+            int count = server->queue_count;
+            for (int i = 0; i < count; i++) {
+                const ControlQueued* q = ControlQueuedAt(server->queue, server->queued_size,
+                                                         (server->queue_head + i) % CONTROL_QUEUE);
+                memcpy(batch + (size_t)i * server->queued_size, q, sizeof(ControlQueued) + q->payload_len);
+            }
+            server->queue_head = (server->queue_head + count) % CONTROL_QUEUE;
+            server->queue_count = 0;
+            MutexUnlock(&server->lock);
+            
+            // Everything queued since the last wakeup goes out in one send per client
+            for (int i = 0; i < count; i++) {
+#ifdef CURVEBUG_ALLOC_CHECK
+                if (delivered++ == CONTROL_ALLOC_WARMUP) AllocCheckBegin();
+#endif
+                ControlDeliver(server, ControlQueuedAt(batch, server->queued_size, i));
+            }
+        }
+        
+        if (fds[1].revents & POLLIN) ControlAccept(server, server->listen_fd, false);
+        if (fds[2].revents & POLLIN) ControlAccept(server, server->frames_listen_fd, true);
+        
+        for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+            ControlClient* client = &server->clients[i];
+            if (client->fd == -1 || fds[3 + i].fd != client->fd) continue;
+            
+            if (fds[3 + i].revents & (POLLIN | POLLHUP | POLLERR)) ControlReadClient(server, client);
+            if (client->fd != -1 && client->out_len > 0) ControlWriteClient(client);
+        }
+    }
+    
+#ifdef CURVEBUG_ALLOC_CHECK
+    AllocCheckEnd(&server->allocs);
+#endif
+    free(batch);
+}
+
+static int ControlListen(const char* path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+    
+    // A stale socket file from a previous run would make bind fail
+    unlink(path);
+    
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Closes whatever Start managed to open, removes the socket files it bound
+// and frees the queue
+static void ControlRelease(ControlServer* server) {
+    if (server->listen_fd != -1) {
+        close(server->listen_fd);
+        unlink(server->path);
+    }
+    if (server->frames_listen_fd != -1) {
+        close(server->frames_listen_fd);
+        unlink(server->frames_path);
+    }
+    for (int i = 0; i < 2; i++) {
+        if (server->wake_fds[i] != -1) close(server->wake_fds[i]);
+        server->wake_fds[i] = -1;
+    }
+    server->listen_fd = -1;
+    server->frames_listen_fd = -1;
+    free(server->queue);
+    server->queue = NULL;
+}
+
+bool ControlServerStart(ControlServer* server, const char* path, const FrameGeometry* geometry) {
+    memset(server, 0, sizeof(*server));
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+    server->listen_fd = -1;
+    server->frames_listen_fd = -1;
+    server->wake_fds[0] = -1;
+    server->wake_fds[1] = -1;
+    
+    // A truncated name would bind some other path
+    int length = snprintf(server->path, sizeof(server->path), "%s", path);
+    int frames_length = snprintf(server->frames_path, sizeof(server->frames_path), "%s.frames", path);
+    if (length >= (int)sizeof(server->path) || frames_length >= (int)sizeof(server->frames_path)) return false;
+    
+    server->samples = geometry->samples;
+    server->queued_size = (sizeof(ControlQueued) + CodecMaxBytes(geometry->samples) + 7) & ~(size_t)7;
+    server->queue = malloc(server->queued_size * CONTROL_QUEUE);
+    if (!server->queue) return false;
+    
+    server->listen_fd = ControlListen(server->path);
+    if (server->listen_fd != -1) server->frames_listen_fd = ControlListen(server->frames_path);
+    if (server->frames_listen_fd == -1 || pipe(server->wake_fds) != 0) {
+        ControlRelease(server);
+        return false;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        fcntl(server->wake_fds[i], F_SETFL, fcntl(server->wake_fds[i], F_GETFL) | O_NONBLOCK);
+    }
+    
+    MutexInit(&server->lock);
+    server->started = true;
+    server->running = true;
+    
+    if (!ThreadCreate(&server->thread, ControlLoop, server)) {
+        server->running = false;
+        ControlServerStop(server);
+        return false;
+    }
+    return true;
+}
+
+void ControlServerStop(ControlServer* server) {
+    if (!server->started) return;
+    
+    if (server->running) {
+        server->running = false;
+        char wake = 1;
+        if (write(server->wake_fds[1], &wake, 1) < 0) {
+            // Loop still exits on its poll timeout
+        }
+        ThreadJoin(&server->thread);
+    }
+    
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        if (server->clients[i].fd != -1) ControlCloseClient(&server->clients[i]);
+    }
+    
+    ControlRelease(server);
+    MutexDestroy(&server->lock);
+    server->started = false;
+}
+
+#endif
\ No newline at end of file
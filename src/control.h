@@ -0,0 +1,114 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "codec.h"
+#include "metrics.h"
+#include "sync.h"
+#ifdef CURVEBUG_ALLOC_CHECK
+    #include "alloccheck.h"
+#endif
+
+// Local control server on two Unix-domain sockets, run by its own event loop:
+//   <path>         line-based control: "mode T|W|ALT", "pause", "resume",
+//                  "capture start|stop", "status", "subscribe metrics",
+//                  "unsubscribe metrics", "help". Replies are "OK ..." or "ERR ...".
+//   <path>.frames  binary frame stream, one ControlFrameHeader + codec payload per
+//                  frame. Slow readers lose whole frames, never stall acquisition.
+#define CONTROL_MAX_CLIENTS 16
+#define CONTROL_QUEUE 16
+#define CONTROL_MAX_COMMANDS 32
+#define CONTROL_OUT_BUFFER (64 * 1024)
+#define CONTROL_FRAME_MAGIC 0x52464243u     // "CBFR"
+#define CONTROL_ALLOC_WARMUP 100            // Frames delivered before the thread's allocations count
+
+// Little endian on the wire, followed by payload_len bytes of CodecEncode output
+typedef struct {
+    uint32_t magic;
+    uint32_t payload_len;
+    uint64_t sequence;
+    uint64_t timestamp_us;
+    uint32_t excitation;
+    uint32_t dropped;           // Frames this client has missed so far
+} ControlFrameHeader;
+
+typedef enum {
+    CONTROL_SET_MODE,
+    CONTROL_PAUSE,
+    CONTROL_RESUME,
+    CONTROL_CAPTURE_START,
+    CONTROL_CAPTURE_STOP
+} ControlCommandType;
+
+typedef struct {
+    ControlCommandType type;
+    int value;
+} ControlCommand;
+
+typedef struct {
+    uint32_t frames;
+    int mode;
+    bool paused;
+    bool recording;
+} ControlStatus;
+
+// The payload comes last, with room for the worst case of the geometry
+typedef struct {
+    uint64_t sequence;
+    uint64_t timestamp_us;
+    uint32_t excitation;
+    uint32_t payload_len;
+    MetricsResult metrics[2];
+    uint8_t payload[];
+} ControlQueued;
+
+typedef struct {
+    int fd;
+    bool frame_stream;
+    bool metrics;
+    char in[512];
+    size_t in_len;
+    uint8_t* out;
+    size_t out_len;
+    uint32_t dropped;
+} ControlClient;
+
+typedef struct {
+    bool started;               // Sockets, pipe and lock are set up and Stop must undo them
+    volatile bool running;
+    char path[108];
+    char frames_path[108];
+    int listen_fd;
+    int frames_listen_fd;
+    int wake_fds[2];
+    Thread thread;
+    
+    ControlClient clients[CONTROL_MAX_CLIENTS];
+    
+    // Shared with the render thread. CONTROL_QUEUE entries of queued_size bytes,
+    // sized for the geometry at start; larger frames are not streamed.
+    Mutex lock;
+    uint8_t* queue;
+    size_t queued_size;
+    int samples;
+    int queue_head;
+    int queue_count;
+    ControlCommand commands[CONTROL_MAX_COMMANDS];
+    int command_count;
+    ControlStatus status;
+#ifdef CURVEBUG_ALLOC_CHECK
+    AllocCounts allocs;         // Control thread, final once ControlServerStop returns
+#endif
+} ControlServer;
+
+bool ControlServerStart(ControlServer* server, const char* path, const FrameGeometry* geometry);
+void ControlServerStop(ControlServer* server);
+
+void ControlServerPublish(ControlServer* server, const RawFrame* frame, uint64_t sequence,
+                          uint64_t timestamp_us, int excitation, const MetricsResult metrics[2]);
+void ControlServerSetStatus(ControlServer* server, const ControlStatus* status);
+bool ControlServerPollCommand(ControlServer* server, ControlCommand* command);
+
+#endif
\ No newline at end of file
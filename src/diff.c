@@ -0,0 +1,82 @@
+#include "diff.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DIFF_SSE2
+#endif
+
+void DiffCompute(const FrameSamples* samples, const DiffParams* params, DiffResult* result) {
+    int count = samples->count;
+    int max_dev = 0;
+    int i = 0;
+    
+#ifdef DIFF_SSE2
+    // FrameSamples arrays are 32 byte aligned. Samples are unsigned 16-bit, so
+    // |a - b| and the running max come from saturating subtractions, and the
+    // signed difference is taken in 32 bits.
+    __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_load_si128((const __m128i*)(samples->ch1 + i));
+        __m128i b = _mm_load_si128((const __m128i*)(samples->ch2 + i));
+        __m128i dev = _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+        vmax = _mm_add_epi16(_mm_subs_epu16(vmax, dev), dev);
+        
+        __m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero));
+        __m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero));
+        _mm_store_si128((__m128i*)(result->trace + i), lo);
+        _mm_store_si128((__m128i*)(result->trace + i + 4), hi);
+    }
+    __m128i shifted = _mm_srli_si128(vmax, 8);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    shifted = _mm_srli_si128(vmax, 4);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    shifted = _mm_srli_si128(vmax, 2);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    max_dev = _mm_cvtsi128_si32(vmax) & 0xFFFF;
+#endif
+    
+    for (; i < count; i++) {
+        int d = samples->ch1[i] - samples->ch2[i];
+        result->trace[i] = d;
+        if (d < 0) d = -d;
+        if (d > max_dev) max_dev = d;
+    }
+    
+    // Sliding window of squared differences; squares need 64-bit sums
+    int window = params->window;
+    if (window < 1) window = 1;
+    if (window > count) window = count;
+    
+    int64_t total = 0, window_sum = 0, worst = 0;
+    int worst_start = 0, max_index = 0;
+    
+    for (i = 0; i < count; i++) {
+        int d = result->trace[i];
+        int64_t sq = (int64_t)d * d;
+        total += sq;
+        window_sum += sq;
+        
+        if (i >= window) {
+            int old = result->trace[i - window];
+            window_sum -= (int64_t)old * old;
+        }
+        if (i >= window - 1 && window_sum > worst) {
+            worst = window_sum;
+            worst_start = i - window + 1;
+        }
+        if (d == max_dev || d == -max_dev) max_index = i;
+    }
+    
+    float scale = FrameCountScale(samples->bits);
+    result->count = count;
+    result->max_alarm = params->max_alarm * scale;
+    result->rms_alarm = params->rms_alarm * scale;
+    result->max_dev = max_dev;
+    result->max_index = max_index;
+    result->rms = count > 0 ? (float)sqrt((double)total / count) : 0;
+    result->window_rms = count > 0 ? (float)sqrt((double)worst / window) : 0;
+    result->window_start = worst_start;
+    result->alarm = result->window_rms > result->rms_alarm || max_dev > result->max_alarm;
+}
\ No newline at end of file
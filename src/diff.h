@@ -0,0 +1,29 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+#include "frame.h"
+
+// DUT1 minus DUT2 comparison. Thresholds are in 12-bit counts, scaled to the
+// depth of each frame; results are in the frame's own counts.
+typedef struct {
+    int window;             // Samples per RMS window along the sweep
+    float rms_alarm;        // Worst windowed RMS that raises the alarm
+    float max_alarm;        // Largest single sample deviation that raises the alarm
+} DiffParams;
+
+typedef struct {
+    FRAME_ALIGN int32_t trace[FRAME_MAX_SAMPLES];   // ch1 - ch2 per sample
+    int count;
+    float max_alarm;        // Thresholds as applied to this frame
+    float rms_alarm;
+    float rms;              // Over the whole sweep
+    float window_rms;       // Worst window
+    int window_start;
+    int max_dev;            // Largest |ch1 - ch2|
+    int max_index;
+    bool alarm;
+} DiffResult;
+
+void DiffCompute(const FrameSamples* samples, const DiffParams* params, DiffResult* result);
+
+#endif
\ No newline at end of file
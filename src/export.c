@@ -0,0 +1,216 @@
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void ExportTrace(RasterImage* image, const ChannelData* ch, Color color, Rectangle r,
+                        float x_min, float x_max, float y_min, float y_max) {
+    for (int i = 0; i < ch->count - 1; i++) {
+        float x1 = r.x + r.width - (ch->voltage[i] - x_min) / (x_max - x_min) * r.width;
+        float y1 = r.y + (ch->current[i] - y_min) / (y_max - y_min) * r.height;
+        float x2 = r.x + r.width - (ch->voltage[i + 1] - x_min) / (x_max - x_min) * r.width;
+        float y2 = r.y + (ch->current[i + 1] - y_min) / (y_max - y_min) * r.height;
+        RasterLine(image, x1, y1, x2, y2, 1.5f, color);
+    }
+}
+
+static void ExportViews(const ExportStyle* style, const FrameSamples* s, int excitation,
+                        ChannelData* ch1, ChannelData* ch2) {
+    if (style->calib && style->calib->valid) {
+        float ma_per_volt = style->calib->ma_per_volt[excitation];
+        ChannelViewCalibrated(ch1, s->drive, s->ch1, s->count, style->calib, ma_per_volt);
+        ChannelViewCalibrated(ch2, s->drive, s->ch2, s->count, style->calib, ma_per_volt);
+    } else {
+        ChannelViewFromSamples(ch1, s->drive, s->ch1, s->count);
+        ChannelViewFromSamples(ch2, s->drive, s->ch2, s->count);
+    }
+}
+
+void ExportRenderPlot(RasterImage* image, const ExportStyle* style, const ExportJob* job) {
+    const Config* config = &style->config;
+    Rectangle r = {90, 50, (float)(image->width - 120), (float)(image->height - 140)};
+    
+    RasterClear(image, config->bg_color);
+    RasterFillRect(image, r.x, r.y, r.width, r.height, config->grid_bg);
+    RasterText(image, job->title, (int)r.x, 8, 20, config->axis_color);
+    
+    // Framed for the frame in front
+    int e = job->excitation ? 1 : 0;
+    const FrameSamples* framed = &job->samples[job->has[e] ? e : 1 - e];
+    
+    PlotAxes axes;
+    if (style->calib && style->calib->valid) {
+        PlotAxesCalibrated(&axes, style->calib, framed->bits, framed->origin, job->excitation == 1);
+    } else {
+        PlotAxesRaw(&axes, framed->bits, framed->origin);
+    }
+    float x_min = axes.x_min, x_max = axes.x_max;
+    float y_min = axes.y_min, y_max = axes.y_max;
+    
+    // Pixel centres, so one pixel lines stay crisp like DrawLine
+    for (int i = 0; i <= 10; i++) {
+        float x = (float)(int)(r.x + (i * r.width) / 10.0f) + 0.5f;
+        float y = (float)(int)(r.y + (i * r.height) / 10.0f) + 0.5f;
+        RasterLine(image, x, r.y, x, r.y + r.height, 1.0f, config->grid_color);
+        RasterLine(image, r.x, y, r.x + r.width, y, 1.0f, config->grid_color);
+    }
+    
+    float zero_x_norm = (axes.x_origin - x_min) / (x_max - x_min);
+    float zero_y_norm = (axes.y_origin - y_min) / (y_max - y_min);
+    if (zero_x_norm >= 0 && zero_x_norm <= 1) {
+        float x = (float)(int)(r.x + r.width - zero_x_norm * r.width) + 0.5f;
+        RasterLine(image, x, r.y, x, r.y + r.height, 1.0f, config->crosshair);
+    }
+    if (zero_y_norm >= 0 && zero_y_norm <= 1) {
+        float y = (float)(int)(r.y + zero_y_norm * r.height) + 0.5f;
+        RasterLine(image, r.x, y, r.x + r.width, y, 1.0f, config->crosshair);
+    }
+    
+    // Traces outside the default range would run over the labels
+    RasterSetClip(image, (int)r.x, (int)r.y, (int)r.width, (int)r.height);
+    
+    // Views of one excitation at a time; no frame in a job is longer
+    float views[4][MAX_SAMPLES];
+    ChannelData ch1 = {views[0], views[1], 0};
+    ChannelData ch2 = {views[2], views[3], 0};
+    
+    if (job->has[1 - e]) {
+        ExportViews(style, &job->samples[1 - e], 1 - e, &ch1, &ch2);
+        ExportTrace(image, &ch1, config->dut1_dimmed, r, x_min, x_max, y_min, y_max);
+        if (!style->single_channel) ExportTrace(image, &ch2, config->dut2_dimmed, r, x_min, x_max, y_min, y_max);
+    }
+    if (job->has[e]) {
+        ExportViews(style, &job->samples[e], e, &ch1, &ch2);
+        ExportTrace(image, &ch1, config->dut1_trace, r, x_min, x_max, y_min, y_max);
+        if (!style->single_channel) ExportTrace(image, &ch2, config->dut2_trace, r, x_min, x_max, y_min, y_max);
+    }
+    
+    RasterResetClip(image);
+    
+    char tick[32];
+    for (int i = 0; i <= 10; i += 5) {
+        float x_val = x_min + (x_max - x_min) * (10 - i) / 10.0f;
+        float label_x = r.x + (i * r.width) / 10.0f;
+        snprintf(tick, sizeof(tick), axes.tick_format, x_val);
+        RasterText(image, tick, (int)(label_x - 20), (int)(r.y + r.height + 10), 16, config->label_color);
+        
+        float y_val = y_min + (y_max - y_min) * i / 10.0f;
+        float label_y = r.y + (i * r.height) / 10.0f;
+        snprintf(tick, sizeof(tick), axes.tick_format, y_val);
+        RasterText(image, tick, (int)(r.x - 10 - RasterTextWidth(tick, 16)), (int)(label_y - 6), 16,
+                   config->label_color);
+    }
+    
+    RasterText(image, axes.x_label, (int)(r.x + r.width / 2 - 50), (int)(r.y + r.height + 35), 20, config->axis_color);
+    RasterText(image, axes.y_label, 5, (int)(r.y - 20), 16, config->axis_color);
+    
+    float legend_x = r.x + 20;
+    float legend_y = r.y + r.height - 40;
+    RasterLine(image, legend_x, legend_y, legend_x + 40, legend_y, 4.0f, config->dut1_trace);
+    RasterText(image, "DUT1 (CH1 - Black Lead)", (int)legend_x + 50, (int)legend_y - 6, 12, config->dut1_trace);
+    if (!style->single_channel) {
+        RasterLine(image, legend_x, legend_y - 30, legend_x + 40, legend_y - 30, 4.0f, config->dut2_trace);
+        RasterText(image, "DUT2 (CH2 - Red Lead)", (int)legend_x + 50, (int)legend_y - 36, 12, config->dut2_trace);
+    }
+    
+    RasterRectLines(image, r.x, r.y, r.width, r.height, 2, config->border_color);
+}
+
+static void ExportWorker(void* arg) {
+    ExportPool* pool = arg;
+    ExportJob* job = malloc(sizeof(ExportJob));
+    RasterImage image = {0};
+    bool ready = job && RasterImageCreate(&image, pool->style.width, pool->style.height);
+    
+    MutexLock(&pool->lock);
+    for (;;) {
+        while (pool->count == 0 && !pool->stopping) CondWait(&pool->ready, &pool->lock);
+        if (pool->count == 0) break;
+        
+        if (ready) *job = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % EXPORT_QUEUE;
+        pool->count--;
+        pool->busy++;
+        CondSignal(&pool->space);
+        MutexUnlock(&pool->lock);
+        
+        bool ok = ready;
+        if (ok) {
+            ExportRenderPlot(&image, &pool->style, job);
+            ok = RasterWritePng(&image, job->path);
+        }
+        
+        MutexLock(&pool->lock);
+        if (ok) pool->written++;
+        else pool->failed++;
+        pool->busy--;
+        if (pool->count == 0 && pool->busy == 0) CondBroadcast(&pool->idle);
+    }
+    MutexUnlock(&pool->lock);
+    
+    RasterImageFree(&image);
+    free(job);
+}
+
+bool ExportPoolStart(ExportPool* pool, const ExportStyle* style, int threads) {
+    memset(pool, 0, sizeof(*pool));
+    pool->style = *style;
+    
+    pool->queue = malloc(sizeof(ExportJob) * EXPORT_QUEUE);
+    if (!pool->queue) return false;
+    
+    MutexInit(&pool->lock);
+    CondInit(&pool->ready);
+    CondInit(&pool->space);
+    CondInit(&pool->idle);
+    
+    if (threads <= 0) threads = ThreadCpuCount();
+    if (threads > EXPORT_MAX_THREADS) threads = EXPORT_MAX_THREADS;
+    
+    for (int i = 0; i < threads; i++) {
+        if (!ThreadCreate(&pool->threads[i], ExportWorker, pool)) break;
+        pool->thread_count++;
+    }
+    
+    if (pool->thread_count == 0) {
+        ExportPoolStop(pool);
+        return false;
+    }
+    return true;
+}
+
+void ExportPoolSubmit(ExportPool* pool, const ExportJob* job) {
+    MutexLock(&pool->lock);
+    while (pool->count == EXPORT_QUEUE) CondWait(&pool->space, &pool->lock);
+    pool->queue[(pool->head + pool->count) % EXPORT_QUEUE] = *job;
+    pool->count++;
+    CondSignal(&pool->ready);
+    MutexUnlock(&pool->lock);
+}
+
+void ExportPoolWait(ExportPool* pool) {
+    MutexLock(&pool->lock);
+    while (pool->count > 0 || pool->busy > 0) CondWait(&pool->idle, &pool->lock);
+    MutexUnlock(&pool->lock);
+}
+
+void ExportPoolStop(ExportPool* pool) {
+    if (!pool->queue) return;
+    
+    MutexLock(&pool->lock);
+    pool->stopping = true;
+    CondBroadcast(&pool->ready);
+    MutexUnlock(&pool->lock);
+    
+    for (int i = 0; i < pool->thread_count; i++) {
+        ThreadJoin(&pool->threads[i]);
+    }
+    
+    CondDestroy(&pool->idle);
+    CondDestroy(&pool->space);
+    CondDestroy(&pool->ready);
+    MutexDestroy(&pool->lock);
+    free(pool->queue);
+    pool->queue = NULL;
+    pool->thread_count = 0;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "plotter.h"
+#include "raster.h"
+#include "sync.h"
+
+// Offscreen plot export for reports. Rendering and PNG encoding run on a
+// pool of worker threads, each with its own RasterImage, and need no window.
+#define EXPORT_MAX_THREADS 32
+#define EXPORT_QUEUE 64
+
+typedef struct {
+    FrameSamples samples[2];    // Indexed by excitation, 0=4.7K, 1=100K
+    bool has[2];
+    int excitation;             // Drawn on top, the other one dimmed if present
+    char title[128];
+    char path[256];
+} ExportJob;
+
+typedef struct {
+    int width;
+    int height;
+    bool single_channel;
+    Config config;                      // Colours
+    const CalibrationTable* calib;      // NULL or invalid plots raw ADC counts
+} ExportStyle;
+
+typedef struct {
+    ExportStyle style;
+    Thread threads[EXPORT_MAX_THREADS];
+    int thread_count;
+    
+    Mutex lock;
+    Cond ready;
+    Cond space;
+    Cond idle;
+    ExportJob* queue;
+    int head;
+    int count;
+    int busy;
+    bool stopping;
+    
+    volatile uint32_t written;
+    volatile uint32_t failed;
+} ExportPool;
+
+// Same layout as PlotViewDraw at zoom 1: grid, crosshair, traces, ticks, labels, legend
+void ExportRenderPlot(RasterImage* image, const ExportStyle* style, const ExportJob* job);
+
+// threads <= 0 uses one per core
+bool ExportPoolStart(ExportPool* pool, const ExportStyle* style, int threads);
+
+// Copies the job; blocks while the queue is full so batches cannot outrun memory
+void ExportPoolSubmit(ExportPool* pool, const ExportJob* job);
+
+// Returns once every submitted job is written
+void ExportPoolWait(ExportPool* pool);
+
+void ExportPoolStop(ExportPool* pool);
+
+#endif
\ No newline at end of file
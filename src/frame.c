@@ -0,0 +1,288 @@
+#include "frame.h"
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(_MSC_VER)
+    #define FRAME_INLINE __forceinline
+#else
+    #define FRAME_INLINE inline __attribute__((always_inline))
+#endif
+
+void FrameGeometryDefault(FrameGeometry* geometry) {
+    geometry->samples = FRAME_SAMPLES;
+    geometry->channels = 3;
+    geometry->bits = 12;
+    geometry->origin = FRAME_ORIGIN;
+}
+
+bool FrameGeometryValid(const FrameGeometry* geometry) {
+    return geometry->samples >= 2 && geometry->samples <= FRAME_MAX_SAMPLES &&
+           geometry->channels >= 3 && geometry->channels <= FRAME_MAX_CHANNELS &&
+           geometry->samples * geometry->channels <= FRAME_MAX_WIRE_VALUES &&
+           geometry->bits >= 8 && geometry->bits <= FRAME_MAX_BITS &&
+           geometry->origin > 0 && geometry->origin < (1 << geometry->bits);
+}
+
+size_t FrameGeometryBytes(const FrameGeometry* geometry) {
+    return (size_t)geometry->samples * geometry->channels * 2;
+}
+
+size_t RawFrameBytes(int samples) {
+    return offsetof(RawFrame, values) + (size_t)samples * 3 * sizeof(uint16_t);
+}
+
+size_t RawFrameSlotBytes(size_t header, int samples) {
+    return (header + RawFrameBytes(samples) + 31) & ~(size_t)31;
+}
+
+float FrameCountScale(int bits) {
+    return (float)(1 << bits) / 4096.0f;
+}
+
+int FrameCodeMax(int bits) {
+    return (1 << bits) - 1;
+}
+
+// Thresholds are written for 12-bit codes
+static int FrameScaleCounts(const FrameGeometry* geometry, int counts) {
+    return geometry->bits >= 12 ? counts << (geometry->bits - 12) : counts >> (12 - geometry->bits);
+}
+
+// Shared body of every decoder: the first three words of each point, masked
+// to the depth. Called with constants, the compiler turns the stride into an
+// addressing mode and unrolls the copy.
+static FRAME_INLINE void FrameDecodeSweep(const uint8_t* bytes, RawFrame* frame,
+                                          int samples, int channels, int bits, int origin) {
+    uint16_t mask = (uint16_t)((1u << bits) - 1);
+    
+    for (int i = 0; i < samples; i++) {
+        const uint8_t* p = bytes + (size_t)i * channels * 2;
+        frame->values[i * 3] = (uint16_t)((p[0] | (p[1] << 8)) & mask);
+        frame->values[i * 3 + 1] = (uint16_t)((p[2] | (p[3] << 8)) & mask);
+        frame->values[i * 3 + 2] = (uint16_t)((p[4] | (p[5] << 8)) & mask);
+    }
+    frame->samples = samples;
+    frame->bits = bits;
+    frame->origin = origin;
+}
+
+#define FRAME_DECODER(name, samples, channels, bits) \
+    static void name(const FrameGeometry* geometry, const uint8_t* bytes, RawFrame* frame) { \
+        FrameDecodeSweep(bytes, frame, samples, channels, bits, geometry->origin); \
+    }
+
+FRAME_DECODER(FrameDecode336x3x12, 336, 3, 12)     // Today's firmware
+FRAME_DECODER(FrameDecode672x3x12, 672, 3, 12)     // Double density sweep
+FRAME_DECODER(FrameDecode336x4x12, 336, 4, 12)     // One extra channel
+FRAME_DECODER(FrameDecode336x3x16, 336, 3, 16)     // 16-bit ADC
+FRAME_DECODER(FrameDecode672x3x16, 672, 3, 16)
+
+static void FrameDecodeGeneric(const FrameGeometry* geometry, const uint8_t* bytes, RawFrame* frame) {
+    FrameDecodeSweep(bytes, frame, geometry->samples, geometry->channels, geometry->bits, geometry->origin);
+}
+
+static const struct {
+    int samples;
+    int channels;
+    int bits;
+    FrameDecodeFn decode;
+} FRAME_DECODERS[] = {
+    {336, 3, 12, FrameDecode336x3x12},
+    {672, 3, 12, FrameDecode672x3x12},
+    {336, 4, 12, FrameDecode336x4x12},
+    {336, 3, 16, FrameDecode336x3x16},
+    {672, 3, 16, FrameDecode672x3x16},
+};
+
+static FrameDecodeFn FrameSelectDecoder(const FrameGeometry* geometry) {
+    for (size_t i = 0; i < sizeof(FRAME_DECODERS) / sizeof(FRAME_DECODERS[0]); i++) {
+        if (FRAME_DECODERS[i].samples == geometry->samples && FRAME_DECODERS[i].channels == geometry->channels &&
+            FRAME_DECODERS[i].bits == geometry->bits) {
+            return FRAME_DECODERS[i].decode;
+        }
+    }
+    return FrameDecodeGeneric;
+}
+
+bool FrameGeometryIsSpecialized(const FrameGeometry* geometry) {
+    return FrameSelectDecoder(geometry) != FrameDecodeGeneric;
+}
+
+void FrameParserInit(FrameParser* parser) {
+    memset(parser, 0, sizeof(*parser));
+    
+    FrameGeometry geometry;
+    FrameGeometryDefault(&geometry);
+    FrameParserSetGeometry(parser, &geometry);
+}
+
+bool FrameParserSetGeometry(FrameParser* parser, const FrameGeometry* geometry) {
+    if (!FrameGeometryValid(geometry)) return false;
+    
+    parser->geometry = *geometry;
+    parser->frame_bytes = FrameGeometryBytes(geometry);
+    parser->capacity = parser->frame_bytes * 2;
+    parser->decode = FrameSelectDecoder(geometry);
+    parser->length = 0;
+    parser->in_resync = false;
+    return true;
+}
+
+size_t FrameParserSpace(const FrameParser* parser) {
+    return parser->capacity - parser->length;
+}
+
+size_t FrameParserPush(FrameParser* parser, const uint8_t* data, size_t len) {
+    size_t space = FrameParserSpace(parser);
+    if (len > space) len = space;
+    
+    memcpy(parser->buffer + parser->length, data, len);
+    parser->length += len;
+    return len;
+}
+
+// Every word holds a code of the geometry's depth, so the bits above it are
+// zero. A stream shifted by one byte fails this on almost every word unless
+// the ADC uses all 16 bits.
+static bool FrameCheckWords(const FrameGeometry* geometry, const uint8_t* bytes, size_t words) {
+    uint8_t high = 0;
+    for (size_t i = 0; i < words; i++) {
+        high |= bytes[i * 2 + 1];
+    }
+    return (high & (uint8_t)(0xFF << (geometry->bits - 8))) == 0;
+}
+
+// The drive sweeps up and down, so it only changes direction a few times.
+// A stream shifted by whole words puts a DUT channel in the drive slot.
+static bool FrameCheckDrive(const FrameGeometry* geometry, const uint8_t* bytes) {
+    size_t stride = (size_t)geometry->channels * 2;
+    int hysteresis = FrameScaleCounts(geometry, FRAME_DRIVE_HYSTERESIS);
+    int extreme = bytes[0] | (bytes[1] << 8);
+    int direction = 0;
+    int reversals = 0;
+    
+    for (int i = 1; i < geometry->samples; i++) {
+        const uint8_t* p = bytes + i * stride;
+        int drive = p[0] | (p[1] << 8);
+        int delta = drive - extreme;
+        
+        if (direction >= 0 && delta > 0) {
+            extreme = drive;
+            direction = 1;
+        } else if (direction <= 0 && delta < 0) {
+            extreme = drive;
+            direction = -1;
+        } else if (delta > hysteresis || delta < -hysteresis) {
+            extreme = drive;
+            direction = -direction;
+            if (++reversals > FRAME_MAX_DRIVE_REVERSALS) return false;
+        }
+    }
+    
+    return true;
+}
+
+// A passive DUT sits between the drive and common, so neither channel swings
+// further from the origin than the drive. Catches a channel in the drive slot.
+static bool FrameCheckPassive(const FrameGeometry* geometry, const uint8_t* bytes) {
+    size_t stride = (size_t)geometry->channels * 2;
+    int origin = geometry->origin;
+    int tolerance = FrameScaleCounts(geometry, FRAME_OVERDRIVE_TOLERANCE);
+    int violations = 0;
+    
+    for (int i = 0; i < geometry->samples; i++) {
+        const uint8_t* p = bytes + i * stride;
+        int drive = abs((p[0] | (p[1] << 8)) - origin) + tolerance;
+        int ch1 = abs((p[2] | (p[3] << 8)) - origin);
+        int ch2 = abs((p[4] | (p[5] << 8)) - origin);
+        violations += (ch1 > drive) + (ch2 > drive);
+    }
+    
+    return violations <= geometry->samples / 8;
+}
+
+bool FrameValidate(const FrameGeometry* geometry, const uint8_t* bytes) {
+    return FrameCheckWords(geometry, bytes, (size_t)geometry->samples * geometry->channels) &&
+           FrameCheckDrive(geometry, bytes) &&
+           FrameCheckPassive(geometry, bytes);
+}
+
+void FrameDecode(const FrameGeometry* geometry, const uint8_t* bytes, RawFrame* frame) {
+    FrameSelectDecoder(geometry)(geometry, bytes, frame);
+}
+
+void FrameSplit(const RawFrame* frame, FrameSamples* samples) {
+    const uint16_t* v = frame->values;
+    for (int i = 0; i < frame->samples; i++) {
+        samples->drive[i] = v[i * 3];
+        samples->ch1[i] = v[i * 3 + 1];
+        samples->ch2[i] = v[i * 3 + 2];
+    }
+    samples->count = frame->samples;
+    samples->bits = frame->bits;
+    samples->origin = frame->origin;
+}
+
+void FrameJoin(const FrameSamples* samples, RawFrame* frame) {
+    uint16_t* v = frame->values;
+    for (int i = 0; i < samples->count; i++) {
+        v[i * 3] = samples->drive[i];
+        v[i * 3 + 1] = samples->ch1[i];
+        v[i * 3 + 2] = samples->ch2[i];
+    }
+    frame->samples = samples->count;
+    frame->bits = samples->bits;
+    frame->origin = samples->origin;
+}
+
+static void FrameParserConsume(FrameParser* parser, size_t count) {
+    memmove(parser->buffer, parser->buffer + count, parser->length - count);
+    parser->length -= count;
+}
+
+bool FrameParserNext(FrameParser* parser, RawFrame* frame) {
+    const FrameGeometry* geometry = &parser->geometry;
+    size_t frame_words = parser->frame_bytes / 2;
+    
+    while (parser->length >= parser->frame_bytes) {
+        if (FrameValidate(geometry, parser->buffer)) {
+            parser->decode(geometry, parser->buffer, frame);
+            FrameParserConsume(parser, parser->frame_bytes);
+            parser->stats.frames_good++;
+            parser->in_resync = false;
+            return true;
+        }
+        
+        if (!parser->in_resync) {
+            parser->in_resync = true;
+            parser->stats.resyncs++;
+            parser->stats.frames_dropped++;
+        }
+        
+        // Slide to the next offset whose available words still look like samples.
+        // A candidate that is only partly buffered is kept until more data arrives.
+        size_t offset = 1;
+        while (offset < parser->length) {
+            size_t words = (parser->length - offset) / 2;
+            if (words > frame_words) words = frame_words;
+            if (FrameCheckWords(geometry, parser->buffer + offset, words)) {
+                if (words < frame_words || FrameValidate(geometry, parser->buffer + offset)) break;
+            }
+            offset++;
+        }
+        
+        parser->stats.bytes_discarded += offset;
+        FrameParserConsume(parser, offset);
+    }
+    
+    return false;
+}
+
+void FrameParserDiscard(FrameParser* parser) {
+    if (parser->length > 0) {
+        parser->stats.frames_dropped++;
+        parser->stats.bytes_discarded += parser->length;
+    }
+    parser->length = 0;
+    parser->in_resync = false;
+}
\ No newline at end of file
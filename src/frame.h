@@ -0,0 +1,121 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Today's firmware sends 336 (drive, ch1, ch2) triples of 12-bit codes as
+// little endian words. Other firmware is described by a FrameGeometry, and its
+// frames keep their own sample count, depth and origin all the way through.
+// A single frame is sized for the largest geometry; rings and tables of many
+// frames are sized for the geometry opened, see RawFrameBytes.
+#define FRAME_SAMPLES 336
+#define FRAME_VALUES (FRAME_SAMPLES * 3)
+#define FRAME_BYTES (FRAME_VALUES * 2)
+#define FRAME_ORIGIN 2048           // ADC code of the DUT common
+
+#define FRAME_MAX_SAMPLES 1344      // Four times today's sweep; a multiple of 16
+#define FRAME_MAX_VALUES (FRAME_MAX_SAMPLES * 3)
+#define FRAME_MAX_BITS 16
+#define FRAME_MAX_CHANNELS 8
+#define FRAME_MAX_WIRE_VALUES 8192  // Largest frame any geometry may send, in words
+#define FRAME_MAX_WIRE_BYTES (FRAME_MAX_WIRE_VALUES * 2)
+
+#define FRAME_DRIVE_HYSTERESIS 24   // Counts of drive movement ignored as noise
+#define FRAME_MAX_DRIVE_REVERSALS 3 // Direction changes allowed over one sweep
+#define FRAME_OVERDRIVE_TOLERANCE 16 // Counts a DUT channel may exceed the drive
+
+#if defined(_MSC_VER)
+    #define FRAME_ALIGN __declspec(align(32))
+#else
+    #define FRAME_ALIGN __attribute__((aligned(32)))
+#endif
+
+// One decoded frame: samples (drive, ch1, ch2) triples of codes at its own depth
+typedef struct {
+    int samples;
+    int bits;
+    int origin;
+    uint16_t values[FRAME_MAX_VALUES];
+} RawFrame;
+
+// Wire format of one frame: samples points of channels little endian words,
+// drive first, then DUT1 and DUT2. Channels past those are read but dropped;
+// samples, bits and origin carry over to the decoded frame as they are.
+typedef struct {
+    int samples;                // 2 to FRAME_MAX_SAMPLES
+    int channels;
+    int bits;                   // 8 to 16
+    int origin;                 // Code of the DUT common at this bit depth
+} FrameGeometry;
+
+typedef void (*FrameDecodeFn)(const FrameGeometry* geometry, const uint8_t* bytes, RawFrame* frame);
+
+// Deinterleaved samples of one frame. Each array starts on a 32 byte boundary
+// (FRAME_MAX_SAMPLES * 2 bytes is a multiple of 32), so SIMD loops need no peeling.
+typedef struct {
+    FRAME_ALIGN uint16_t drive[FRAME_MAX_SAMPLES];
+    FRAME_ALIGN uint16_t ch1[FRAME_MAX_SAMPLES];
+    FRAME_ALIGN uint16_t ch2[FRAME_MAX_SAMPLES];
+    int count;
+    int bits;
+    int origin;
+} FrameSamples;
+
+typedef struct {
+    uint32_t frames_good;
+    uint32_t frames_dropped;    // Partial, stale or corrupt frames thrown away
+    uint32_t resyncs;           // Times the stream had to be realigned
+    uint64_t bytes_discarded;
+} FrameParserStats;
+
+// Streaming parser: accepts arbitrary read chunks and emits validated frames,
+// realigning on the next plausible frame start after corruption.
+typedef struct {
+    uint8_t buffer[FRAME_MAX_WIRE_BYTES * 2];
+    size_t length;
+    bool in_resync;
+    FrameParserStats stats;
+    
+    FrameGeometry geometry;
+    size_t frame_bytes;
+    size_t capacity;            // Two frames; the rest of buffer is unused
+    FrameDecodeFn decode;
+} FrameParser;
+
+void FrameGeometryDefault(FrameGeometry* geometry);
+bool FrameGeometryValid(const FrameGeometry* geometry);
+size_t FrameGeometryBytes(const FrameGeometry* geometry);
+
+// Leading bytes of a RawFrame that hold samples triples. Ring slots keep their
+// RawFrame last and only this much of it; a slot holding header bytes of record
+// before the frame is RawFrameSlotBytes long, rounded up to 32 bytes.
+size_t RawFrameBytes(int samples);
+size_t RawFrameSlotBytes(size_t header, int samples);
+
+// Geometries with a compiled-in decoder; anything else valid uses the generic one
+bool FrameGeometryIsSpecialized(const FrameGeometry* geometry);
+
+// Thresholds, limits and the default raw plot framing are written in 12-bit
+// counts; this is the factor to codes of another depth
+float FrameCountScale(int bits);
+int FrameCodeMax(int bits);
+
+// Starts with the default geometry
+void FrameParserInit(FrameParser* parser);
+
+// Drops anything buffered. False, leaving the parser as it was, if the geometry is invalid.
+bool FrameParserSetGeometry(FrameParser* parser, const FrameGeometry* geometry);
+
+size_t FrameParserPush(FrameParser* parser, const uint8_t* data, size_t len);
+bool FrameParserNext(FrameParser* parser, RawFrame* frame);
+void FrameParserDiscard(FrameParser* parser);
+size_t FrameParserSpace(const FrameParser* parser);
+
+bool FrameValidate(const FrameGeometry* geometry, const uint8_t* bytes);
+void FrameDecode(const FrameGeometry* geometry, const uint8_t* bytes, RawFrame* frame);
+void FrameSplit(const RawFrame* frame, FrameSamples* samples);
+void FrameJoin(const FrameSamples* samples, RawFrame* frame);
+
+#endif
\ No newline at end of file
@@ -17,11 +17,28 @@
 #include "serial.h"
 #include "config.h"
 #include "plotter.h"
+#include "capture.h"
+#include "shmring.h"
+#include "control.h"
+#include "pipeline.h"
+#include "trigger.h"
+#include "summary.h"
+#include "spatial.h"
+#include "trend.h"
+#include "sequence.h"
+#include "textexport.h"
+#include "realtime.h"
+#include "acquire.h"
+#ifdef CURVEBUG_ALLOC_CHECK
+    #include "alloccheck.h"
+    #define ALLOC_CHECK_WARMUP 300      // Loop iterations before an allocation counts as a failure
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <math.h>
 
 // Settings tab enum
 typedef enum {
@@ -30,6 +47,61 @@ typedef enum {
     TAB_KEYBINDS
 } SettingsTab;
 
+// Capture file plus metrics log, written from the recorder sink's thread.
+// The lock only covers opening and closing against an in-flight write.
+typedef struct {
+    Mutex lock;
+    CaptureWriter capture;
+    SummaryWriter summary;
+    FILE* metrics_log;
+    uint64_t start_us;
+} Recorder;
+
+// Live CSV or JSON Lines export, formatted and written on its own sink's thread
+typedef struct {
+    Mutex lock;
+    TextExporter exporter;
+    bool active;
+    uint64_t start_us;
+} LiveExport;
+
+// Scrubbing through a recorded capture; the summary provides the overview and the seek index
+typedef struct {
+    bool active;
+    CaptureReader reader;
+    Summary summary;
+    uint32_t frame;
+    CaptureFrameInfo info;
+    int key;                    // SummaryKey shown on the timeline
+    bool scrubbing;
+    char path[256];
+} Review;
+
+// Change trigger run on its own sink; armed is flipped by the UI thread
+typedef struct {
+    Trigger trigger;
+    volatile bool armed;
+    bool was_armed;
+} TriggerMonitor;
+
+// Nearest sample under the mouse. Each excitation's points are projected to
+// screen space only when its views or the plot range change; bucketing both
+// into the grid is one linear pass.
+#define CURSOR_CELL 16.0f
+#define CURSOR_MAX_CELLS ((3840 / 16 + 1) * (2160 / 16 + 1))   // A 4K pane; larger ones get larger cells
+
+typedef struct {
+    SpatialGrid grid;
+    SpatialPoint layers[2][CURVE_MAX_CHANNELS * MAX_SAMPLES];
+    int layer_count[2];
+    bool layer_shown[2];
+    uint32_t generation[2];
+    float range[4];
+    Rectangle area;
+    bool single_channel;
+    const PlotView* view;       // Pane the points were projected for
+} CursorIndex;
+
 // Helper for drawing tabs
 int DrawTabs(Rectangle bounds, const char** tabs, int count, int active) {
     float tab_width = bounds.width / count;
@@ -112,35 +184,649 @@ void DrawColorPreview(Rectangle bounds, Config* config) {
     DrawRectangleLinesEx(bounds, 2, config->border_color);
 }
 
+// Channels 0 and 1 are the leads; traces are added after them
+void CurveDataInit(CurveData* data) {
+    memset(data->channels, 0, sizeof(data->channels));
+    data->channel_count = 2;
+    data->view_storage = NULL;
+    data->spline_storage = NULL;
+    data->capacity = 0;
+    
+    for (int c = 0; c < 2; c++) {
+        CurveChannel* ch = &data->channels[c];
+        ch->source = CURVE_SOURCE_LEAD;
+        ch->lead = c;
+        ch->leads = c ? CURVE_LEAD_DUT2 : CURVE_LEAD_DUT1;
+        ch->visible = true;
+    }
+    strcpy(data->channels[0].name, "DUT1 (CH1 - Black Lead)");
+    strcpy(data->channels[1].name, "DUT2 (CH2 - Red Lead)");
+    data->views_dirty[0] = data->views_dirty[1] = true;
+    
+    // Axes frame today's depth until a frame says otherwise
+    for (int e = 0; e < 2; e++) {
+        FrameSamples* s = e ? &data->samples_weak : &data->samples_std;
+        s->bits = 12;
+        s->origin = FRAME_ORIGIN;
+    }
+}
+
+bool CurveDataReserve(CurveData* data, int samples) {
+    if (samples <= data->capacity) return true;
+    if (samples < 2) samples = 2;
+    
+    size_t slots = CURVE_MAX_CHANNELS * 2;
+    float* view_storage = malloc(sizeof(float) * 2 * samples * slots);
+    SplineSegment* spline_storage = malloc(sizeof(SplineSegment) * (samples - 1) * slots);
+    if (!view_storage || !spline_storage) {
+        free(view_storage);
+        free(spline_storage);
+        return false;
+    }
+    
+    // Reference traces have nothing else to be rebuilt from, so views move over
+    for (int c = 0; c < CURVE_MAX_CHANNELS; c++) {
+        for (int e = 0; e < 2; e++) {
+            size_t slot = (size_t)c * 2 + e;
+            ChannelData view = {view_storage + slot * 2 * samples, view_storage + (slot * 2 + 1) * samples, 0};
+            if (data->channels[c].view[e].count > 0) ChannelViewCopy(&view, &data->channels[c].view[e]);
+            data->channels[c].view[e] = view;
+            data->channels[c].spline[e] = (Spline){spline_storage + slot * (samples - 1), samples - 1, 0};
+        }
+    }
+    
+    free(data->view_storage);
+    free(data->spline_storage);
+    data->view_storage = view_storage;
+    data->spline_storage = spline_storage;
+    data->capacity = samples;
+    data->splines_dirty[0] = data->splines_dirty[1] = true;
+    return true;
+}
+
+void CurveDataFree(CurveData* data) {
+    free(data->view_storage);
+    free(data->spline_storage);
+    data->view_storage = NULL;
+    data->spline_storage = NULL;
+    data->capacity = 0;
+    for (int c = 0; c < CURVE_MAX_CHANNELS; c++) {
+        for (int e = 0; e < 2; e++) {
+            data->channels[c].view[e] = (ChannelData){NULL, NULL, 0};
+            data->channels[c].spline[e] = (Spline){NULL, 0, 0};
+        }
+    }
+}
+
+// Resets a channel slot but keeps the view and spline storage it owns
+void CurveChannelClear(CurveChannel* ch) {
+    ChannelData view[2] = {ch->view[0], ch->view[1]};
+    Spline spline[2] = {ch->spline[0], ch->spline[1]};
+    memset(ch, 0, sizeof(*ch));
+    for (int e = 0; e < 2; e++) {
+        ch->view[e] = (ChannelData){view[e].voltage, view[e].current, 0};
+        ch->spline[e] = (Spline){spline[e].segments, spline[e].capacity, 0};
+    }
+}
+
+int CurveDataAddDerived(CurveData* data, CurveSource source, int a, int b, const char* name) {
+    if (data->channel_count >= CURVE_MAX_CHANNELS) return -1;
+    if (a < 0 || b < 0 || a >= data->channel_count || b >= data->channel_count) return -1;
+    
+    int index = data->channel_count++;
+    CurveChannel* ch = &data->channels[index];
+    CurveChannelClear(ch);
+    ch->source = source;
+    ch->a = a;
+    ch->b = b;
+    ch->leads = data->channels[a].leads | data->channels[b].leads;
+    ch->visible = true;
+    strncpy(ch->name, name, sizeof(ch->name) - 1);
+    
+    // Only the new channel needs filling, but a full pass is cheap
+    data->views_dirty[0] = data->views_dirty[1] = true;
+    return index;
+}
+
+// Snapshots both excitations of a channel as they are now
+int CurveDataAddReference(CurveData* data, int from, const char* name) {
+    if (data->channel_count >= CURVE_MAX_CHANNELS || from < 0 || from >= data->channel_count) return -1;
+    CurveDataUpdateViews(data);
+    
+    int index = data->channel_count++;
+    CurveChannel* ch = &data->channels[index];
+    CurveChannelClear(ch);
+    ch->source = CURVE_SOURCE_REFERENCE;
+    ch->a = ch->b = from;
+    ch->leads = data->channels[from].leads;
+    ch->visible = true;
+    strncpy(ch->name, name, sizeof(ch->name) - 1);
+    memcpy(ch->bounds, data->channels[from].bounds, sizeof(ch->bounds));
+    for (int e = 0; e < 2; e++) {
+        ChannelViewCopy(&ch->view[e], &data->channels[from].view[e]);
+        ch->frame[e] = data->channels[from].frame[e];
+        data->generation[e]++;
+    }
+    
+    data->splines_dirty[0] = data->splines_dirty[1] = true;
+    return index;
+}
+
+// Derived traces of removed channels go with them
+void CurveDataRemoveChannels(CurveData* data, CurveSource source) {
+    int remap[CURVE_MAX_CHANNELS];
+    int kept = 0;
+    
+    for (int c = 0; c < data->channel_count; c++) {
+        CurveChannel* ch = &data->channels[c];
+        bool derived = ch->source == CURVE_SOURCE_DIFFERENCE || ch->source == CURVE_SOURCE_AVERAGE ||
+                       ch->source == CURVE_SOURCE_REFERENCE;
+        bool drop = c >= 2 && (ch->source == source || (derived && (remap[ch->a] < 0 || remap[ch->b] < 0)));
+        
+        remap[c] = drop ? -1 : kept;
+        if (drop) continue;
+        
+        if (derived) {
+            ch->a = remap[ch->a];
+            ch->b = remap[ch->b];
+        }
+        if (kept != c) {
+            // Into the slot's own storage; the splines are rebuilt below
+            CurveChannel* to = &data->channels[kept];
+            ChannelData view[2] = {to->view[0], to->view[1]};
+            Spline spline[2] = {to->spline[0], to->spline[1]};
+            *to = *ch;
+            for (int e = 0; e < 2; e++) {
+                to->view[e] = view[e];
+                to->spline[e] = (Spline){spline[e].segments, spline[e].capacity, 0};
+                ChannelViewCopy(&to->view[e], &ch->view[e]);
+            }
+        }
+        kept++;
+    }
+    data->channel_count = kept;
+    data->splines_dirty[0] = data->splines_dirty[1] = true;
+    data->generation[0]++;
+    data->generation[1]++;
+}
+
+// ALT mode draws the other excitation dimmed once both have a frame
+bool CurveDataAlternating(const CurveData* data) {
+    return data->excitation_mode == 2 &&
+           data->channels[0].view[0].count > 0 && data->channels[0].view[1].count > 0;
+}
+
+int CurveDataFindSource(const CurveData* data, CurveSource source) {
+    for (int c = 0; c < data->channel_count; c++) {
+        if (data->channels[c].source == source) return c;
+    }
+    return -1;
+}
+
+bool CurveDataChannelShown(const CurveData* data, int channel, bool single_channel) {
+    const CurveChannel* ch = &data->channels[channel];
+    return ch->visible && !(single_channel && (ch->leads & CURVE_LEAD_DUT2));
+}
+
+// Range of the channels a view shows, for its excitation or both, from the
+// bounds cached when the views were built
+bool CurveDataBounds(CurveData* data, const PlotView* view, bool single_channel, bool both_excitations,
+                     float* x_min, float* x_max, float* y_min, float* y_max) {
+    CurveDataUpdateViews(data);
+    
+    int e_active = PlotViewExcitation(view, data);
+    bool any = false;
+    float lo_x = 0, hi_x = 0, lo_y = 0, hi_y = 0;
+    
+    for (int c = 0; c < data->channel_count; c++) {
+        if (!PlotViewShowsChannel(view, data, c, single_channel)) continue;
+        
+        for (int e = 0; e < 2; e++) {
+            if (!both_excitations && e != e_active) continue;
+            if (data->channels[c].view[e].count == 0) continue;
+            
+            const float* b = data->channels[c].bounds[e];
+            if (!any) {
+                lo_x = b[0];
+                hi_x = b[1];
+                lo_y = b[2];
+                hi_y = b[3];
+                any = true;
+            }
+            if (b[0] < lo_x) lo_x = b[0];
+            if (b[1] > hi_x) hi_x = b[1];
+            if (b[2] < lo_y) lo_y = b[2];
+            if (b[3] > hi_y) hi_y = b[3];
+        }
+    }
+    
+    *x_min = lo_x;
+    *x_max = hi_x;
+    *y_min = lo_y;
+    *y_max = hi_y;
+    return any;
+}
+
+void CurveDataStore(CurveData* data, const RawFrame* frame, bool weak) {
+    if (!CurveDataReserve(data, frame->samples)) return;
+    
+    FrameSamples* samples = weak ? &data->samples_weak : &data->samples_std;
+    FrameSplit(frame, samples);
+    DiffCompute(samples, &data->diff_params, &data->diff[weak ? 1 : 0]);
+    data->views_dirty[weak ? 1 : 0] = true;
+    
+    data->last_was_weak = weak;
+}
+
+
+void CurveDataUpdateViews(CurveData* data) {
+    for (int e = 0; e < 2; e++) {
+        if (!data->views_dirty[e]) continue;
+        
+        const FrameSamples* s = e ? &data->samples_weak : &data->samples_std;
+        bool calibrated = data->calib && data->calib->valid;
+        float ma_per_volt = calibrated ? data->calib->ma_per_volt[e] : 0.0f;
+        
+        // Inputs always come before the traces derived from them
+        for (int c = 0; c < data->channel_count; c++) {
+            CurveChannel* ch = &data->channels[c];
+            ChannelData* view = &ch->view[e];
+            if (ch->source != CURVE_SOURCE_REFERENCE) ch->frame[e] = data->frame_index[e];
+            
+            switch (ch->source) {
+                case CURVE_SOURCE_LEAD: {
+                    const uint16_t* raw = ch->lead ? s->ch2 : s->ch1;
+                    if (calibrated) {
+                        ChannelViewCalibrated(view, s->drive, raw, s->count, data->calib, ma_per_volt);
+                    } else {
+                        ChannelViewFromSamples(view, s->drive, raw, s->count);
+                    }
+                    break;
+                }
+                case CURVE_SOURCE_DIFFERENCE:
+                case CURVE_SOURCE_AVERAGE:
+                    ChannelViewCombine(view, &data->channels[ch->a].view[e], &data->channels[ch->b].view[e],
+                                       ch->source == CURVE_SOURCE_AVERAGE);
+                    break;
+                case CURVE_SOURCE_REFERENCE:
+                    continue;
+            }
+            ChannelViewBounds(view, ch->bounds[e]);
+        }
+        data->views_dirty[e] = false;
+        data->splines_dirty[e] = true;
+        data->generation[e]++;
+    }
+}
+
+// Spline coefficients are built once per new frame, not per draw
+void CurveDataUpdateSplines(CurveData* data) {
+    CurveDataUpdateViews(data);
+    
+    for (int e = 0; e < 2; e++) {
+        if (!data->splines_dirty[e]) continue;
+        
+        for (int c = 0; c < data->channel_count; c++) {
+            CurveChannel* ch = &data->channels[c];
+            SplineBuild(&ch->spline[e], ch->view[e].voltage, ch->view[e].current, ch->view[e].count);
+        }
+        data->splines_dirty[e] = false;
+    }
+}
+
+void CurveDataUpdateMetrics(CurveData* data, bool weak) {
+    double start = SerialGetTimeMs();
+    
+    int e = weak ? 1 : 0;
+    const FrameSamples* s = weak ? &data->samples_weak : &data->samples_std;
+    
+    MetricsParams params;
+    ClassifyParams classify;
+    if (data->calib && data->calib->valid) {
+        MetricsParamsCalibrated(&params, data->calib, s->bits, s->origin, weak);
+        ClassifyParamsCalibrated(&classify, data->calib, s->bits, s->origin, weak);
+    } else {
+        MetricsParamsRaw(&params, s->bits, s->origin, weak);
+        ClassifyParamsRaw(&classify, s->bits, s->origin);
+    }
+    
+    CurveDataUpdateViews(data);
+    
+    // Metrics need the raw samples, which only the leads have
+    for (int c = 0; c < data->channel_count; c++) {
+        CurveChannel* ch = &data->channels[c];
+        if (ch->source != CURVE_SOURCE_LEAD) continue;
+        
+        const uint16_t* raw = ch->lead ? s->ch2 : s->ch1;
+        MetricsCompute(ch->view[e].voltage, ch->view[e].current, s->drive, raw, ch->view[e].count,
+                       &params, &ch->metrics[e]);
+        ClassifyCurve(ch->view[e].voltage, ch->view[e].current, ch->view[e].count,
+                      &classify, &ch->classification[e]);
+    }
+    
+    data->metrics_us = (float)((SerialGetTimeMs() - start) * 1000.0);
+}
+
+Color CurveChannelColor(const CurveData* data, int channel, const Config* config, bool dimmed) {
+    const CurveChannel* ch = &data->channels[channel];
+    switch (ch->source) {
+        case CURVE_SOURCE_LEAD:
+            if (ch->lead) return dimmed ? config->dut2_dimmed : config->dut2_trace;
+            return dimmed ? config->dut1_dimmed : config->dut1_trace;
+        case CURVE_SOURCE_REFERENCE:
+            return Fade(CurveChannelColor(data, ch->a, config, false), dimmed ? 0.25f : 0.5f);
+        default:
+            return dimmed ? Fade(config->crosshair, 0.4f) : config->crosshair;
+    }
+}
+
+void DrawMetrics(Rectangle r, const CurveData* data, const Config* config, bool single_channel) {
+    int e = data->last_was_weak ? 1 : 0;
+    int x = (int)(r.x + 10);
+    int y = (int)(r.y + 10);
+    
+    for (int c = 0; c < data->channel_count; c++) {
+        const CurveChannel* ch = &data->channels[c];
+        if (ch->source != CURVE_SOURCE_LEAD || !CurveDataChannelShown(data, c, single_channel)) continue;
+        
+        const MetricsResult* m = &ch->metrics[e];
+        Color color = CurveChannelColor(data, c, config, false);
+        DrawText(TextFormat("DUT%d  R0:%.0f ohm  Knee:%.3g  Leak:%.3g  V0:%.3g  I0:%.3g",
+                            ch->lead + 1, m->r_small, m->v_knee, m->i_leak, m->v_zero, m->i_zero),
+                 x, y, 12, color);
+        DrawText(TextFormat("      Noise:%.3g  Loop:%.3g  Clipped:%d",
+                            m->noise, m->loop_area, m->clipped),
+                 x, y + 14, 12, color);
+        y += 34;
+    }
+    DrawText(TextFormat("metrics %.1f us", data->metrics_us), x, y, 10, config->label_color);
+}
+
+// DUT1 - DUT2 against sweep position, with the max deviation limits
+void DrawDiffPane(Rectangle r, const CurveData* data, const Config* config) {
+    const DiffResult* diff = &data->diff[data->last_was_weak ? 1 : 0];
+    
+    DrawRectangleRec(r, config->grid_bg);
+    
+    // The limit as scaled to the frame's depth, once there is a frame
+    float max_alarm = diff->count > 0 ? diff->max_alarm : config->diff_max_alarm;
+    float limit = max_alarm * 2.0f;
+    if (diff->max_dev > limit) limit = (float)diff->max_dev;
+    if (limit < 1) limit = 1;
+    
+    float mid_y = r.y + r.height / 2;
+    float alarm_dy = max_alarm / limit * (r.height / 2);
+    DrawLine((int)r.x, (int)mid_y, (int)(r.x + r.width), (int)mid_y, config->crosshair);
+    DrawLine((int)r.x, (int)(mid_y - alarm_dy), (int)(r.x + r.width), (int)(mid_y - alarm_dy), config->grid_color);
+    DrawLine((int)r.x, (int)(mid_y + alarm_dy), (int)(r.x + r.width), (int)(mid_y + alarm_dy), config->grid_color);
+    
+    if (diff->count > 1) {
+        // Shade the worst RMS window
+        float win_x = r.x + r.width * diff->window_start / (diff->count - 1);
+        float win_w = r.width * config->diff_window / (diff->count - 1);
+        DrawRectangleRec((Rectangle){win_x, r.y, win_w, r.height}, Fade(config->crosshair, 0.15f));
+        
+        Color color = diff->alarm ? RED : config->dut1_trace;
+        for (int i = 0; i < diff->count - 1; i++) {
+            float x1 = r.x + r.width * i / (diff->count - 1);
+            float x2 = r.x + r.width * (i + 1) / (diff->count - 1);
+            float y1 = mid_y - diff->trace[i] / limit * (r.height / 2);
+            float y2 = mid_y - diff->trace[i + 1] / limit * (r.height / 2);
+            DrawLineEx((Vector2){x1, y1}, (Vector2){x2, y2}, 1.5f, color);
+        }
+    }
+    
+    DrawText(TextFormat("DUT1-DUT2  RMS:%.1f  Window RMS:%.1f  Max:%d",
+                        diff->rms, diff->window_rms, diff->max_dev),
+             (int)(r.x + 5), (int)(r.y + 5), 12, config->label_color);
+    DrawRectangleLinesEx(r, 2, diff->alarm ? RED : config->border_color);
+}
+
+// One trend sample per acquired frame; only the frame's own excitation has values
+void TrendAddFrame(Trend* trend, const CurveData* data, float probe_voltage, double time) {
+    int e = data->last_was_weak ? 1 : 0;
+    float values[TREND_SERIES];
+    for (int s = 0; s < TREND_SERIES; s++) values[s] = NAN;
+    
+    values[TREND_DIFF_RMS * 2 + e] = data->diff[e].rms;
+    for (int c = 0; c < 2; c++) {
+        const ChannelData* view = &data->channels[c].view[e];
+        values[(TREND_I_DUT1 + c) * 2 + e] = MetricsCurrentAt(view->voltage, view->current, view->count,
+                                                              probe_voltage);
+    }
+    TrendAdd(trend, time, values);
+}
+
+const char* TrendTimeText(double seconds) {
+    if (seconds < 120) return TextFormat("%.0f s", seconds);
+    if (seconds < 7200) return TextFormat("%.1f min", seconds / 60);
+    return TextFormat("%.2f h", seconds / 3600);
+}
+
+// Up to two series sharing one vertical scale, fitted to what is on screen
+void DrawTrendStrip(Rectangle r, const Trend* trend, const int* series, const Color* colors, int count,
+                    double t1, const char* label, const Config* config) {
+    static float lo[2][2048], hi[2][2048];
+    int columns = (int)r.width;
+    if (columns > 2048) columns = 2048;
+    
+    float v_min = INFINITY, v_max = -INFINITY;
+    for (int k = 0; k < count; k++) {
+        TrendRead(trend, series[k], 0, t1, columns, lo[k], hi[k]);
+        for (int c = 0; c < columns; c++) {
+            if (lo[k][c] < v_min) v_min = lo[k][c];
+            if (hi[k][c] > v_max) v_max = hi[k][c];
+        }
+    }
+    
+    DrawLine((int)r.x, (int)(r.y + r.height), (int)(r.x + r.width), (int)(r.y + r.height), config->grid_color);
+    DrawText(label, (int)r.x + 5, (int)r.y + 3, 12, config->label_color);
+    if (v_min > v_max) return;
+    
+    if (v_max - v_min < 1e-6f) {
+        v_min -= 0.5f;
+        v_max += 0.5f;
+    }
+    float scale = (r.height - 20) / (v_max - v_min);
+    float bottom = r.y + r.height - 2;
+    
+    for (int k = 0; k < count; k++) {
+        for (int c = 0; c < columns; c++) {
+            if (isnan(lo[k][c])) continue;
+            int x = (int)r.x + c;
+            int y_top = (int)(bottom - (hi[k][c] - v_min) * scale);
+            int y_bottom = (int)(bottom - (lo[k][c] - v_min) * scale);
+            DrawLine(x, y_top, x, y_bottom + 1, colors[k]);
+        }
+    }
+    
+    DrawText(TextFormat("%.4g", v_max), (int)(r.x + r.width - 60), (int)r.y + 3, 10, config->label_color);
+    DrawText(TextFormat("%.4g", v_min), (int)(r.x + r.width - 60), (int)(r.y + r.height - 12), 10,
+             config->label_color);
+}
+
+// Whole run so far, current at the probe voltage above the DUT1 - DUT2 RMS
+void DrawTrendPane(Rectangle r, const Trend* trend, const CurveData* data, const PlotAxes* axes,
+                   const Config* config, bool single_channel, float probe_voltage) {
+    int e = data->last_was_weak ? 1 : 0;
+    double t1 = trend->last + TREND_BASE_SECONDS;
+    if (t1 < 60) t1 = 60;
+    
+    DrawRectangleRec(r, config->grid_bg);
+    
+    Rectangle upper = {r.x, r.y, r.width, single_channel ? r.height : r.height / 2};
+    Rectangle lower = {r.x, r.y + r.height / 2, r.width, r.height / 2};
+    
+    if (isnan(probe_voltage)) {
+        DrawText("Right-click the plot to pick the probe voltage", (int)upper.x + 5, (int)upper.y + 3, 12,
+                 config->label_color);
+    } else {
+        int series[2] = {TREND_I_DUT1 * 2 + e, TREND_I_DUT2 * 2 + e};
+        Color colors[2] = {config->dut1_trace, config->dut2_trace};
+        DrawTrendStrip(upper, trend, series, colors, single_channel ? 1 : 2, t1,
+                       TextFormat("%s at %.3g (%s)", axes->y_label, probe_voltage, axes->x_label), config);
+    }
+    if (!single_channel) {
+        int series = TREND_DIFF_RMS * 2 + e;
+        DrawTrendStrip(lower, trend, &series, &config->crosshair, 1, t1, TREND_KEY_NAMES[TREND_DIFF_RMS], config);
+    }
+    
+    DrawText("0", (int)r.x, (int)(r.y + r.height + 4), 10, config->label_color);
+    const char* end = TrendTimeText(t1);
+    DrawText(end, (int)(r.x + r.width - MeasureText(end, 10)), (int)(r.y + r.height + 4), 10, config->label_color);
+    DrawRectangleLinesEx(r, 2, config->border_color);
+}
+
+// Short sine beep generated in memory, so no asset files are needed
+Sound LoadAlarmSound(void) {
+    static short samples[4410];
+    for (int i = 0; i < 4410; i++) {
+        samples[i] = (short)(8000 * sinf(2.0f * PI * 880.0f * i / 44100.0f));
+    }
+    
+    Wave wave = {0};
+    wave.frameCount = 4410;
+    wave.sampleRate = 44100;
+    wave.sampleSize = 16;
+    wave.channels = 1;
+    wave.data = samples;
+    return LoadSoundFromWave(wave);
+}
+
+
 void PlotViewInit(PlotView* view, Rectangle area) {
     view->area = area;
+    PlotAxesRaw(&view->axes, 12, FRAME_ORIGIN);
     view->auto_scale = false;
+    view->smooth = false;
     view->zoom = 1.0f;
     view->pan_x = 0.0f;
     view->pan_y = 0.0f;
     view->dragging = false;
+    view->excitation = -1;
+    view->sources = 0;
+    view->title = NULL;
+    view->x_min = view->axes.x_min;
+    view->x_max = view->axes.x_max;
+    view->y_min = view->axes.y_min;
+    view->y_max = view->axes.y_max;
+}
+
+// The split layout shows 4.7K, 100K and DUT1 - DUT2 side by side; a single
+// pane follows the excitation mode and draws every channel
+void PlotPanesSetSplit(PlotView* views, bool split) {
+    unsigned curves = ~CURVE_SOURCE_BIT(CURVE_SOURCE_DIFFERENCE);
+    
+    views[0].excitation = split ? 0 : -1;
+    views[0].sources = split ? curves : 0;
+    views[0].title = split ? "4.7K" : NULL;
+    views[1].excitation = 1;
+    views[1].sources = curves;
+    views[1].title = "100K WEAK";
+    views[2].excitation = -1;
+    views[2].sources = CURVE_SOURCE_BIT(CURVE_SOURCE_DIFFERENCE);
+    views[2].title = "DUT1 - DUT2";
+}
+
+int PlotViewExcitation(const PlotView* view, const CurveData* data) {
+    if (view->excitation >= 0) return view->excitation;
+    return data->last_was_weak ? 1 : 0;
+}
+
+// Only views that follow the latest frame draw the other excitation dimmed
+bool PlotViewShowsBoth(const PlotView* view, const CurveData* data) {
+    return view->excitation < 0 && CurveDataAlternating(data);
+}
+
+bool PlotViewShowsChannel(const PlotView* view, const CurveData* data, int channel, bool single_channel) {
+    if (view->sources && !(view->sources & CURVE_SOURCE_BIT(data->channels[channel].source))) return false;
+    return CurveDataChannelShown(data, channel, single_channel);
 }
 
-float MinFloat(float* arr, int count) {
-    if (count == 0) return 0;
-    float min_val = arr[0];
-    for (int i = 1; i < count; i++) {
-        if (arr[i] < min_val) min_val = arr[i];
+// Copies zoom and pan to the other views, as a fraction of each view's own
+// axes since the panes of a calibrated device have different current scales
+void PlotViewLink(PlotView* views, int count, int from) {
+    const PlotView* src = &views[from];
+    float pan_x = src->pan_x / (src->axes.x_max - src->axes.x_min);
+    float pan_y = src->pan_y / (src->axes.y_max - src->axes.y_min);
+    
+    for (int i = 0; i < count; i++) {
+        if (i == from) continue;
+        PlotView* view = &views[i];
+        view->auto_scale = src->auto_scale;
+        view->zoom = src->zoom;
+        view->pan_x = pan_x * (view->axes.x_max - view->axes.x_min);
+        view->pan_y = pan_y * (view->axes.y_max - view->axes.y_min);
     }
-    return min_val;
 }
 
-float MaxFloat(float* arr, int count) {
-    if (count == 0) return 0;
-    float max_val = arr[0];
-    for (int i = 1; i < count; i++) {
-        if (arr[i] > max_val) max_val = arr[i];
+// Subdivides one spline segment into as many steps as its on-screen size needs.
+// The Bezier control polygon bounds the curve, so it gives both the visibility
+// test and how far the piece bows away from its chord in pixels.
+void DrawSplineSegment(const SplineSegment* s, Color color, Rectangle r,
+                       float sx, float ox, float sy, float oy) {
+    float px[4], py[4];
+    px[0] = s->x[0];
+    px[1] = s->x[0] + s->x[1] / 3.0f;
+    px[3] = s->x[0] + s->x[1] + s->x[2] + s->x[3];
+    px[2] = px[3] - (s->x[1] + 2.0f * s->x[2] + 3.0f * s->x[3]) / 3.0f;
+    py[0] = s->y[0];
+    py[1] = s->y[0] + s->y[1] / 3.0f;
+    py[3] = s->y[0] + s->y[1] + s->y[2] + s->y[3];
+    py[2] = py[3] - (s->y[1] + 2.0f * s->y[2] + 3.0f * s->y[3]) / 3.0f;
+    
+    float min_x = 1e30f, max_x = -1e30f, min_y = 1e30f, max_y = -1e30f;
+    for (int k = 0; k < 4; k++) {
+        px[k] = ox + px[k] * sx;
+        py[k] = oy + py[k] * sy;
+        if (px[k] < min_x) min_x = px[k];
+        if (px[k] > max_x) max_x = px[k];
+        if (py[k] < min_y) min_y = py[k];
+        if (py[k] > max_y) max_y = py[k];
+    }
+    
+    Vector2 start = {px[0], py[0]};
+    Vector2 end = {px[3], py[3]};
+    bool visible = max_x >= r.x && min_x <= r.x + r.width && max_y >= r.y && min_y <= r.y + r.height;
+    
+    // Chord error falls with the square of the step count; aim for a quarter pixel
+    float bow = fmaxf(fmaxf(fabsf(px[0] - 2 * px[1] + px[2]), fabsf(px[1] - 2 * px[2] + px[3])),
+                      fmaxf(fabsf(py[0] - 2 * py[1] + py[2]), fabsf(py[1] - 2 * py[2] + py[3])));
+    int steps = visible ? (int)ceilf(sqrtf(bow * 0.75f / 0.25f)) : 1;
+    if (steps > 64) steps = 64;
+    
+    if (steps <= 1) {
+        DrawLineEx(start, end, 1.5f, color);
+        return;
+    }
+    
+    Vector2 prev = start;
+    for (int j = 1; j <= steps; j++) {
+        float t = (float)j / steps;
+        float x = s->x[0] + t * (s->x[1] + t * (s->x[2] + t * s->x[3]));
+        float y = s->y[0] + t * (s->y[1] + t * (s->y[2] + t * s->y[3]));
+        Vector2 next = {ox + x * sx, oy + y * sy};
+        DrawLineEx(prev, next, 1.5f, color);
+        prev = next;
     }
-    return max_val;
 }
 
-void DrawTrace(ChannelData* ch, Color color, Rectangle r, 
+// spline is NULL for plain straight segments between samples
+void DrawTrace(ChannelData* ch, const Spline* spline, Color color, Rectangle r, 
                float x_min, float x_max, float y_min, float y_max) {
+    if (spline && spline->count == ch->count - 1) {
+        // Voltage runs right to left across the plot
+        float sx = -r.width / (x_max - x_min);
+        float ox = r.x + r.width - x_min * sx;
+        float sy = r.height / (y_max - y_min);
+        float oy = r.y - y_min * sy;
+        
+        for (int i = 0; i < spline->count; i++) {
+            DrawSplineSegment(&spline->segments[i], color, r, sx, ox, sy, oy);
+        }
+        return;
+    }
+    
     for (int i = 0; i < ch->count - 1; i++) {
         float x1_norm = (ch->voltage[i] - x_min) / (x_max - x_min);
         float y1_norm = (ch->current[i] - y_min) / (y_max - y_min);
@@ -160,8 +846,11 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
     Rectangle r = view->area;
     
     DrawRectangleRec(r, config->grid_bg);
+    CurveDataUpdateViews(data);
     
-    if (data->ch1_active->count == 0) {
+    int active = PlotViewExcitation(view, data);
+    if (view->title) DrawText(view->title, (int)r.x, (int)(r.y - 20), 16, config->axis_color);
+    if (data->channels[0].view[active].count == 0) {
         DrawText("No Data", (int)(r.x + r.width/2 - 40), (int)(r.y + r.height/2), 20, WHITE);
         return;
     }
@@ -169,27 +858,7 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
     float x_min, x_max, y_min, y_max;
     
     if (view->auto_scale) {
-        float* all_x = malloc(sizeof(float) * MAX_SAMPLES * 2);
-        float* all_y = malloc(sizeof(float) * MAX_SAMPLES * 2);
-        int idx = 0;
-        
-        for (int i = 0; i < data->ch1_active->count; i++) {
-            all_x[idx] = data->ch1_active->voltage[i];
-            all_y[idx] = data->ch1_active->current[i];
-            idx++;
-        }
-        if (!single_channel) {
-            for (int i = 0; i < data->ch2_active->count; i++) {
-                all_x[idx] = data->ch2_active->voltage[i];
-                all_y[idx] = data->ch2_active->current[i];
-                idx++;
-            }
-        }
-        
-        x_min = MinFloat(all_x, idx);
-        x_max = MaxFloat(all_x, idx);
-        y_min = MinFloat(all_y, idx);
-        y_max = MaxFloat(all_y, idx);
+        CurveDataBounds(data, view, single_channel, false, &x_min, &x_max, &y_min, &y_max);
         
         float x_margin = (x_max - x_min) * 0.1f;
         float y_margin = (y_max - y_min) * 0.1f;
@@ -197,15 +866,11 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
         x_max += x_margin;
         y_min -= y_margin;
         y_max += y_margin;
-        
-        free(all_x);
-        free(all_y);
     } else {
-        float base_x_min = 0;
-        float base_x_max = ADC_MAX;
-        float y_range = ADC_MAX - 700;
-        float base_y_max = y_range / 8.0f;
-        float base_y_min = -y_range * 7.0f / 8.0f;
+        float base_x_min = view->axes.x_min;
+        float base_x_max = view->axes.x_max;
+        float base_y_max = view->axes.y_max;
+        float base_y_min = view->axes.y_min;
         
         float x_range_visible = (base_x_max - base_x_min) / view->zoom;
         float y_range_visible = (base_y_max - base_y_min) / view->zoom;
@@ -222,6 +887,11 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
     if (x_max == x_min) x_max = x_min + 1;
     if (y_max == y_min) y_max = y_min + 1;
     
+    view->x_min = x_min;
+    view->x_max = x_max;
+    view->y_min = y_min;
+    view->y_max = y_max;
+    
     for (int i = 0; i <= 10; i++) {
         float x = r.x + (i * r.width) / 10.0f;
         float y = r.y + (i * r.height) / 10.0f;
@@ -229,8 +899,8 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
         DrawLine((int)r.x, (int)y, (int)(r.x + r.width), (int)y, config->grid_color);
     }
     
-    float zero_x_norm = (ADC_ORIGIN - x_min) / (x_max - x_min);
-    float zero_y_norm = (0 - y_min) / (y_max - y_min);
+    float zero_x_norm = (view->axes.x_origin - x_min) / (x_max - x_min);
+    float zero_y_norm = (view->axes.y_origin - y_min) / (y_max - y_min);
     
     if (zero_x_norm >= 0 && zero_x_norm <= 1) {
         float x = r.x + r.width - (zero_x_norm * r.width);
@@ -241,54 +911,151 @@ void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_c
         DrawLine((int)r.x, (int)y, (int)(r.x + r.width), (int)y, config->crosshair);
     }
     
-    if (data->excitation_mode == 2 && data->ch1_std.count > 0 && data->ch1_weak.count > 0) {
-        if (data->last_was_weak) {
-            DrawTrace(&data->ch1_std, config->dut1_dimmed, r, x_min, x_max, y_min, y_max);
-            if (!single_channel) DrawTrace(&data->ch2_std, config->dut2_dimmed, r, x_min, x_max, y_min, y_max);
-            DrawTrace(&data->ch1_weak, config->dut1_trace, r, x_min, x_max, y_min, y_max);
-            if (!single_channel) DrawTrace(&data->ch2_weak, config->dut2_trace, r, x_min, x_max, y_min, y_max);
-        } else {
-            DrawTrace(&data->ch1_weak, config->dut1_dimmed, r, x_min, x_max, y_min, y_max);
-            if (!single_channel) DrawTrace(&data->ch2_weak, config->dut2_dimmed, r, x_min, x_max, y_min, y_max);
-            DrawTrace(&data->ch1_std, config->dut1_trace, r, x_min, x_max, y_min, y_max);
-            if (!single_channel) DrawTrace(&data->ch2_std, config->dut2_trace, r, x_min, x_max, y_min, y_max);
-        }
-    } else {
-        DrawTrace(data->ch1_active, config->dut1_trace, r, x_min, x_max, y_min, y_max);
-        if (!single_channel) {
-            DrawTrace(data->ch2_active, config->dut2_trace, r, x_min, x_max, y_min, y_max);
+    if (view->smooth) CurveDataUpdateSplines(data);
+    
+    // In ALT mode the other excitation of every channel is drawn dimmed underneath
+    bool alternating = PlotViewShowsBoth(view, data);
+    for (int pass = alternating ? 0 : 1; pass < 2; pass++) {
+        int e = pass ? active : 1 - active;
+        for (int c = 0; c < data->channel_count; c++) {
+            if (!PlotViewShowsChannel(view, data, c, single_channel)) continue;
+            CurveChannel* ch = &data->channels[c];
+            DrawTrace(&ch->view[e], view->smooth ? &ch->spline[e] : NULL,
+                      CurveChannelColor(data, c, config, pass == 0), r, x_min, x_max, y_min, y_max);
         }
     }
     
     for (int i = 0; i <= 10; i += 5) {
         float x_val = x_min + (x_max - x_min) * (10 - i) / 10.0f;
         float label_x = r.x + (i * r.width) / 10.0f;
-        DrawText(TextFormat("%d", (int)x_val), (int)(label_x - 20), (int)(r.y + r.height + 10), 16, config->label_color);
+        DrawText(TextFormat(view->axes.tick_format, x_val), (int)(label_x - 20), (int)(r.y + r.height + 10), 16, config->label_color);
         
         float y_val = y_min + (y_max - y_min) * i / 10.0f;
         float label_y = r.y + (i * r.height) / 10.0f;
-        DrawText(TextFormat("%d", (int)y_val), (int)(r.x - 50), (int)(label_y - 6), 16, config->label_color);
+        DrawText(TextFormat(view->axes.tick_format, y_val), (int)(r.x - 50), (int)(label_y - 6), 16, config->label_color);
     }
     
-    DrawText("DUT Voltage", (int)(r.x + r.width/2 - 50), (int)(r.y + r.height + 35), 20, config->axis_color);
-    DrawText("Current", (int)(r.x - 80), (int)(r.y + r.height/2 + 10), 20, config->axis_color);
+    DrawText(view->axes.x_label, (int)(r.x + r.width/2 - 50), (int)(r.y + r.height + 35), 20, config->axis_color);
+    DrawText(view->axes.y_label, (int)(r.x - 80), (int)(r.y + r.height/2 + 10), 20, config->axis_color);
     
     int legend_x = (int)(r.x + 20);
     int legend_y = (int)(r.y + r.height - 40);
     
-    DrawLineEx((Vector2){(float)legend_x, (float)legend_y}, 
-               (Vector2){(float)(legend_x + 40), (float)legend_y}, 4.0f, config->dut1_trace);
-    DrawText("DUT1 (CH1 - Black Lead)", legend_x + 50, legend_y - 6, 12, config->dut1_trace);
-    
-    if (!single_channel) {
-        DrawLineEx((Vector2){(float)legend_x, (float)(legend_y - 30)}, 
-                   (Vector2){(float)(legend_x + 40), (float)(legend_y - 30)}, 4.0f, config->dut2_trace);
-        DrawText("DUT2 (CH2 - Red Lead)", legend_x + 50, legend_y - 36, 12, config->dut2_trace);
+    for (int c = 0; c < data->channel_count; c++) {
+        if (!PlotViewShowsChannel(view, data, c, single_channel)) continue;
+        
+        Color color = CurveChannelColor(data, c, config, false);
+        DrawLineEx((Vector2){(float)legend_x, (float)legend_y}, 
+                   (Vector2){(float)(legend_x + 40), (float)legend_y}, 4.0f, color);
+        DrawText(data->channels[c].name, legend_x + 50, legend_y - 6, 12, color);
+        legend_y -= 30;
     }
     
     DrawRectangleLinesEx(r, 2, config->border_color);
 }
 
+// Point ids pack excitation, channel and sample index
+int CursorIndexProject(SpatialPoint* out, const PlotView* view, const CurveData* data, int e, bool single_channel) {
+    Rectangle r = view->area;
+    float sx = -r.width / (view->x_max - view->x_min);
+    float ox = r.x + r.width - view->x_min * sx;
+    float sy = r.height / (view->y_max - view->y_min);
+    float oy = r.y - view->y_min * sy;
+    int count = 0;
+    
+    for (int c = 0; c < data->channel_count; c++) {
+        if (!PlotViewShowsChannel(view, data, c, single_channel)) continue;
+        
+        const ChannelData* ch = &data->channels[c].view[e];
+        uint32_t base = (uint32_t)((e * CURVE_MAX_CHANNELS + c) * MAX_SAMPLES);
+        for (int i = 0; i < ch->count; i++) {
+            float x = ox + ch->voltage[i] * sx;
+            float y = oy + ch->current[i] * sy;
+            if (x < r.x || x > r.x + r.width || y < r.y || y > r.y + r.height) continue;
+            out[count++] = (SpatialPoint){x, y, base + (uint32_t)i};
+        }
+    }
+    return count;
+}
+
+// Call after PlotViewDraw so the range matches what is on screen
+void CursorIndexUpdate(CursorIndex* index, const PlotView* view, CurveData* data, bool single_channel) {
+    CurveDataUpdateViews(data);
+    
+    float range[4] = {view->x_min, view->x_max, view->y_min, view->y_max};
+    bool moved = memcmp(range, index->range, sizeof(range)) != 0 ||
+                 memcmp(&view->area, &index->area, sizeof(Rectangle)) != 0 ||
+                 single_channel != index->single_channel || view != index->view;
+    bool alternating = PlotViewShowsBoth(view, data);
+    int active = PlotViewExcitation(view, data);
+    bool changed = false;
+    
+    for (int e = 0; e < 2; e++) {
+        bool shown = alternating || e == active;
+        if (!moved && shown == index->layer_shown[e] && index->generation[e] == data->generation[e]) continue;
+        
+        index->layer_count[e] = shown ? CursorIndexProject(index->layers[e], view, data, e, single_channel) : 0;
+        index->layer_shown[e] = shown;
+        index->generation[e] = data->generation[e];
+        changed = true;
+    }
+    if (!changed) return;
+    
+    memcpy(index->range, range, sizeof(range));
+    index->area = view->area;
+    index->view = view;
+    index->single_channel = single_channel;
+    
+    const SpatialPoint* lists[2] = {index->layers[0], index->layers[1]};
+    SpatialGridBuild(&index->grid, view->area.x, view->area.y, view->area.width, view->area.height, CURSOR_CELL,
+                     lists, index->layer_count, 2);
+}
+
+void DrawCursorReadout(const CursorIndex* index, const PlotView* view, const CurveData* data, const Config* config) {
+    Vector2 mouse = GetMousePosition();
+    Rectangle r = view->area;
+    if (!CheckCollisionPointRec(mouse, r)) return;
+    
+    Color line = Fade(config->label_color, 0.3f);
+    DrawLine((int)mouse.x, (int)r.y, (int)mouse.x, (int)(r.y + r.height), line);
+    DrawLine((int)r.x, (int)mouse.y, (int)(r.x + r.width), (int)mouse.y, line);
+    
+    SpatialPoint hit;
+    if (!SpatialGridNearest(&index->grid, mouse.x, mouse.y, 30.0f, &hit)) return;
+    
+    int sample = (int)(hit.id % MAX_SAMPLES);
+    int c = (int)(hit.id / MAX_SAMPLES % CURVE_MAX_CHANNELS);
+    int e = (int)(hit.id / MAX_SAMPLES / CURVE_MAX_CHANNELS);
+    if (c >= data->channel_count) return;
+    
+    const CurveChannel* ch = &data->channels[c];
+    Color color = CurveChannelColor(data, c, config, false);
+    DrawCircleLines((int)hit.x, (int)hit.y, 5, color);
+    
+    // TextFormat rotates through four static buffers, so three lines can be held at once
+    const char* lines[3] = {
+        TextFormat("%s  %s", ch->name, e ? "100K" : "4.7K"),
+        TextFormat("%s: %.4g   %s: %.4g", view->axes.x_label, ch->view[e].voltage[sample],
+                   view->axes.y_label, ch->view[e].current[sample]),
+        TextFormat("frame %u  sample %d", ch->frame[e], sample)
+    };
+    
+    int width = 0;
+    for (int i = 0; i < 3; i++) {
+        int w = MeasureText(lines[i], 12);
+        if (w > width) width = w;
+    }
+    Rectangle box = {hit.x + 12, hit.y + 12, (float)(width + 12), 48};
+    if (box.x + box.width > r.x + r.width) box.x = hit.x - 12 - box.width;
+    if (box.y + box.height > r.y + r.height) box.y = hit.y - 12 - box.height;
+    
+    DrawRectangleRec(box, Fade(config->grid_bg, 0.9f));
+    DrawRectangleLinesEx(box, 1, color);
+    for (int i = 0; i < 3; i++) {
+        DrawText(lines[i], (int)box.x + 6, (int)box.y + 5 + i * 14, 12, i ? config->label_color : color);
+    }
+}
+
 void PlotViewHandleZoom(PlotView* view, float wheel) {
     if (!view->auto_scale) {
         if (wheel > 0) {
@@ -307,58 +1074,14 @@ void PlotViewReset(PlotView* view) {
 }
 
 void PlotViewFitData(PlotView* view, CurveData* data, bool single_channel) {
-    if (data->ch1_active->count == 0) return;
-    
-    float* all_x = malloc(sizeof(float) * MAX_SAMPLES * 4);
-    float* all_y = malloc(sizeof(float) * MAX_SAMPLES * 4);
-    int idx = 0;
+    bool alternating = PlotViewShowsBoth(view, data);
     
-    if (data->excitation_mode == 2 && data->ch1_std.count > 0 && data->ch1_weak.count > 0) {
-        for (int i = 0; i < data->ch1_std.count; i++) {
-            all_x[idx] = data->ch1_std.voltage[i];
-            all_y[idx] = data->ch1_std.current[i];
-            idx++;
-        }
-        for (int i = 0; i < data->ch1_weak.count; i++) {
-            all_x[idx] = data->ch1_weak.voltage[i];
-            all_y[idx] = data->ch1_weak.current[i];
-            idx++;
-        }
-        if (!single_channel) {
-            for (int i = 0; i < data->ch2_std.count; i++) {
-                all_x[idx] = data->ch2_std.voltage[i];
-                all_y[idx] = data->ch2_std.current[i];
-                idx++;
-            }
-            for (int i = 0; i < data->ch2_weak.count; i++) {
-                all_x[idx] = data->ch2_weak.voltage[i];
-                all_y[idx] = data->ch2_weak.current[i];
-                idx++;
-            }
-        }
-    } else {
-        for (int i = 0; i < data->ch1_active->count; i++) {
-            all_x[idx] = data->ch1_active->voltage[i];
-            all_y[idx] = data->ch1_active->current[i];
-            idx++;
-        }
-        if (!single_channel) {
-            for (int i = 0; i < data->ch2_active->count; i++) {
-                all_x[idx] = data->ch2_active->voltage[i];
-                all_y[idx] = data->ch2_active->current[i];
-                idx++;
-            }
-        }
+    float data_x_min, data_x_max, data_y_min, data_y_max;
+    if (!CurveDataBounds(data, view, single_channel, alternating,
+                         &data_x_min, &data_x_max, &data_y_min, &data_y_max)) {
+        return;
     }
     
-    float data_x_min = MinFloat(all_x, idx);
-    float data_x_max = MaxFloat(all_x, idx);
-    float data_y_min = MinFloat(all_y, idx);
-    float data_y_max = MaxFloat(all_y, idx);
-    
-    free(all_x);
-    free(all_y);
-    
     float x_margin = (data_x_max - data_x_min) * 0.2f;
     float y_margin = (data_y_max - data_y_min) * 0.2f;
     data_x_min -= x_margin;
@@ -369,11 +1092,10 @@ void PlotViewFitData(PlotView* view, CurveData* data, bool single_channel) {
     float data_x_range = data_x_max - data_x_min;
     float data_y_range = data_y_max - data_y_min;
     
-    float base_x_min = 0;
-    float base_x_max = ADC_MAX;
-    float y_range = ADC_MAX - 700;
-    float base_y_max = y_range / 8.0f;
-    float base_y_min = -y_range * 7.0f / 8.0f;
+    float base_x_min = view->axes.x_min;
+    float base_x_max = view->axes.x_max;
+    float base_y_max = view->axes.y_max;
+    float base_y_min = view->axes.y_min;
     
     float base_x_range = base_x_max - base_x_min;
     float base_y_range = base_y_max - base_y_min;
@@ -394,79 +1116,413 @@ void PlotViewFitData(PlotView* view, CurveData* data, bool single_channel) {
     view->pan_y = data_y_center - base_y_center;
 }
 
-bool AcquireData(SerialPort* port, CurveData* data) {
-    if (!port->is_open) return false;
+void LogRoundTrip(const char* stage, char cmd, SerialRoundTrip rtt) {
+    TraceLog(LOG_INFO, "SERIAL: %s '%c' round trip: avg %.2f ms, min %.2f ms, max %.2f ms (%d samples)",
+             stage, cmd, rtt.avg_ms, rtt.min_ms, rtt.max_ms, rtt.samples);
+}
+
+void LoadCalibration(const char* device, CalibrationTable* calib) {
+    char serial[64];
+    CalibrationProfile profile;
     
-    char cmd;
-    bool store_as_weak;
+    calib->valid = false;
+    if (!SerialGetUsbSerial(device, serial, sizeof(serial))) return;
     
-    if (data->excitation_mode == 0) {
-        cmd = 'T';
-        store_as_weak = false;
-    } else if (data->excitation_mode == 1) {
-        cmd = 'W';
-        store_as_weak = true;
+    if (CalibrationLoadProfile("calibration.cfg", serial, &profile)) {
+        CalibrationBuild(calib, &profile);
+        TraceLog(LOG_INFO, "CALIB: Loaded profile for %s", serial);
     } else {
-        if (data->alt_use_weak) {
-            cmd = 'W';
-            store_as_weak = true;
-        } else {
-            cmd = 'T';
-            store_as_weak = false;
+        snprintf(calib->profile.serial, sizeof(calib->profile.serial), "%s", serial);
+        TraceLog(LOG_INFO, "CALIB: No profile for %s, showing raw counts", serial);
+    }
+}
+
+// The firmware cannot report its frame layout, so it comes from the config
+void LoadFrameGeometry(const Config* config, FrameGeometry* geometry) {
+    geometry->samples = config->frame_samples;
+    geometry->channels = config->frame_channels;
+    geometry->bits = config->frame_bits;
+    geometry->origin = config->frame_origin;
+    
+    if (!FrameGeometryValid(geometry)) {
+        TraceLog(LOG_WARNING, "FRAME: Invalid geometry %d x %d at %d bits, origin %d; using the default",
+                 geometry->samples, geometry->channels, geometry->bits, geometry->origin);
+        FrameGeometryDefault(geometry);
+    }
+    TraceLog(LOG_INFO, "FRAME: %d samples x %d channels, %d bits, origin %d (%s decoder)",
+             geometry->samples, geometry->channels, geometry->bits, geometry->origin,
+             FrameGeometryIsSpecialized(geometry) ? "specialized" : "generic");
+}
+
+bool OpenDevice(SerialPort* port, const Config* config, const FrameParser* parser) {
+    if (!SerialOpen(port, config->serial_port, config->baud_rate)) return false;
+    if (!config->low_latency) return true;
+    
+    const char cmds[] = {'T', 'W'};
+    SerialRoundTrip before[2];
+    for (int i = 0; i < 2; i++) {
+        before[i] = SerialMeasureRoundTrip(port, cmds[i], parser->frame_bytes, 10);
+    }
+    
+    if (!SerialSetLowLatency(port, config->baud_rate, parser->frame_bytes)) {
+        TraceLog(LOG_WARNING, "SERIAL: Low latency mode not available on %s", config->serial_port);
+        return true;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        LogRoundTrip("Default", cmds[i], before[i]);
+        LogRoundTrip("Low latency", cmds[i], SerialMeasureRoundTrip(port, cmds[i], parser->frame_bytes, 10));
+    }
+    
+    return true;
+}
+
+bool StartRecording(Recorder* rec) {
+    char path[64];
+    time_t now = time(NULL);
+    strftime(path, sizeof(path), "capture_%Y%m%d_%H%M%S.cbc", localtime(&now));
+    
+    MutexLock(&rec->lock);
+    bool ok = CaptureWriterOpen(&rec->capture, path, CODEC_DELTA);
+    if (ok) {
+        rec->start_us = (uint64_t)(SerialGetTimeMs() * 1000.0);
+        
+        // Metrics go next to the capture, one row per channel and frame
+        rec->metrics_log = fopen(TextFormat("%s.metrics.csv", path), "w");
+        if (rec->metrics_log) MetricsWriteCsvHeader(rec->metrics_log);
+        
+        // Without a summary the capture still works, review rebuilds it on open
+        if (!SummaryWriterOpen(&rec->summary, TextFormat("%s.sum", path))) {
+            TraceLog(LOG_WARNING, "CAPTURE: Could not create %s.sum", path);
         }
-        data->alt_use_weak = !data->alt_use_weak;
     }
+    MutexUnlock(&rec->lock);
     
-    SerialFlush(port);
-    SerialWrite(port, &cmd, 1);
+    if (!ok) TraceLog(LOG_WARNING, "CAPTURE: Could not create %s", path);
+    return ok;
+}
+
+void StopRecording(Recorder* rec) {
+    MutexLock(&rec->lock);
+    CaptureWriterClose(&rec->capture);
+    SummaryWriterClose(&rec->summary);
+    if (rec->metrics_log) fclose(rec->metrics_log);
+    rec->metrics_log = NULL;
+    MutexUnlock(&rec->lock);
+}
+
+void RecorderSink(void* ctx, const PipelineFrame* frame) {
+    Recorder* rec = ctx;
     
-    uint8_t buffer[2016];
-    int total_read = 0;
-    clock_t start = clock();
+    MutexLock(&rec->lock);
     
-    while (total_read < 2016) {
-        if ((clock() - start) * 1000 / CLOCKS_PER_SEC > 1000) break;
+    // Frames queued before recording started are not part of it
+    if (rec->capture.file && frame->timestamp_us >= rec->start_us) {
+        CaptureFrameInfo info = {
+            frame->timestamp_us - rec->start_us,
+            (uint32_t)frame->sequence,
+            (uint8_t)frame->excitation
+        };
+        uint64_t offset = rec->capture.bytes;
+        if (CaptureWriterAppend(&rec->capture, &frame->frame, &info)) {
+            FrameSamples samples;
+            FrameSplit(&frame->frame, &samples);
+            SummaryWriterAdd(&rec->summary, offset, &samples, frame->excitation);
+        } else {
+            TraceLog(LOG_WARNING, "CAPTURE: Write failed, recording stopped");
+            CaptureWriterClose(&rec->capture);
+            SummaryWriterClose(&rec->summary);
+        }
         
-        int n = SerialRead(port, buffer + total_read, 2016 - total_read);
-        if (n > 0) total_read += n;
+        if (rec->metrics_log) {
+            for (int c = 0; c < 2; c++) {
+                MetricsWriteCsvRow(rec->metrics_log, (uint32_t)frame->sequence, frame->excitation, c, &frame->metrics[c]);
+            }
+        }
+    }
+    
+    MutexUnlock(&rec->lock);
+}
+
+bool StartTextExport(LiveExport* live, const Config* config) {
+    TextExportParams params = {0};
+    if (!TextExportParseFormat(config->export_format, &params.format)) {
+        TraceLog(LOG_WARNING, "EXPORT: Unknown format %s, use csv or jsonl", config->export_format);
+        return false;
+    }
+    params.samples = config->export_samples;
+    params.rotate_bytes = (uint64_t)config->export_rotate_mb * 1024 * 1024;
+    params.rotate_us = (uint64_t)config->export_rotate_minutes * 60 * 1000000;
+    
+    char base[64];
+    time_t now = time(NULL);
+    strftime(base, sizeof(base), "export_%Y%m%d_%H%M%S", localtime(&now));
+    
+    MutexLock(&live->lock);
+    bool ok = TextExporterOpen(&live->exporter, base, &params);
+    if (ok) {
+        live->start_us = (uint64_t)(SerialGetTimeMs() * 1000.0);
+        live->active = true;
     }
+    MutexUnlock(&live->lock);
+    
+    if (!ok) TraceLog(LOG_WARNING, "EXPORT: Out of memory");
+    return ok;
+}
+
+void StopTextExport(LiveExport* live) {
+    MutexLock(&live->lock);
+    if (live->active && live->exporter.write_errors) {
+        TraceLog(LOG_WARNING, "EXPORT: Write failed on %s", live->exporter.path);
+    }
+    TextExporterClose(&live->exporter);
+    live->active = false;
+    MutexUnlock(&live->lock);
+}
+
+void TextExportSink(void* ctx, const PipelineFrame* frame) {
+    LiveExport* live = ctx;
     
-    if (total_read != 2016) return false;
+    MutexLock(&live->lock);
+    if (live->active && frame->timestamp_us >= live->start_us) {
+        TextExporterAdd(&live->exporter, frame->sequence, frame->timestamp_us - live->start_us,
+                        frame->excitation, &frame->frame, frame->metrics);
+    }
+    MutexUnlock(&live->lock);
+}
+
+// A summary left behind by a crash stops short of the capture
+bool ReviewSummaryComplete(Review* review) {
+    const Summary* s = &review->summary;
+    const SummaryBucket* last = &s->levels[0][s->counts[0] - 1];
+    
+    if (!CaptureReaderSeek(&review->reader, last->offset)) return false;
+    for (uint32_t i = 0; i < last->count; i++) {
+        if (!CaptureReaderSkip(&review->reader)) return false;
+    }
+    return !CaptureReaderSkip(&review->reader);
+}
+
+void ReviewClose(Review* review) {
+    CaptureReaderClose(&review->reader);
+    SummaryFree(&review->summary);
+    review->active = false;
+    review->scrubbing = false;
+}
+
+bool ReviewOpen(Review* review, const char* path) {
+    ReviewClose(review);
     
-    uint16_t values[1008];
-    for (int i = 0; i < 1008; i++) {
-        values[i] = (buffer[i*2+1] << 8) | buffer[i*2];
-        values[i] &= 0x0FFF;
+    if (!CaptureReaderOpen(&review->reader, path)) {
+        TraceLog(LOG_WARNING, "REVIEW: Could not open %s", path);
+        return false;
     }
     
-    ChannelData* ch1_dest = store_as_weak ? &data->ch1_weak : &data->ch1_std;
-    ChannelData* ch2_dest = store_as_weak ? &data->ch2_weak : &data->ch2_std;
+    char summary_path[300];
+    snprintf(summary_path, sizeof(summary_path), "%s.sum", path);
     
-    ch1_dest->count = 0;
-    ch2_dest->count = 0;
+    bool loaded = SummaryLoad(&review->summary, summary_path);
+    if (!loaded || !ReviewSummaryComplete(review)) {
+        SummaryFree(&review->summary);
+        TraceLog(LOG_INFO, "REVIEW: Building summary for %s", path);
+        loaded = SummaryBuild(path, summary_path) && SummaryLoad(&review->summary, summary_path);
+    }
     
-    for (int i = 0; i < 336; i++) {
-        uint16_t drive = values[i * 3];
-        uint16_t ch1_raw = values[i * 3 + 1];
-        uint16_t ch2_raw = values[i * 3 + 2];
-        
-        ch1_dest->voltage[ch1_dest->count] = (float)ch1_raw;
-        ch1_dest->current[ch1_dest->count] = (float)(drive - ch1_raw);
-        ch1_dest->count++;
+    if (!loaded || review->summary.frames == 0) {
+        TraceLog(LOG_WARNING, "REVIEW: No frames in %s", path);
+        ReviewClose(review);
+        return false;
+    }
+    
+    snprintf(review->path, sizeof(review->path), "%s", path);
+    review->frame = 0;
+    review->active = true;
+    return true;
+}
+
+bool ReviewShowFrame(Review* review, uint32_t index, CurveData* data, RawFrame* frame) {
+    if (index >= review->summary.frames) index = review->summary.frames - 1;
+    
+    // Seek to the bucket, then hop over record headers instead of decoding up to the frame
+    uint64_t offset;
+    uint32_t skip;
+    if (!SummaryLocate(&review->summary, index, &offset, &skip)) return false;
+    if (!CaptureReaderSeek(&review->reader, offset)) return false;
+    for (uint32_t i = 0; i < skip; i++) {
+        if (!CaptureReaderSkip(&review->reader)) return false;
+    }
+    if (!CaptureReaderNext(&review->reader, frame, &review->info)) return false;
+    
+    review->frame = index;
+    CurveDataStore(data, frame, review->info.excitation != 0);
+    data->frame_index[review->info.excitation != 0] = index;
+    CurveDataUpdateMetrics(data, review->info.excitation != 0);
+    return true;
+}
+
+void DrawTimeline(Rectangle r, const Review* review, const Config* config) {
+    const Summary* s = &review->summary;
+    Color colors[2] = {config->dut1_trace, config->dut2_trace};
+    
+    DrawRectangleRec(r, config->grid_bg);
+    
+    // Scale to the whole recording so the band does not jump while scrubbing
+    float lo = INFINITY, hi = -INFINITY, min, max, mean;
+    for (int c = 0; c < 2; c++) {
+        if (SummaryQuery(s, 0, s->frames, review->key * 2 + c, &min, &max, &mean)) {
+            if (min < lo) lo = min;
+            if (max > hi) hi = max;
+        }
+    }
+    if (!(hi > lo)) hi = lo + 1;
+    
+    int width = (int)r.width;
+    for (int px = 0; px < width && lo <= hi; px++) {
+        uint32_t first = (uint32_t)((uint64_t)px * s->frames / width);
+        uint32_t last = (uint32_t)((uint64_t)(px + 1) * s->frames / width);
         
-        ch2_dest->voltage[ch2_dest->count] = (float)ch2_raw;
-        ch2_dest->current[ch2_dest->count] = (float)(drive - ch2_raw);
-        ch2_dest->count++;
+        for (int c = 0; c < 2; c++) {
+            if (!SummaryQuery(s, first, last, review->key * 2 + c, &min, &max, &mean)) continue;
+            
+            int x = (int)r.x + px;
+            float y_min = r.y + r.height - (min - lo) / (hi - lo) * r.height;
+            float y_max = r.y + r.height - (max - lo) / (hi - lo) * r.height;
+            float y_mean = r.y + r.height - (mean - lo) / (hi - lo) * r.height;
+            DrawLine(x, (int)y_max, x, (int)y_min + 1, Fade(colors[c], 0.4f));
+            DrawPixel(x, (int)y_mean, colors[c]);
+        }
     }
     
-    data->last_was_weak = store_as_weak;
-    data->ch1_active = store_as_weak ? &data->ch1_weak : &data->ch1_std;
-    data->ch2_active = store_as_weak ? &data->ch2_weak : &data->ch2_std;
+    float cursor_x = r.x + r.width * review->frame / (s->frames > 1 ? s->frames - 1 : 1);
+    DrawLine((int)cursor_x, (int)r.y, (int)cursor_x, (int)(r.y + r.height), config->crosshair);
+    
+    DrawText(TextFormat("REVIEW %s  frame %u/%u  seq %u  t=%.2fs  [%s]  K=key LEFT/RIGHT=step V=close",
+                        review->path, review->frame + 1, s->frames, review->info.sequence,
+                        review->info.timestamp_us / 1e6, SUMMARY_KEY_NAMES[review->key]),
+             (int)r.x, (int)(r.y - 16), 12, config->label_color);
+    DrawRectangleLinesEx(r, 2, config->border_color);
+}
+
+bool StartSequence(Sequencer* seq, const char* plan_path, const FrameGeometry* geometry) {
+    static SequencePlan plan;
+    if (!plan_path[0] || !SequencePlanLoad(&plan, plan_path)) {
+        TraceLog(LOG_WARNING, "SEQUENCE: Could not load test plan '%s'", plan_path);
+        return false;
+    }
     
+    char path[64];
+    time_t now = time(NULL);
+    strftime(path, sizeof(path), "sequence_%Y%m%d_%H%M%S.csv", localtime(&now));
+    if (!SequenceStart(seq, &plan, geometry, path, GetTime())) return false;
+    
+    int missing = 0;
+    for (int i = 0; i < plan.point_count * 2; i++) missing += !seq->has_reference[i];
+    TraceLog(LOG_INFO, "SEQUENCE: %s, %d points, results in %s%s", plan.board, plan.point_count, path,
+             missing ? ", teaching missing references" : "");
     return true;
 }
 
-int main(void) {
+// Prompt for the current test point, the last result and the throughput
+void DrawSequencePanel(Rectangle r, const Sequencer* seq, const Config* config) {
+    const SequencePlan* plan = &seq->plan;
+    Rectangle box = {r.x + r.width / 2 - 270, r.y + 40, 540, 96};
+    int x = (int)box.x + 10;
+    int y = (int)box.y + 8;
+    
+    DrawRectangleRec(box, Fade(config->grid_bg, 0.9f));
+    DrawRectangleLinesEx(box, 2, config->border_color);
+    
+    if (seq->state == SEQUENCE_DONE) {
+        DrawText(TextFormat("%s done: %d pass, %d fail", plan->board, seq->passed, seq->failed),
+                 x, y, 24, seq->failed ? RED : GREEN);
+        DrawText("N = next board", x, y + 30, 16, config->label_color);
+    } else {
+        const char* hint = seq->state == SEQUENCE_RELEASE ? "Lift the probe" :
+                           seq->touching ? "Hold still" : "Probe this point";
+        DrawText(TextFormat("%d/%d  %s", seq->point + 1, plan->point_count, plan->points[seq->point].name),
+                 x, y, 24, config->axis_color);
+        DrawText(TextFormat("%s   (RIGHT = skip, N = stop)", hint), x, y + 30, 16, config->label_color);
+    }
+    
+    if (seq->point > 0) {
+        const SequenceResult* last = &seq->results[seq->point - 1];
+        Color color = last->outcome == SEQUENCE_PASS ? GREEN : last->outcome == SEQUENCE_FAIL ? RED : ORANGE;
+        DrawText(TextFormat("%s: %s  deviation %.1f / %g", plan->points[seq->point - 1].name,
+                            SEQUENCE_OUTCOME_NAMES[last->outcome], last->worst, plan->points[seq->point - 1].limit),
+                 x, y + 52, 14, color);
+        DrawText(TextFormat("%.1f points/min   operator %.2f s   acquire %.2f s",
+                            SequencePointsPerMinute(seq), last->operator_s, last->acquire_s),
+                 x, y + 70, 14, config->label_color);
+    }
+}
+
+void TriggerSink(void* ctx, const PipelineFrame* frame) {
+    TriggerMonitor* mon = ctx;
+    
+    if (!mon->armed) {
+        if (mon->was_armed) TriggerReset(&mon->trigger);
+        mon->was_armed = false;
+        return;
+    }
+    mon->was_armed = true;
+    
+    FrameSamples samples;
+    FrameSplit(&frame->frame, &samples);
+    CaptureFrameInfo info = {frame->timestamp_us, (uint32_t)frame->sequence, (uint8_t)frame->excitation};
+    TriggerProcess(&mon->trigger, &frame->frame, &samples, &info);
+}
+
+void ShmSink(void* ctx, const PipelineFrame* frame) {
+    FrameSamples samples;
+    FrameSplit(&frame->frame, &samples);
+    ShmRingPublish(ctx, &samples, frame->excitation, frame->timestamp_us);
+}
+
+void ControlSink(void* ctx, const PipelineFrame* frame) {
+    ControlServerPublish(ctx, &frame->frame, frame->sequence, frame->timestamp_us,
+                         frame->excitation, frame->metrics);
+}
+
+// Locks what every frame is decoded into and prefaults the rings frames are
+// queued on, so neither takes page faults once acquisition is running
+void PrepareRealtimeMemory(RealtimeStatus* status, Acquirer* acquirer, FrameParser* parser,
+                           Pipeline* pipeline, Trend* trend, ShmRing* ring) {
+    RealtimeLock(status, parser, sizeof(*parser));
+    RealtimeLock(status, acquirer, sizeof(*acquirer));
+    if (acquirer->slots) RealtimePrefault(status, acquirer->slots, acquirer->slot_size * ACQUIRE_QUEUE);
+    for (int i = 0; i < pipeline->sink_count; i++) {
+        PipelineSink* sink = &pipeline->sinks[i];
+        RealtimePrefault(status, sink->slots, sink->capacity * sink->slot_size);
+    }
+    if (trend->pool) {
+        RealtimePrefault(status, trend->pool, sizeof(TrendBucket) * TREND_MAX_LEVELS * TREND_LEVEL_BUCKETS);
+    }
+    if (ring->header) RealtimePrefault(status, ring->header, ring->size);
+}
+
+void LogJitter(const RealtimeJitter* jitter, const RealtimeStatus* status) {
+    double mean_ms = jitter->intervals ? jitter->interval_sum_us / 1000.0 / jitter->intervals : 0.0;
+    TraceLog(LOG_INFO, "JITTER: %s, %llu intervals, mean %.2f ms, longest %.2f ms, worst jitter %.2f ms, %llu timeouts",
+             status->policy, (unsigned long long)jitter->intervals, mean_ms, jitter->interval_max_us / 1000.0,
+             jitter->jitter_max_us / 1000.0, (unsigned long long)jitter->misses);
+    
+    uint32_t lower = 0;
+    for (int b = 0; b < REALTIME_JITTER_BUCKETS; b++) {
+        if (jitter->counts[b]) {
+            double percent = 100.0 * jitter->counts[b] / jitter->samples;
+            if (b < REALTIME_JITTER_BUCKETS - 1) {
+                TraceLog(LOG_INFO, "JITTER: %6u - %6u us %10llu  %5.1f%%", lower, REALTIME_JITTER_LIMITS_US[b],
+                         (unsigned long long)jitter->counts[b], percent);
+            } else {
+                TraceLog(LOG_INFO, "JITTER: %6u us and up  %10llu  %5.1f%%", lower,
+                         (unsigned long long)jitter->counts[b], percent);
+            }
+        }
+        if (b < REALTIME_JITTER_BUCKETS - 1) lower = REALTIME_JITTER_LIMITS_US[b];
+    }
+}
+
+int main(int argc, char** argv) {
     Config config;
     ConfigLoad(&config, "curvebug.cfg");
     
@@ -476,33 +1532,129 @@ int main(void) {
     SetTargetFPS(60);
     
     SerialPort port = {0};
-    bool connected = SerialOpen(&port, config.serial_port, 115200);
+    static FrameParser parser;
+    FrameParserInit(&parser);
+    FrameGeometry geometry;
+    LoadFrameGeometry(&config, &geometry);
+    
+    // --replay <capture> [iterations] plays a capture as if it came from the
+    // device. It brings its own geometry, which the queues below are sized for.
+    static Replay replay;
+    bool replaying = argc > 2 && strcmp(argv[1], "--replay") == 0;
+    if (replaying) {
+        uint64_t iterations = argc > 3 ? strtoull(argv[3], NULL, 10) : 0;
+        if (ReplayOpen(&replay, argv[2], iterations)) {
+            // The capture's own geometry, whatever the config says
+            geometry = replay.geometry;
+            TraceLog(LOG_INFO, "REPLAY: %s through the parser, %s", argv[2],
+                     iterations ? TextFormat("exiting after %llu iterations", (unsigned long long)iterations)
+                                : "until closed");
+        } else {
+            TraceLog(LOG_WARNING, "REPLAY: Could not open %s", argv[2]);
+        }
+    }
+    FrameParserSetGeometry(&parser, &geometry);
+    RawFrame frame;
+    
+    static Recorder recorder;
+    MutexInit(&recorder.lock);
+    bool show_metrics = true;
+    bool show_diff = false;
+    
+    ShmRing ring = {0};
+    if (config.shm_ring && !ShmRingCreate(&ring, SHM_RING_DEFAULT_NAME)) {
+        TraceLog(LOG_WARNING, "SHM: Could not create %s", SHM_RING_DEFAULT_NAME);
+    }
     
-    CurveData data = {0};
-    data.ch1_active = &data.ch1_std;
-    data.ch2_active = &data.ch2_std;
+    static ControlServer control;
+    if (config.control_socket[0] && !ControlServerStart(&control, config.control_socket, &geometry)) {
+        TraceLog(LOG_WARNING, "CONTROL: Could not listen on %s", config.control_socket);
+    }
+    
+    // The recorder keeps a gapless prefix if the disk stalls for longer than the
+    // queue covers; live consumers only care about the latest frames
+    static Pipeline pipeline;
+    PipelineInit(&pipeline, &geometry);
+    PipelineAddSink(&pipeline, "recorder", PIPELINE_DROP_NEWEST, 512, RecorderSink, &recorder);
+    
+    static LiveExport live_export;
+    MutexInit(&live_export.lock);
+    PipelineAddSink(&pipeline, "export", PIPELINE_DROP_NEWEST, 512, TextExportSink, &live_export);
+    
+    static TriggerMonitor monitor;
+    TriggerParams trigger_params = {
+        config.trigger_max_dev, config.trigger_mean_dev, config.trigger_pre, config.trigger_post
+    };
+    if (!TriggerInit(&monitor.trigger, &trigger_params, &geometry)) {
+        TraceLog(LOG_WARNING, "TRIGGER: Out of memory, events are saved without pre-trigger frames");
+    }
+    PipelineAddSink(&pipeline, "trigger", PIPELINE_DROP_NEWEST, 64, TriggerSink, &monitor);
+    if (ring.header) PipelineAddSink(&pipeline, "shm", PIPELINE_DROP_OLDEST, 16, ShmSink, &ring);
+    if (control.running) PipelineAddSink(&pipeline, "control", PIPELINE_DROP_OLDEST, 16, ControlSink, &control);
+    
+    InitAudioDevice();
+    Sound alarm_sound = LoadAlarmSound();
+    bool connected = OpenDevice(&port, &config, &parser);
+    
+    static CalibrationTable calib;
+    LoadCalibration(config.serial_port, &calib);
+    
+    static CurveData data;
+    CurveDataInit(&data);
+    if (!CurveDataReserve(&data, geometry.samples)) TraceLog(LOG_WARNING, "PLOT: Out of memory for the curves");
+    data.calib = &calib;
+    data.diff_params.window = config.diff_window;
+    data.diff_params.rms_alarm = config.diff_rms_alarm;
+    data.diff_params.max_alarm = config.diff_max_alarm;
     data.excitation_mode = 0;
     
-    PlotView view;
-    PlotViewInit(&view, (Rectangle){150, 100, 900, 800});
+    PlotView views[PLOT_MAX_PANES];
+    for (int i = 0; i < PLOT_MAX_PANES; i++) {
+        PlotViewInit(&views[i], (Rectangle){150, 100, 900, 800});
+        views[i].smooth = config.smooth_traces;
+    }
+    PlotPanesSetSplit(views, false);
+    int pane_count = 1;
+    int focus = 0;              // Pane under the mouse, which takes zoom, pan and the cursor readout
+    bool link_views = true;     // Zoom and pan in one pane apply to all of them
+    int split_mode = 0;         // Excitation mode to restore when leaving the split layout
+    
+    static CursorIndex cursor;
+    SpatialGridInit(&cursor.grid, 2 * CURVE_MAX_CHANNELS * MAX_SAMPLES, CURSOR_MAX_CELLS);
+    
+    static Trend trend;
+    if (!TrendInit(&trend)) TraceLog(LOG_WARNING, "TREND: Out of memory, trend strip disabled");
+    bool show_trend = false;
+    float trend_probe = NAN;    // Voltage the current trend is read at, plot units
+    
+    static Sequencer sequencer;
+    int sequence_mode = 0;      // Excitation mode to restore when the sequencer stops
     
     bool paused = false;
     bool single_channel = false;
     bool show_settings = false;
+    int derived_trace = 0;      // 0 = none, 1 = DUT1 - DUT2, 2 = average
     int frame_count = 0;
     
-    float acquire_timer = 0;
+    // A capture given on the command line opens straight into review
+    static Review review;
+    if (!replaying && argc > 1 && ReviewOpen(&review, argv[1])) {
+        ReviewShowFrame(&review, 0, &data, &frame);
+    }
     
     // Settings state
     SettingsTab active_tab = TAB_GENERAL;
     char port_edit[256];
     char width_edit[32];
     char height_edit[32];
+    char baud_edit[32];
     char keybind_edits[8][32];
+    bool low_latency_edit = config.low_latency;
     
     bool port_edit_mode = false;
     bool width_edit_mode = false;
     bool height_edit_mode = false;
+    bool baud_edit_mode = false;
     bool keybind_edit_mode[8] = {false};
     
     int active_color_picker = -1;
@@ -510,30 +1662,155 @@ int main(void) {
     strcpy(port_edit, config.serial_port);
     snprintf(width_edit, sizeof(width_edit), "%d", config.window_width);
     snprintf(height_edit, sizeof(height_edit), "%d", config.window_height);
+    snprintf(baud_edit, sizeof(baud_edit), "%d", config.baud_rate);
     
     for (int i = 0; i < 8; i++) {
         strcpy(keybind_edits[i], config.keybinds[i]);
     }
     
+    // Acquisition gets its own thread, and with realtime on only that thread is
+    // pinned and raised; the window and GL loop stay in the normal class
+    static Acquirer acquirer;
+    if (!AcquirerStart(&acquirer, &port, &parser, &replay, &pipeline, &calib, config.realtime,
+                       config.realtime_cpu, config.realtime_priority)) {
+        TraceLog(LOG_ERROR, "ACQUIRE: Could not start the acquisition thread");
+    }
+    if (config.realtime) {
+        RealtimeStatus* realtime = &acquirer.status;
+        if (!realtime->fifo || realtime->cpu < 0) {
+            TraceLog(LOG_WARNING, "REALTIME: Only partly granted, SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit");
+        }
+        PrepareRealtimeMemory(realtime, &acquirer, &parser, &pipeline, &trend, &ring);
+        if (realtime->cpu >= 0) {
+            TraceLog(LOG_INFO, "REALTIME: Acquisition thread pinned to CPU %d, %s", realtime->cpu, realtime->policy);
+        } else {
+            TraceLog(LOG_INFO, "REALTIME: Acquisition thread not pinned, %s", realtime->policy);
+        }
+        TraceLog(LOG_INFO, "REALTIME: Locked %.1f KB, prefaulted %.1f KB", realtime->locked_bytes / 1024.0,
+                 realtime->prefaulted_bytes / 1024.0);
+        if (realtime->lock_failed_bytes) {
+            TraceLog(LOG_WARNING, "REALTIME: Could not lock %.1f KB, check RLIMIT_MEMLOCK",
+                     realtime->lock_failed_bytes / 1024.0);
+        }
+    }
+    
+#ifdef CURVEBUG_ALLOC_CHECK
+    // Steady state must not touch the heap. EndDrawing is left out: swapping
+    // and event polling belong to the windowing system and the GL driver.
+    uint64_t alloc_iterations = 0;
+    uint64_t alloc_failed = 0;
+    uint64_t alloc_first = 0;
+    AllocCounts alloc_total = {0};
+    if (!AllocCheckAvailable()) TraceLog(LOG_WARNING, "ALLOC: Counting needs glibc, nothing will be checked");
+#endif
+    
+    uint64_t iterations = 0;
     while (!WindowShouldClose()) {
+#ifdef CURVEBUG_ALLOC_CHECK
+        bool alloc_counting = alloc_iterations++ >= ALLOC_CHECK_WARMUP;
+        if (alloc_counting) AllocCheckBegin();
+#endif
         int screen_w = GetScreenWidth();
         int screen_h = GetScreenHeight();
         
-        view.area = (Rectangle){
+        float diff_pane_h = show_diff ? 150.0f : 0.0f;
+        float trend_pane_h = show_trend ? 160.0f : 0.0f;
+        float timeline_h = review.active ? 120.0f : 0.0f;
+        Rectangle plot_area = {
             150, 100,
             (float)(screen_w - 200),
-            (float)(screen_h - 200)
+            (float)(screen_h - 200) - diff_pane_h - trend_pane_h - timeline_h
+        };
+        Rectangle diff_area = {
+            plot_area.x, plot_area.y + plot_area.height + 60,
+            plot_area.width, diff_pane_h - 60
+        };
+        Rectangle trend_area = {
+            plot_area.x, plot_area.y + plot_area.height + diff_pane_h + 70,
+            plot_area.width, trend_pane_h - 80
         };
+        Rectangle timeline_area = {
+            plot_area.x, plot_area.y + plot_area.height + diff_pane_h + trend_pane_h + 70,
+            plot_area.width, timeline_h - 70
+        };
+        
+        // Panes split the plot area, leaving room between them for the tick labels
+        float pane_gap = 110;
+        float pane_w = (plot_area.width - pane_gap * (pane_count - 1)) / pane_count;
+        for (int i = 0; i < pane_count; i++) {
+            PlotView* pane = &views[i];
+            pane->area = (Rectangle){plot_area.x + i * (pane_w + pane_gap), plot_area.y, pane_w, plot_area.height};
+            
+            // The excitation of the frame the pane shows, which in ALT changes every frame
+            bool weak = PlotViewExcitation(pane, &data) == 1;
+            const FrameSamples* shown = weak ? &data.samples_weak : &data.samples_std;
+            if (calib.valid) {
+                PlotAxesCalibrated(&pane->axes, &calib, shown->bits, shown->origin, weak);
+            } else {
+                PlotAxesRaw(&pane->axes, shown->bits, shown->origin);
+            }
+        }
         
-        float dt = GetFrameTime();
-        acquire_timer += dt;
+        if (!views[focus].dragging) {
+            for (int i = 0; i < pane_count; i++) {
+                if (CheckCollisionPointRec(GetMousePosition(), views[i].area)) focus = i;
+            }
+        }
+        PlotView* view = &views[focus];
         
-        if (!paused && !show_settings && acquire_timer >= 0.05f) {
-            if (AcquireData(&port, &data)) {
-                frame_count++;
+        // The sequencer needs both excitations and every frame it can get
+        bool sequencing = sequencer.state == SEQUENCE_RELEASE || sequencer.state == SEQUENCE_CONTACT;
+        bool acquiring = !paused && !show_settings && !review.active;
+        AcquirerSet(&acquirer, acquiring, data.excitation_mode, sequencing);
+        
+        // The sinks already have every frame from the acquisition thread; the
+        // display skips those that land after pausing or opening review
+        static AcquiredFrame acquired;
+        while (AcquirerNext(&acquirer, &acquired)) {
+            if (!acquiring) continue;
+            
+            frame = acquired.frame;
+            data.rtt_ms = acquired.rtt_ms;
+            CurveDataStore(&data, &frame, acquired.weak);
+            frame_count = (int)acquired.sequence;
+            data.frame_index[data.last_was_weak ? 1 : 0] = (uint32_t)frame_count;
+            CurveDataUpdateMetrics(&data, data.last_was_weak);
+            TrendAddFrame(&trend, &data, trend_probe, GetTime());
+            
+            int e = data.last_was_weak ? 1 : 0;
+            const FrameSamples* samples = e ? &data.samples_weak : &data.samples_std;
+            if (sequencing && SequenceProcess(&sequencer, samples, e, GetTime())) {
+                const SequenceResult* result = &sequencer.results[sequencer.point - 1];
+                if (result->outcome == SEQUENCE_FAIL && config.diff_alarm_sound) PlaySound(alarm_sound);
+                if (sequencer.state == SEQUENCE_DONE) {
+                    SequenceStop(&sequencer);
+                    data.excitation_mode = sequence_mode;
+                    sequencing = false;
+                }
+            }
+            bool mismatch = !single_channel && data.diff[e].alarm;
+            if (mismatch && config.diff_alarm_sound && !IsSoundPlaying(alarm_sound)) {
+                PlaySound(alarm_sound);
+            }
+        }
+        
+        // Commands from the control socket act like the matching keys
+        ControlCommand command;
+        while (ControlServerPollCommand(&control, &command)) {
+            switch (command.type) {
+                case CONTROL_SET_MODE: data.excitation_mode = command.value; break;
+                case CONTROL_PAUSE: paused = true; break;
+                case CONTROL_RESUME: paused = false; break;
+                case CONTROL_CAPTURE_START:
+                    if (!recorder.capture.file) StartRecording(&recorder);
+                    break;
+                case CONTROL_CAPTURE_STOP:
+                    if (recorder.capture.file) StopRecording(&recorder);
+                    break;
             }
-            acquire_timer = 0;
         }
+        ControlStatus status = {(uint32_t)frame_count, data.excitation_mode, paused, recorder.capture.file != NULL};
+        ControlServerSetStatus(&control, &status);
         
         if (!show_settings) {
             if (IsKeyPressed(KEY_SPACE)) {
@@ -541,12 +1818,122 @@ int main(void) {
             }
             if (IsKeyPressed(KEY_P)) paused = !paused;
             if (IsKeyPressed(KEY_S)) single_channel = !single_channel;
-            if (IsKeyPressed(KEY_A)) view.auto_scale = !view.auto_scale;
-            if (IsKeyPressed(KEY_R)) PlotViewReset(&view);
-            if (IsKeyPressed(KEY_F)) PlotViewFitData(&view, &data, single_channel);
+            if (IsKeyPressed(KEY_A)) view->auto_scale = !view->auto_scale;
+            if (IsKeyPressed(KEY_R)) PlotViewReset(view);
+            if (IsKeyPressed(KEY_F)) PlotViewFitData(view, &data, single_channel);
+            if (IsKeyPressed(KEY_A) || IsKeyPressed(KEY_R) || IsKeyPressed(KEY_F)) {
+                if (link_views) PlotViewLink(views, pane_count, focus);
+            }
+            if (IsKeyPressed(KEY_L)) {
+                // The split panes need both excitations; the difference trace is added below
+                bool split = pane_count == 1;
+                pane_count = split ? 3 : 1;
+                focus = 0;
+                PlotPanesSetSplit(views, split);
+                if (split) {
+                    split_mode = data.excitation_mode;
+                    data.excitation_mode = 2;
+                    if (link_views) PlotViewLink(views, pane_count, 0);
+                } else {
+                    data.excitation_mode = split_mode;
+                    if (derived_trace != 1) CurveDataRemoveChannels(&data, CURVE_SOURCE_DIFFERENCE);
+                }
+                view = &views[0];
+            }
+            if (IsKeyPressed(KEY_J)) {
+                link_views = !link_views;
+                if (link_views) PlotViewLink(views, pane_count, focus);
+            }
+            if (IsKeyPressed(KEY_M)) show_metrics = !show_metrics;
+            if (IsKeyPressed(KEY_D)) show_diff = !show_diff;
+            if (IsKeyPressed(KEY_T)) monitor.armed = !monitor.armed;
+            if (IsKeyPressed(KEY_I)) {
+                bool smooth = !views[0].smooth;
+                for (int i = 0; i < PLOT_MAX_PANES; i++) views[i].smooth = smooth;
+            }
+            if (IsKeyPressed(KEY_G)) show_trend = !show_trend;
+            if (IsKeyPressed(KEY_N)) {
+                if (sequencing) {
+                    SequenceStop(&sequencer);
+                    data.excitation_mode = sequence_mode;
+                } else if (StartSequence(&sequencer, config.test_plan, &geometry)) {
+                    sequence_mode = data.excitation_mode;
+                    data.excitation_mode = 2;
+                }
+            }
+            if (sequencing && !review.active && IsKeyPressed(KEY_RIGHT)) SequenceSkip(&sequencer, GetTime());
+            if (show_trend && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) &&
+                CheckCollisionPointRec(GetMousePosition(), view->area)) {
+                // The voltage axis runs right to left
+                float t = (view->area.x + view->area.width - GetMousePosition().x) / view->area.width;
+                trend_probe = view->x_min + t * (view->x_max - view->x_min);
+            }
+            if (IsKeyPressed(KEY_B)) {
+                // Freeze the leads as reference traces, or drop the ones already stored
+                int before = data.channel_count;
+                CurveDataRemoveChannels(&data, CURVE_SOURCE_REFERENCE);
+                if (data.channel_count == before) {
+                    CurveDataAddReference(&data, 0, "DUT1 reference");
+                    CurveDataAddReference(&data, 1, "DUT2 reference");
+                }
+            }
+            if (IsKeyPressed(KEY_X)) {
+                derived_trace = (derived_trace + 1) % 3;
+                CurveDataRemoveChannels(&data, CURVE_SOURCE_DIFFERENCE);
+                CurveDataRemoveChannels(&data, CURVE_SOURCE_AVERAGE);
+                if (derived_trace == 1) CurveDataAddDerived(&data, CURVE_SOURCE_DIFFERENCE, 0, 1, "DUT1 - DUT2");
+                if (derived_trace == 2) CurveDataAddDerived(&data, CURVE_SOURCE_AVERAGE, 0, 1, "DUT1/DUT2 average");
+            }
+            if (pane_count > 1 && CurveDataFindSource(&data, CURVE_SOURCE_DIFFERENCE) < 0) {
+                CurveDataAddDerived(&data, CURVE_SOURCE_DIFFERENCE, 0, 1, "DUT1 - DUT2");
+            }
+            if (IsKeyPressed(KEY_V)) {
+                if (review.active) {
+                    ReviewClose(&review);
+                } else if (!recorder.capture.file && recorder.capture.path[0] &&
+                           ReviewOpen(&review, recorder.capture.path)) {
+                    ReviewShowFrame(&review, 0, &data, &frame);
+                }
+            }
+            if (review.active) {
+                uint32_t target = review.frame;
+                if (IsKeyPressed(KEY_RIGHT) || IsKeyPressedRepeat(KEY_RIGHT)) target++;
+                if ((IsKeyPressed(KEY_LEFT) || IsKeyPressedRepeat(KEY_LEFT)) && target > 0) target--;
+                if (IsKeyPressed(KEY_K)) review.key = (review.key + 1) % SUMMARY_KEYS;
+                
+                Vector2 mouse = GetMousePosition();
+                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && CheckCollisionPointRec(mouse, timeline_area)) {
+                    review.scrubbing = true;
+                }
+                if (!IsMouseButtonDown(MOUSE_LEFT_BUTTON)) review.scrubbing = false;
+                if (review.scrubbing) {
+                    float t = (mouse.x - timeline_area.x) / timeline_area.width;
+                    if (t < 0) t = 0;
+                    if (t > 1) t = 1;
+                    target = (uint32_t)(t * (review.summary.frames - 1) + 0.5f);
+                }
+                
+                if (target != review.frame && target < review.summary.frames) {
+                    ReviewShowFrame(&review, target, &data, &frame);
+                }
+            }
+            if (IsKeyPressed(KEY_C)) {
+                if (recorder.capture.file) {
+                    StopRecording(&recorder);
+                } else {
+                    StartRecording(&recorder);
+                }
+            }
+            if (IsKeyPressed(KEY_E)) {
+                if (live_export.active) {
+                    StopTextExport(&live_export);
+                } else {
+                    StartTextExport(&live_export, &config);
+                }
+            }
             if (IsKeyPressed(KEY_F1)) {
                 show_settings = !show_settings;
-                if (show_settings) view.dragging = false;  // Reset dragging when entering settings
+                if (show_settings) view->dragging = false;  // Reset dragging when entering settings
             }
             if (IsKeyPressed(KEY_ESCAPE)) {
                 break;  // Exit program only if not in settings
@@ -557,6 +1944,8 @@ int main(void) {
                 strcpy(port_edit, config.serial_port);
                 snprintf(width_edit, sizeof(width_edit), "%d", config.window_width);
                 snprintf(height_edit, sizeof(height_edit), "%d", config.window_height);
+                snprintf(baud_edit, sizeof(baud_edit), "%d", config.baud_rate);
+                low_latency_edit = config.low_latency;
                 for (int i = 0; i < 8; i++) {
                     strcpy(keybind_edits[i], config.keybinds[i]);
                 }
@@ -567,7 +1956,10 @@ int main(void) {
         
         if (!show_settings) {
             float wheel = GetMouseWheelMove();
-            if (wheel != 0) PlotViewHandleZoom(&view, wheel);
+            if (wheel != 0) {
+                PlotViewHandleZoom(view, wheel);
+                if (link_views) PlotViewLink(views, pane_count, focus);
+            }
             
             // Define settings button bounds (same as in drawing code)
             Rectangle settings_btn = {
@@ -579,46 +1971,113 @@ int main(void) {
             Vector2 mouse_pos = GetMousePosition();
             bool clicked_on_settings_btn = CheckCollisionPointRec(mouse_pos, settings_btn);
             
-            // Only start dragging if not clicking on settings button
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !view.auto_scale && !clicked_on_settings_btn) {
-                view.dragging = true;
-                view.drag_start = mouse_pos;
-                view.drag_offset = (Vector2){view.pan_x, view.pan_y};
+            // Only start dragging if not clicking on settings button or the timeline
+            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !view->auto_scale && !clicked_on_settings_btn &&
+                !review.scrubbing) {
+                view->dragging = true;
+                view->drag_start = mouse_pos;
+                view->drag_offset = (Vector2){view->pan_x, view->pan_y};
             }
             if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-                view.dragging = false;
+                view->dragging = false;
             }
-            if (view.dragging && IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+            if (view->dragging && IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
                 Vector2 mouse = GetMousePosition();
-                Vector2 delta = {mouse.x - view.drag_start.x, mouse.y - view.drag_start.y};
-                float x_range = ADC_MAX / view.zoom;
-                float y_range = (ADC_MAX - 700) / view.zoom;
-                view.pan_x = view.drag_offset.x + (delta.x * x_range / view.area.width);
-                view.pan_y = view.drag_offset.y - (delta.y * y_range / view.area.height);
+                Vector2 delta = {mouse.x - view->drag_start.x, mouse.y - view->drag_start.y};
+                float x_range = (view->axes.x_max - view->axes.x_min) / view->zoom;
+                float y_range = (view->axes.y_max - view->axes.y_min) / view->zoom;
+                view->pan_x = view->drag_offset.x + (delta.x * x_range / view->area.width);
+                view->pan_y = view->drag_offset.y - (delta.y * y_range / view->area.height);
+                if (link_views) PlotViewLink(views, pane_count, focus);
             }
         } else {
             // Reset dragging state when in settings to prevent issues when returning
-            view.dragging = false;
+            view->dragging = false;
         }
         
         BeginDrawing();
         ClearBackground(config.bg_color);
         
         if (!show_settings) {
-            PlotViewDraw(&view, &data, &config, single_channel);
+            // Views, bounds and splines are built once per frame and shared by every pane
+            for (int i = 0; i < pane_count; i++) {
+                PlotViewDraw(&views[i], &data, &config, single_channel);
+            }
+            bool have_frame = frame_count > 0 || review.active;
+            if (show_metrics && have_frame) DrawMetrics(views[0].area, &data, &config, single_channel);
+            if (show_diff) DrawDiffPane(diff_area, &data, &config);
+            if (show_trend) {
+                DrawTrendPane(trend_area, &trend, &data, &view->axes, &config, single_channel, trend_probe);
+                for (int i = 0; i < pane_count; i++) {
+                    const PlotView* pane = &views[i];
+                    float t = (trend_probe - pane->x_min) / (pane->x_max - pane->x_min);
+                    if (t >= 0 && t <= 1) {
+                        int x = (int)(pane->area.x + pane->area.width - t * pane->area.width);
+                        DrawLine(x, (int)pane->area.y, x, (int)(pane->area.y + pane->area.height),
+                                 Fade(config.crosshair, 0.6f));
+                    }
+                }
+            }
+            if (review.active) DrawTimeline(timeline_area, &review, &config);
+            if (sequencer.state != SEQUENCE_IDLE) DrawSequencePanel(plot_area, &sequencer, &config);
+            CursorIndexUpdate(&cursor, view, &data, single_channel);
+            if (!view->dragging) DrawCursorReadout(&cursor, view, &data, &config);
+            
+            const DiffResult* diff = &data.diff[data.last_was_weak ? 1 : 0];
+            if (!single_channel && have_frame && diff->alarm) {
+                // Blink the plot border so a mismatch is visible while probing
+                if (fmod(GetTime(), 0.5) < 0.25) {
+                    for (int i = 0; i < pane_count; i++) DrawRectangleLinesEx(views[i].area, 6, RED);
+                }
+                DrawText(TextFormat("MISMATCH  RMS %.0f  MAX %d", diff->window_rms, diff->max_dev),
+                         (int)(plot_area.x + plot_area.width - 300), (int)(plot_area.y + 10), 20, RED);
+            }
             
             const char* mode_names[] = {"4.7K(T)", "100K WEAK(W)", "ALT"};
-            DrawText(TextFormat("I-V Characteristics - %s %s Zoom:%.2fx Frame:%d", 
-                                mode_names[data.excitation_mode],
-                                view.auto_scale ? "[AUTO]" : "[FIXED]",
-                                view.zoom, frame_count),
-                     (int)view.area.x, (int)(view.area.y - 40), 20, config.axis_color);
+            const ClassifyResult* dut1_class = &data.channels[0].classification[data.last_was_weak ? 1 : 0];
+            const ClassifyResult* dut2_class = &data.channels[1].classification[data.last_was_weak ? 1 : 0];
+            const char* class_text = "";
+            if (have_frame && single_channel) {
+                class_text = TextFormat(" [%s %.0f%%]", CLASSIFY_LABEL_NAMES[dut1_class->label],
+                                        dut1_class->confidence * 100);
+            } else if (have_frame) {
+                class_text = TextFormat(" [%s %.0f%% / %s %.0f%%]",
+                                        CLASSIFY_LABEL_NAMES[dut1_class->label], dut1_class->confidence * 100,
+                                        CLASSIFY_LABEL_NAMES[dut2_class->label], dut2_class->confidence * 100);
+            }
+            const char* layout_text = pane_count == 1 ? "" : link_views ? " [SPLIT LINKED]" : " [SPLIT]";
+            DrawText(TextFormat("I-V Characteristics - %s%s %s%s%s Zoom:%.2fx Frame:%d RTT:%.1fms", 
+                                mode_names[data.excitation_mode], class_text,
+                                view->auto_scale ? "[AUTO]" : "[FIXED]",
+                                view->smooth ? " [SPLINE]" : "", layout_text,
+                                view->zoom, frame_count, data.rtt_ms),
+                     (int)plot_area.x, (int)(plot_area.y - 40), 20, config.axis_color);
             
-            DrawText("SPACE=mode P=pause S=single A=auto F=fit R=reset F1=settings ESC=quit",
+            DrawText("SPACE=mode P=pause S=single A=auto F=fit R=reset C=record E=export V=review T=trigger I=smooth B=ref X=derived M=metrics D=diff G=trend N=sequence L=split J=link F1=settings ESC=quit",
                      20, screen_h - 40, 20, LIGHTGRAY);
             
-            DrawText(connected ? "Connected" : "NOT CONNECTED",
-                     screen_w - 150, 20, 20, connected ? GREEN : RED);
+            DrawText(replay.active ? "Replay" : connected ? "Connected" : "NOT CONNECTED",
+                     screen_w - 150, 20, 20, replay.active || connected ? GREEN : RED);
+            FrameParserStats parser_stats;
+            AcquirerGetStats(&acquirer, &parser_stats);
+            DrawText(TextFormat("OK:%u DROP:%u RESYNC:%u",
+                                parser_stats.frames_good,
+                                parser_stats.frames_dropped,
+                                parser_stats.resyncs),
+                     screen_w - 150, 45, 10, LIGHTGRAY);
+            DrawText(calib.valid ? TextFormat("CAL %s", calib.profile.serial) : "UNCALIBRATED (ADC counts)",
+                     screen_w - 150, 60, 10, calib.valid ? GREEN : LIGHTGRAY);
+            for (int i = 0; i < pipeline.sink_count; i++) {
+                PipelineSinkStats st;
+                PipelineGetStats(&pipeline, i, &st);
+                DrawText(TextFormat("%s Q:%u/%u DROP:%llu", pipeline.sinks[i].name,
+                                    st.depth, st.capacity, (unsigned long long)st.dropped),
+                         screen_w - 150, 75 + i * 12, 10, st.dropped ? ORANGE : LIGHTGRAY);
+            }
+            uint32_t ui_depth = (uint32_t)(AtomicLoad64(&acquirer.tail) - AtomicLoad64(&acquirer.head));
+            uint64_t ui_dropped = AtomicLoad64(&acquirer.dropped);
+            DrawText(TextFormat("ui Q:%u/%u DROP:%llu", ui_depth, ACQUIRE_QUEUE, (unsigned long long)ui_dropped),
+                     screen_w - 150, 75 + pipeline.sink_count * 12, 10, ui_dropped ? ORANGE : LIGHTGRAY);
             
             // Settings button at bottom right
             Rectangle settings_btn = {
@@ -638,9 +2097,40 @@ int main(void) {
             // Handle settings button click
             if (settings_btn_hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
                 show_settings = true;
-                view.dragging = false;  // Reset dragging state
+                view->dragging = false;  // Reset dragging state
             }
 
+            if (recorder.capture.file) {
+                PipelineSinkStats rec_stats;
+                PipelineGetStats(&pipeline, 0, &rec_stats);
+                DrawText(TextFormat("REC %s  %u frames  %.1f KB  queue %u/%u  lost %llu", recorder.capture.path,
+                                    recorder.capture.frames, recorder.capture.bytes / 1024.0,
+                                    rec_stats.depth, rec_stats.capacity,
+                                    (unsigned long long)rec_stats.dropped),
+                         (int)plot_area.x, (int)(plot_area.y - 60), 16, RED);
+            }
+            
+            if (live_export.active) {
+                PipelineSinkStats export_stats;
+                PipelineGetStats(&pipeline, 1, &export_stats);
+                const TextExporter* ex = &live_export.exporter;
+                DrawText(TextFormat("EXPORT %s  %llu rows  %.1f KB  queue %u/%u  lost %llu%s",
+                                    ex->file ? ex->path : "(waiting for frames)", (unsigned long long)ex->rows,
+                                    ex->bytes / 1024.0, export_stats.depth, export_stats.capacity,
+                                    (unsigned long long)export_stats.dropped,
+                                    ex->write_errors ? "  WRITE ERRORS" : ""),
+                         (int)plot_area.x, (int)(plot_area.y - 100), 16, ex->write_errors ? RED : SKYBLUE);
+            }
+            
+            if (monitor.armed) {
+                const Trigger* trig = &monitor.trigger;
+                DrawText(TextFormat("TRIG %s  events %u  dev max %d mean %.1f%s",
+                                    trig->writer.file ? "SAVING" : "ARMED", trig->events,
+                                    trig->last.max_dev, trig->last.mean_dev,
+                                    trig->write_errors ? "  WRITE ERRORS" : ""),
+                         (int)plot_area.x, (int)(plot_area.y - 80), 16, trig->writer.file ? RED : ORANGE);
+            }
+            
             if (paused) {
                 DrawText("PAUSED", screen_w/2 - 80, screen_h/2, 48, YELLOW);
             }
@@ -685,6 +2175,18 @@ int main(void) {
                     height_edit_mode = !height_edit_mode;
                 }
                 
+                content_y += 50;
+                GuiLabel((Rectangle){panel.x + 30, (float)content_y, 150, 25}, "Baud Rate:");
+                if (GuiTextBox((Rectangle){panel.x + 200, (float)content_y, 150, 30}, 
+                               baud_edit, 32, baud_edit_mode)) {
+                    baud_edit_mode = !baud_edit_mode;
+                }
+                GuiLabel((Rectangle){panel.x + 360, (float)content_y, 300, 25}, "Any rate with low latency on Linux");
+                
+                content_y += 50;
+                GuiCheckBox((Rectangle){panel.x + 30, (float)content_y, 25, 25},
+                            "Low latency serial (measures round trip in log)", &low_latency_edit);
+                
             } else if (active_tab == TAB_COLORS) {
                 // Preset buttons
                 if (GuiButton((Rectangle){panel.x + 30, (float)content_y, 120, 30}, "Dark Mode")) {
@@ -786,6 +2288,9 @@ int main(void) {
                 strcpy(config.serial_port, port_edit);
                 config.window_width = atoi(width_edit);
                 config.window_height = atoi(height_edit);
+                if (atoi(baud_edit) > 0) config.baud_rate = atoi(baud_edit);
+                snprintf(baud_edit, sizeof(baud_edit), "%d", config.baud_rate);
+                config.low_latency = low_latency_edit;
                 
                 for (int i = 0; i < 8; i++) {
                     strcpy(config.keybinds[i], keybind_edits[i]);
@@ -794,8 +2299,16 @@ int main(void) {
                 ConfigSave(&config, "curvebug.cfg");
                 show_settings = false;
                 
+                // The port belongs to the acquisition thread until it is idle
+                AcquirerPause(&acquirer);
                 SerialClose(&port);
-                connected = SerialOpen(&port, config.serial_port, 115200);
+                connected = OpenDevice(&port, &config, &parser);
+                LoadCalibration(config.serial_port, &calib);
+                data.views_dirty[0] = data.views_dirty[1] = true;
+                CurveDataRemoveChannels(&data, CURVE_SOURCE_REFERENCE);   // Stored in the old units
+                TrendClear(&trend);
+                trend_probe = NAN;
+                for (int i = 0; i < PLOT_MAX_PANES; i++) PlotViewReset(&views[i]);
             }
             
             if (GuiButton((Rectangle){panel.x + panel.width - 130, panel.y + panel.height - 60, 
@@ -803,6 +2316,8 @@ int main(void) {
                 strcpy(port_edit, config.serial_port);
                 snprintf(width_edit, sizeof(width_edit), "%d", config.window_width);
                 snprintf(height_edit, sizeof(height_edit), "%d", config.window_height);
+                snprintf(baud_edit, sizeof(baud_edit), "%d", config.baud_rate);
+                low_latency_edit = config.low_latency;
                 for (int i = 0; i < 8; i++) {
                     strcpy(keybind_edits[i], config.keybinds[i]);
                 }
@@ -810,11 +2325,94 @@ int main(void) {
             }
         }
         
+#ifdef CURVEBUG_ALLOC_CHECK
+        if (alloc_counting) {
+            AllocCounts counts;
+            AllocCheckEnd(&counts);
+            if (counts.allocs) {
+                if (alloc_failed == 0) alloc_first = alloc_iterations - 1;
+                alloc_failed++;
+                alloc_total.allocs += counts.allocs;
+                alloc_total.bytes += counts.bytes;
+            }
+        }
+#endif
         EndDrawing();
+        
+        // A timed replay ends on its own, e.g. for an unattended allocation check
+        if (replay.iterations && ++iterations >= replay.iterations) break;
     }
     
+    AcquirerStop(&acquirer);
+    
+#ifdef CURVEBUG_ALLOC_CHECK
+    uint64_t alloc_checked = alloc_iterations > ALLOC_CHECK_WARMUP ? alloc_iterations - ALLOC_CHECK_WARMUP : 0;
+    if (alloc_failed) {
+        TraceLog(LOG_ERROR, "ALLOC: %llu of %llu iterations allocated (first at %llu): %llu allocations, %llu bytes",
+                 (unsigned long long)alloc_failed, (unsigned long long)alloc_checked,
+                 (unsigned long long)alloc_first, (unsigned long long)alloc_total.allocs,
+                 (unsigned long long)alloc_total.bytes);
+    } else {
+        TraceLog(LOG_INFO, "ALLOC: No allocations in %llu iterations after warm-up", (unsigned long long)alloc_checked);
+    }
+    if (acquirer.allocs.allocs) {
+        TraceLog(LOG_ERROR, "ALLOC: Acquisition thread made %llu allocations, %llu bytes",
+                 (unsigned long long)acquirer.allocs.allocs, (unsigned long long)acquirer.allocs.bytes);
+        alloc_failed++;
+    } else {
+        TraceLog(LOG_INFO, "ALLOC: No allocations on the acquisition thread after warm-up");
+    }
+#endif
+    
+    LogJitter(&acquirer.jitter, &acquirer.status);
+    
+    // Sinks drain what is queued before the capture file is closed
+    for (int i = 0; i < pipeline.sink_count; i++) {
+        PipelineSinkStats st;
+        PipelineGetStats(&pipeline, i, &st);
+        TraceLog(LOG_INFO, "PIPELINE: %s delivered %llu, dropped %llu, max depth %u/%u", pipeline.sinks[i].name,
+                 (unsigned long long)st.delivered, (unsigned long long)st.dropped, st.max_depth, st.capacity);
+    }
+    TraceLog(LOG_INFO, "PIPELINE: ui skipped %llu of %llu frames", (unsigned long long)acquirer.dropped,
+             (unsigned long long)acquirer.sequence);
+#ifdef CURVEBUG_ALLOC_CHECK
+    int alloc_sinks = pipeline.sink_count;      // PipelineShutdown clears it
+#endif
+    PipelineShutdown(&pipeline);
+    ReviewClose(&review);
+    ReplayClose(&replay);
+    TriggerFree(&monitor.trigger);
+    StopRecording(&recorder);
+    MutexDestroy(&recorder.lock);
+    StopTextExport(&live_export);
+    MutexDestroy(&live_export.lock);
+    UnloadSound(alarm_sound);
+    CloseAudioDevice();
+    ControlServerStop(&control);
+    SpatialGridFree(&cursor.grid);
+    CurveDataFree(&data);
+    TrendFree(&trend);
+    SequenceStop(&sequencer);
+    ShmRingClose(&ring);
     SerialClose(&port);
     CloseWindow();
     
+#ifdef CURVEBUG_ALLOC_CHECK
+    // The sink and control threads, each counted after its own warm-up
+    for (int i = 0; i < alloc_sinks; i++) {
+        const AllocCounts* counts = &pipeline.sinks[i].allocs;
+        if (counts->allocs) {
+            TraceLog(LOG_ERROR, "ALLOC: %s sink made %llu allocations, %llu bytes", pipeline.sinks[i].name,
+                     (unsigned long long)counts->allocs, (unsigned long long)counts->bytes);
+            alloc_failed++;
+        }
+    }
+    if (control.allocs.allocs) {
+        TraceLog(LOG_ERROR, "ALLOC: Control thread made %llu allocations, %llu bytes",
+                 (unsigned long long)control.allocs.allocs, (unsigned long long)control.allocs.bytes);
+        alloc_failed++;
+    }
+    if (alloc_failed) return 1;
+#endif
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "metrics.h"
+#include <math.h>
+
+#define METRICS_KNEE_COUNTS 100     // 12-bit counts
+#define METRICS_WINDOW_COUNTS 40
+
+void MetricsParamsRaw(MetricsParams* params, int bits, int origin, bool weak) {
+    float scale = FrameCountScale(bits);
+    
+    params->v_origin = (float)origin;
+    params->v_window = METRICS_WINDOW_COUNTS * scale;
+    params->i_knee = METRICS_KNEE_COUNTS * scale;
+    params->ohms_per_unit = weak ? 100000.0f : 4700.0f;     // Nominal excitation resistors
+    params->code_max = FrameCodeMax(bits);
+}
+
+void MetricsParamsCalibrated(MetricsParams* params, const CalibrationTable* calib, int bits, int origin, bool weak) {
+    float counts_to_volts = FrameCountScale(bits) * fabsf(calib->profile.gain);
+    
+    params->v_origin = calib->volts[origin];
+    params->v_window = METRICS_WINDOW_COUNTS * counts_to_volts;
+    params->i_knee = METRICS_KNEE_COUNTS * counts_to_volts * calib->ma_per_volt[weak ? 1 : 0];
+    params->ohms_per_unit = 1000.0f;                        // V/mA
+    params->code_max = FrameCodeMax(bits);
+}
+
+// Everything in one pass over the sweep, so the arrays are streamed once
+void MetricsCompute(const float* voltage, const float* current,
+                    const uint16_t* drive, const uint16_t* raw, int count,
+                    const MetricsParams* params, MetricsResult* result) {
+    double n = 0, si = 0, sv = 0, sii = 0, siv = 0;
+    double area = 0, noise = 0;
+    double v_zero = 0, i_zero = 0;
+    int v_zero_count = 0, i_zero_count = 0;
+    float knee = INFINITY;
+    float leak = 0, leak_depth = -1;
+    int clipped = 0;
+    
+    for (int k = 0; k < count; k++) {
+        float v = voltage[k] - params->v_origin;
+        float i = current[k];
+        
+        clipped += (drive[k] == params->code_max) + (drive[k] == 0) +
+                   (raw[k] == params->code_max) + (raw[k] == 0);
+        
+        if (fabsf(v) <= params->v_window) {
+            n += 1;
+            si += i;
+            sv += v;
+            sii += (double)i * i;
+            siv += (double)i * v;
+        }
+        
+        if (i >= params->i_knee && fabsf(v) < knee) knee = fabsf(v);
+        if (i < 0 && fabsf(v) > leak_depth) {
+            leak_depth = fabsf(v);
+            leak = i;
+        }
+        
+        if (k > 0) {
+            float v_prev = voltage[k - 1] - params->v_origin;
+            float i_prev = current[k - 1];
+            
+            // Shoelace term; the sweep returns to its start so the polygon closes
+            area += (double)v_prev * i - (double)v * i_prev;
+            
+            if ((i_prev < 0) != (i < 0) && i != i_prev) {
+                v_zero += v_prev + (v - v_prev) * (0 - i_prev) / (i - i_prev);
+                v_zero_count++;
+            }
+            if ((v_prev < 0) != (v < 0) && v != v_prev) {
+                i_zero += i_prev + (i - i_prev) * (0 - v_prev) / (v - v_prev);
+                i_zero_count++;
+            }
+        }
+        
+        if (k > 1) {
+            // Second difference of a smooth sweep is mostly noise; var(d2) = 6 var(noise)
+            double d2 = i - 2.0 * current[k - 1] + current[k - 2];
+            noise += d2 * d2;
+        }
+    }
+    
+    if (count > 1) {
+        float v_first = voltage[0] - params->v_origin;
+        float v_last = voltage[count - 1] - params->v_origin;
+        area += (double)v_last * current[0] - (double)v_first * current[count - 1];
+    }
+    
+    double denom = n * sii - si * si;
+    result->r_small = (n >= 3 && denom > 0) ? (float)((n * siv - si * sv) / denom * params->ohms_per_unit) : NAN;
+    result->v_knee = isinf(knee) ? NAN : knee;
+    result->i_leak = leak;
+    result->v_zero = v_zero_count ? (float)(v_zero / v_zero_count) : NAN;
+    result->i_zero = i_zero_count ? (float)(i_zero / i_zero_count) : NAN;
+    result->noise = count > 2 ? (float)sqrt(noise / (6.0 * (count - 2))) : 0;
+    result->loop_area = (float)fabs(area * 0.5);
+    result->clipped = clipped;
+}
+
+// Same conversion as the plot's channel views, so the numbers match what is drawn
+void MetricsComputeFrame(const FrameSamples* samples, const CalibrationTable* calib, bool weak,
+                         float* voltage, float* current, MetricsResult results[2]) {
+    bool calibrated = calib && calib->valid;
+    float ma_per_volt = calibrated ? calib->ma_per_volt[weak ? 1 : 0] : 0.0f;
+    
+    MetricsParams params;
+    if (calibrated) {
+        MetricsParamsCalibrated(&params, calib, samples->bits, samples->origin, weak);
+    } else {
+        MetricsParamsRaw(&params, samples->bits, samples->origin, weak);
+    }
+    
+    const uint16_t* channels[2] = {samples->ch1, samples->ch2};
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < samples->count; i++) {
+            if (calibrated) {
+                voltage[i] = calib->volts[channels[c][i]];
+                current[i] = (calib->volts[samples->drive[i]] - voltage[i]) * ma_per_volt;
+            } else {
+                voltage[i] = (float)channels[c][i];
+                current[i] = (float)(samples->drive[i] - channels[c][i]);
+            }
+        }
+        MetricsCompute(voltage, current, samples->drive, channels[c], samples->count, &params, &results[c]);
+    }
+}
+
+float MetricsCurrentAt(const float* voltage, const float* current, int count, float v) {
+    double sum = 0;
+    int crossings = 0;
+    
+    for (int k = 1; k < count; k++) {
+        float v0 = voltage[k - 1] - v;
+        float v1 = voltage[k] - v;
+        if ((v0 < 0) != (v1 < 0) && v1 != v0) {
+            sum += current[k - 1] + (current[k] - current[k - 1]) * (0 - v0) / (v1 - v0);
+            crossings++;
+        }
+    }
+    return crossings ? (float)(sum / crossings) : NAN;
+}
+
+void MetricsWriteCsvHeader(FILE* f) {
+    fprintf(f, "sequence,excitation,channel,r_small,v_knee,i_leak,v_zero,i_zero,noise,loop_area,clipped\n");
+}
+
+void MetricsWriteCsvRow(FILE* f, uint32_t sequence, int excitation, int channel, const MetricsResult* m) {
+    fprintf(f, "%u,%d,%d,%g,%g,%g,%g,%g,%g,%g,%d\n", sequence, excitation, channel,
+            m->r_small, m->v_knee, m->i_leak, m->v_zero, m->i_zero, m->noise, m->loop_area, m->clipped);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "calib.h"
+
+// Units follow the plot: ADC counts, or volts and milliamps when calibrated
+typedef struct {
+    float v_origin;         // Voltage of the DUT common
+    float v_window;         // Half width of the small-signal fit around the origin
+    float i_knee;           // Forward current that marks the knee
+    float ohms_per_unit;    // Converts a dV/dI slope to ohms
+    int code_max;           // Full scale at the frame's depth, for clipping
+} MetricsParams;
+
+typedef struct {
+    float r_small;          // Small-signal resistance at the origin, ohms (NAN if flat)
+    float v_knee;           // Forward knee voltage relative to origin (NAN if none)
+    float i_leak;           // Current at the deepest reverse bias point
+    float v_zero;           // Voltage offset where current crosses zero
+    float i_zero;           // Current offset where voltage crosses the origin
+    float noise;            // RMS current noise from second differences
+    float loop_area;        // Hysteresis area between up and down sweeps
+    int clipped;            // Samples at 0 or full scale
+} MetricsResult;
+
+// The window and knee are set in 12-bit counts and scaled to the frame's depth
+void MetricsParamsRaw(MetricsParams* params, int bits, int origin, bool weak);
+void MetricsParamsCalibrated(MetricsParams* params, const CalibrationTable* calib, int bits, int origin, bool weak);
+
+void MetricsCompute(const float* voltage, const float* current,
+                    const uint16_t* drive, const uint16_t* raw, int count,
+                    const MetricsParams* params, MetricsResult* result);
+
+// Both leads of a split frame in the plot's units: calibrated when calib is
+// valid, raw counts otherwise. voltage and current are scratch of count floats.
+void MetricsComputeFrame(const FrameSamples* samples, const CalibrationTable* calib, bool weak,
+                         float* voltage, float* current, MetricsResult results[2]);
+
+// Mean current where the sweep crosses v, interpolated between samples; NAN if it never does
+float MetricsCurrentAt(const float* voltage, const float* current, int count, float v);
+
+void MetricsWriteCsvHeader(FILE* f);
+void MetricsWriteCsvRow(FILE* f, uint32_t sequence, int excitation, int channel, const MetricsResult* m);
+
+#endif
\ No newline at end of file
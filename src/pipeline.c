@@ -0,0 +1,193 @@
+#include "pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void PipelineInit(Pipeline* pipeline, const FrameGeometry* geometry) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->samples = geometry->samples;
+}
+
+static uint8_t* PipelineSlot(const PipelineSink* sink, uint64_t index) {
+    return sink->slots + (index & sink->mask) * sink->slot_size;
+}
+
+// Copy the oldest frame out. False if the queue is empty.
+static bool PipelineTake(PipelineSink* sink, PipelineFrame* out) {
+    uint64_t head = AtomicLoad64(&sink->head);
+    for (;;) {
+        uint64_t tail = AtomicLoad64(&sink->tail);
+        if (head == tail) return false;
+        
+        memcpy(out, PipelineSlot(sink, head), sink->frame_bytes);
+        
+        // Fails only if the producer dropped this slot meanwhile; the copy may be torn
+        if (AtomicCompareExchange64(&sink->head, &head, head + 1)) return true;
+    }
+}
+
+static void PipelineWorker(void* arg) {
+    PipelineSink* sink = arg;
+    PipelineFrame* frame = malloc(sizeof(PipelineFrame));
+    if (!frame) return;
+#ifdef CURVEBUG_ALLOC_CHECK
+    uint64_t taken = 0;
+#endif
+    
+    for (;;) {
+        if (PipelineTake(sink, frame)) {
+#ifdef CURVEBUG_ALLOC_CHECK
+            if (taken++ == PIPELINE_ALLOC_WARMUP) AllocCheckBegin();
+#endif
+            if (sink->policy == PIPELINE_BLOCK) {
+                MutexLock(&sink->lock);
+                CondSignal(&sink->space);
+                MutexUnlock(&sink->lock);
+            }
+            
+            sink->fn(sink->ctx, frame);
+            AtomicFetchAdd64(&sink->delivered, 1);
+            continue;
+        }
+        
+        // The flag is raised before the queue is checked again and the producer
+        // stores tail before reading the flag, so one of the two sees the other
+        MutexLock(&sink->lock);
+        AtomicStore32(&sink->sleeping, 1);
+        AtomicFenceFull();
+        while (sink->running && AtomicLoad64(&sink->head) == AtomicLoad64(&sink->tail)) {
+            CondWait(&sink->ready, &sink->lock);
+        }
+        AtomicStore32(&sink->sleeping, 0);
+        bool done = !sink->running && AtomicLoad64(&sink->head) == AtomicLoad64(&sink->tail);
+        MutexUnlock(&sink->lock);
+        
+        if (done) break;
+    }
+    
+#ifdef CURVEBUG_ALLOC_CHECK
+    AllocCheckEnd(&sink->allocs);
+#endif
+    free(frame);
+}
+
+bool PipelineAddSink(Pipeline* pipeline, const char* name, PipelinePolicy policy, uint32_t capacity,
+                     PipelineSinkFn fn, void* ctx) {
+    if (pipeline->sink_count >= PIPELINE_MAX_SINKS) return false;
+    
+    uint32_t size = 2;
+    while (size < capacity) size <<= 1;
+    
+    PipelineSink* sink = &pipeline->sinks[pipeline->sink_count];
+    memset(sink, 0, sizeof(*sink));
+    
+    sink->frame_bytes = offsetof(PipelineFrame, frame) + RawFrameBytes(pipeline->samples);
+    sink->slot_size = RawFrameSlotBytes(offsetof(PipelineFrame, frame), pipeline->samples);
+    sink->slots = malloc(sink->slot_size * size);
+    if (!sink->slots) return false;
+    
+    snprintf(sink->name, sizeof(sink->name), "%s", name);
+    sink->fn = fn;
+    sink->ctx = ctx;
+    sink->policy = policy;
+    sink->capacity = size;
+    sink->mask = size - 1;
+    sink->running = true;
+    
+    MutexInit(&sink->lock);
+    CondInit(&sink->ready);
+    CondInit(&sink->space);
+    
+    if (!ThreadCreate(&sink->thread, PipelineWorker, sink)) {
+        CondDestroy(&sink->space);
+        CondDestroy(&sink->ready);
+        MutexDestroy(&sink->lock);
+        free(sink->slots);
+        sink->slots = NULL;
+        return false;
+    }
+    
+    pipeline->sink_count++;
+    return true;
+}
+
+static void PipelinePush(PipelineSink* sink, const PipelineFrame* frame) {
+    uint64_t tail = sink->tail;
+    uint64_t head = AtomicLoad64(&sink->head);
+    
+    if (tail - head >= sink->capacity) {
+        if (sink->policy == PIPELINE_DROP_NEWEST) {
+            AtomicFetchAdd64(&sink->dropped, 1);
+            return;
+        }
+        
+        if (sink->policy == PIPELINE_DROP_OLDEST) {
+            // Races with the consumer taking the same slot; either way one frame leaves
+            if (AtomicCompareExchange64(&sink->head, &head, head + 1)) {
+                AtomicFetchAdd64(&sink->dropped, 1);
+            }
+        } else {
+            MutexLock(&sink->lock);
+            while (tail - AtomicLoad64(&sink->head) >= sink->capacity) {
+                CondWait(&sink->space, &sink->lock);
+            }
+            MutexUnlock(&sink->lock);
+        }
+    }
+    
+    memcpy(PipelineSlot(sink, tail), frame, sink->frame_bytes);
+    AtomicStore64(&sink->tail, tail + 1);
+    
+    uint32_t depth = (uint32_t)(tail + 1 - AtomicLoad64(&sink->head));
+    if (depth > sink->max_depth) sink->max_depth = depth;
+    
+    // A busy consumer finds the frame on its own
+    AtomicFenceFull();
+    if (AtomicLoad32(&sink->sleeping)) {
+        MutexLock(&sink->lock);
+        CondSignal(&sink->ready);
+        MutexUnlock(&sink->lock);
+    }
+}
+
+void PipelinePublish(Pipeline* pipeline, const PipelineFrame* frame) {
+    bool fits = frame->frame.samples <= pipeline->samples;
+    for (int i = 0; i < pipeline->sink_count; i++) {
+        if (fits) PipelinePush(&pipeline->sinks[i], frame);
+        else AtomicFetchAdd64(&pipeline->sinks[i].dropped, 1);
+    }
+}
+
+void PipelineGetStats(const Pipeline* pipeline, int index, PipelineSinkStats* stats) {
+    const PipelineSink* sink = &pipeline->sinks[index];
+    uint64_t tail = AtomicLoad64((volatile uint64_t*)&sink->tail);
+    uint64_t head = AtomicLoad64((volatile uint64_t*)&sink->head);
+    
+    stats->delivered = AtomicLoad64((volatile uint64_t*)&sink->delivered);
+    stats->dropped = AtomicLoad64((volatile uint64_t*)&sink->dropped);
+    stats->depth = (uint32_t)(tail - head);
+    stats->max_depth = sink->max_depth;
+    stats->capacity = sink->capacity;
+}
+
+void PipelineShutdown(Pipeline* pipeline) {
+    for (int i = 0; i < pipeline->sink_count; i++) {
+        PipelineSink* sink = &pipeline->sinks[i];
+        MutexLock(&sink->lock);
+        sink->running = false;
+        CondSignal(&sink->ready);
+        MutexUnlock(&sink->lock);
+    }
+    
+    for (int i = 0; i < pipeline->sink_count; i++) {
+        PipelineSink* sink = &pipeline->sinks[i];
+        ThreadJoin(&sink->thread);
+        CondDestroy(&sink->space);
+        CondDestroy(&sink->ready);
+        MutexDestroy(&sink->lock);
+        free(sink->slots);
+        sink->slots = NULL;
+    }
+    
+    pipeline->sink_count = 0;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "metrics.h"
+#include "sync.h"
+#ifdef CURVEBUG_ALLOC_CHECK
+    #include "alloccheck.h"
+#endif
+
+// Fan-out after decode: every published frame is copied into each sink's own
+// bounded queue and handed to the sink on its own thread, so one slow sink
+// never holds up acquisition, the display or the other sinks.
+#define PIPELINE_MAX_SINKS 8
+#define PIPELINE_ALLOC_WARMUP 100       // Frames a sink takes before its allocations count
+
+typedef enum {
+    PIPELINE_DROP_OLDEST,       // Full queue overwrites the oldest frame (live consumers)
+    PIPELINE_DROP_NEWEST,       // Full queue refuses the new frame (keeps a gapless prefix)
+    PIPELINE_BLOCK              // Full queue stalls the producer until there is room
+} PipelinePolicy;
+
+// The frame comes last: a queue slot holds only the samples of its geometry
+typedef struct {
+    uint64_t sequence;
+    uint64_t timestamp_us;
+    int excitation;
+    MetricsResult metrics[2];   // DUT1/DUT2 for this frame's excitation
+    RawFrame frame;
+} PipelineFrame;
+
+typedef void (*PipelineSinkFn)(void* ctx, const PipelineFrame* frame);
+
+typedef struct {
+    uint64_t delivered;
+    uint64_t dropped;
+    uint32_t depth;
+    uint32_t max_depth;
+    uint32_t capacity;
+} PipelineSinkStats;
+
+// Single producer, single consumer ring. head and tail only grow; the slot is
+// index & mask. Under DROP_OLDEST the producer may also advance head, so the
+// consumer copies a slot out first and only keeps it if its own CAS on head wins.
+typedef struct {
+    char name[32];
+    PipelineSinkFn fn;
+    void* ctx;
+    PipelinePolicy policy;
+    
+    uint8_t* slots;             // capacity slots of slot_size bytes
+    size_t slot_size;
+    size_t frame_bytes;         // Used bytes of a PipelineFrame at the geometry
+    uint32_t capacity;
+    uint32_t mask;
+    volatile uint64_t head;
+    volatile uint64_t tail;
+    
+    volatile uint64_t delivered;
+    volatile uint64_t dropped;
+    uint32_t max_depth;
+    
+    // Only used to sleep and wake. The producer takes the lock to signal only
+    // while the consumer has flagged that it is about to wait or waiting.
+    volatile uint32_t sleeping;
+    Mutex lock;
+    Cond ready;
+    Cond space;
+    Thread thread;
+    volatile bool running;
+#ifdef CURVEBUG_ALLOC_CHECK
+    AllocCounts allocs;         // Sink thread, final once PipelineShutdown returns
+#endif
+} PipelineSink;
+
+typedef struct {
+    PipelineSink sinks[PIPELINE_MAX_SINKS];
+    int sink_count;
+    int samples;                // Of every frame published, from the geometry opened
+} Pipeline;
+
+// Queues added afterwards hold frames of this geometry and no larger
+void PipelineInit(Pipeline* pipeline, const FrameGeometry* geometry);
+
+// Capacity is rounded up to a power of two. Starts the sink's thread.
+bool PipelineAddSink(Pipeline* pipeline, const char* name, PipelinePolicy policy, uint32_t capacity,
+                     PipelineSinkFn fn, void* ctx);
+
+// Called from the acquisition thread only. A frame with more samples than the
+// geometry has no slot to go in and counts as dropped at every sink.
+void PipelinePublish(Pipeline* pipeline, const PipelineFrame* frame);
+
+void PipelineGetStats(const Pipeline* pipeline, int index, PipelineSinkStats* stats);
+
+// Lets every sink drain what is already queued, then joins the threads
+void PipelineShutdown(Pipeline* pipeline);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "config.h"
+#include "plotter.h"
+#include <string.h>
+
+void ChannelViewFromSamples(ChannelData* ch, const uint16_t* drive, const uint16_t* raw, int count) {
+    for (int i = 0; i < count; i++) {
+        ch->voltage[i] = (float)raw[i];
+        ch->current[i] = (float)(drive[i] - raw[i]);
+    }
+    ch->count = count;
+}
+
+// The table covers every 16-bit code, so any sample indexes it
+void ChannelViewCalibrated(ChannelData* ch, const uint16_t* drive, const uint16_t* raw, int count,
+                           const CalibrationTable* calib, float ma_per_volt) {
+    for (int i = 0; i < count; i++) {
+        float v_drive = calib->volts[drive[i]];
+        float v_dut = calib->volts[raw[i]];
+        ch->voltage[i] = v_dut;
+        ch->current[i] = (v_drive - v_dut) * ma_per_volt;
+    }
+    ch->count = count;
+}
+
+// Derived traces pair samples by sweep position, which both leads share
+void ChannelViewCombine(ChannelData* out, const ChannelData* a, const ChannelData* b, bool average) {
+    int count = a->count < b->count ? a->count : b->count;
+    for (int i = 0; i < count; i++) {
+        out->voltage[i] = (a->voltage[i] + b->voltage[i]) * 0.5f;
+        out->current[i] = average ? (a->current[i] + b->current[i]) * 0.5f : a->current[i] - b->current[i];
+    }
+    out->count = count;
+}
+
+// Both views must have room for src's samples
+void ChannelViewCopy(ChannelData* dst, const ChannelData* src) {
+    memcpy(dst->voltage, src->voltage, sizeof(float) * src->count);
+    memcpy(dst->current, src->current, sizeof(float) * src->count);
+    dst->count = src->count;
+}
+
+// Cached with the view so every pane can auto-scale without walking the samples
+void ChannelViewBounds(const ChannelData* ch, float* bounds) {
+    float lo_x = 0, hi_x = 0, lo_y = 0, hi_y = 0;
+    if (ch->count > 0) {
+        lo_x = hi_x = ch->voltage[0];
+        lo_y = hi_y = ch->current[0];
+    }
+    for (int i = 1; i < ch->count; i++) {
+        if (ch->voltage[i] < lo_x) lo_x = ch->voltage[i];
+        if (ch->voltage[i] > hi_x) hi_x = ch->voltage[i];
+        if (ch->current[i] < lo_y) lo_y = ch->current[i];
+        if (ch->current[i] > hi_y) hi_y = ch->current[i];
+    }
+    bounds[0] = lo_x;
+    bounds[1] = hi_x;
+    bounds[2] = lo_y;
+    bounds[3] = hi_y;
+}
+
+void PlotAxesRaw(PlotAxes* axes, int bits, int origin) {
+    float scale = FrameCountScale(bits);
+    float y_range = PLOT_RAW_Y_RANGE * scale;
+    
+    axes->x_min = origin - FRAME_ORIGIN * scale;
+    axes->x_max = origin + (PLOT_RAW_X_MAX - FRAME_ORIGIN) * scale;
+    if (axes->x_min < 0) axes->x_min = 0;
+    if (axes->x_max > FrameCodeMax(bits)) axes->x_max = (float)FrameCodeMax(bits);
+    axes->y_max = y_range / 8.0f;
+    axes->y_min = -y_range * 7.0f / 8.0f;
+    axes->x_origin = (float)origin;
+    axes->y_origin = 0;
+    axes->x_label = "DUT Voltage";
+    axes->y_label = "Current";
+    axes->tick_format = "%.0f";
+}
+
+// Same framing as the raw axes, mapped through the calibration
+void PlotAxesCalibrated(PlotAxes* axes, const CalibrationTable* calib, int bits, int origin, bool weak) {
+    PlotAxes raw;
+    PlotAxesRaw(&raw, bits, origin);
+    
+    float ma_per_count = calib->profile.gain * calib->ma_per_volt[weak ? 1 : 0];
+    
+    axes->x_min = calib->volts[(int)raw.x_min];
+    axes->x_max = calib->volts[(int)raw.x_max];
+    axes->y_min = raw.y_min * ma_per_count;
+    axes->y_max = raw.y_max * ma_per_count;
+    if (axes->y_min > axes->y_max) {
+        float t = axes->y_min;
+        axes->y_min = axes->y_max;
+        axes->y_max = t;
+    }
+    axes->x_origin = calib->volts[origin];
+    axes->y_origin = 0;
+    axes->x_label = "DUT Voltage (V)";
+    axes->y_label = "Current (mA)";
+    axes->tick_format = "%.2f";
+}
\ No newline at end of file
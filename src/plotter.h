@@ -3,43 +3,162 @@
 
 #include <raylib.h>
 #include <stdbool.h>
+#include "frame.h"
+#include "calib.h"
+#include "metrics.h"
+#include "diff.h"
+#include "spline.h"
+#include "classify.h"
 
-#define ADC_MAX 2800
-#define ADC_ORIGIN 2048
-#define MAX_SAMPLES 336
+// Default raw framing in 12-bit counts around FRAME_ORIGIN, scaled to the
+// depth and origin of the frames shown
+#define PLOT_RAW_X_MAX 2800
+#define PLOT_RAW_Y_RANGE 2100
+#define MAX_SAMPLES FRAME_MAX_SAMPLES
+#define CURVE_MAX_CHANNELS 8
 
+// Float view of one channel, rebuilt from FrameSamples only when that
+// excitation's samples change. It stays resident next to them as the cache
+// drawing, splines, metrics and the cursor index read, so CurveData holds both
+// forms; only frames kept elsewhere (history, rings, references) are integer.
+// The arrays belong to whoever owns the view: CurveData sizes its channels'
+// views for the geometry opened, see CurveDataReserve.
 typedef struct {
-    float voltage[MAX_SAMPLES];
-    float current[MAX_SAMPLES];
+    float* voltage;
+    float* current;
     int count;
 } ChannelData;
 
+typedef enum {
+    CURVE_SOURCE_LEAD = 0,      // ch1 or ch2 of the device's frame
+    CURVE_SOURCE_REFERENCE,     // Stored copy of another channel, never updated
+    CURVE_SOURCE_DIFFERENCE,    // Current of a minus b against their mean voltage
+    CURVE_SOURCE_AVERAGE        // Mean of a and b
+} CurveSource;
+
+#define CURVE_SOURCE_BIT(s) (1u << (s))
+
+#define CURVE_LEAD_DUT1 1
+#define CURVE_LEAD_DUT2 2
+
+// One logical trace. Both excitations sit next to each other so a channel's
+// views, splines and metrics are walked together.
 typedef struct {
-    ChannelData ch1_std;
-    ChannelData ch2_std;
-    ChannelData ch1_weak;
-    ChannelData ch2_weak;
+    CurveSource source;
+    int lead;               // CURVE_SOURCE_LEAD: 0 = ch1 (black), 1 = ch2 (red)
+    int a, b;               // Input channels of a derived trace, always lower indices
+    unsigned leads;         // CURVE_LEAD_* this trace depends on, for single channel mode
+    char name[32];
+    bool visible;
     
-    ChannelData* ch1_active;
-    ChannelData* ch2_active;
+    ChannelData view[2];    // [excitation]
+    float bounds[2][4];     // x_min, x_max, y_min, y_max of each view, updated with it
+    uint32_t frame[2];      // Frame the view was taken from
+    Spline spline[2];
+    MetricsResult metrics[2];   // Lead channels only
+    ClassifyResult classification[2];
+} CurveChannel;
+
+typedef struct {
+    FrameSamples samples_std;
+    FrameSamples samples_weak;
+    bool views_dirty[2];    // Indexed by excitation, 0=4.7K, 1=100K
+    bool splines_dirty[2];  // Splines are rebuilt lazily after the views change
+    uint32_t generation[2]; // Bumped whenever an excitation's views or the channel list change
+    uint32_t frame_index[2];    // Frame number of the latest samples per excitation
+    const CalibrationTable* calib;  // NULL plots raw ADC counts
+    
+    // Channels 0 and 1 are always the DUT1/DUT2 leads; derived traces follow their inputs
+    CurveChannel channels[CURVE_MAX_CHANNELS];
+    int channel_count;
     
     bool last_was_weak;
     int excitation_mode; // 0=4.7K, 1=100K, 2=ALT
-    bool alt_use_weak;
+    
+    float rtt_ms;           // Command to last byte of the most recent frame
+    
+    DiffParams diff_params;
+    DiffResult diff[2];             // DUT1 - DUT2 per excitation, computed at ingest
+    
+    float metrics_us;               // Time spent on the last metrics and classification pass
+    
+    // Views and splines of every channel slot, for frames of up to capacity
+    // samples. Each slot keeps its own storage when channels are added or removed.
+    float* view_storage;
+    SplineSegment* spline_storage;
+    int capacity;
 } CurveData;
 
+// Default (zoom 1, no pan) view range and labelling, in raw counts or physical units
+typedef struct {
+    float x_min;
+    float x_max;
+    float y_min;
+    float y_max;
+    float x_origin;
+    float y_origin;
+    const char* x_label;
+    const char* y_label;
+    const char* tick_format;
+} PlotAxes;
+
 typedef struct {
     Rectangle area;
+    PlotAxes axes;
     bool auto_scale;
+    bool smooth;            // Draw traces as monotone cubics instead of straight segments
     float zoom;
     float pan_x;
     float pan_y;
     bool dragging;
+    int excitation;         // -1 = the latest frame's, with the other dimmed in ALT; 0/1 = always that one
+    unsigned sources;       // CURVE_SOURCE_BIT()s of the channels drawn, 0 = all
+    const char* title;      // Pane name in the multi-pane layout, NULL = none
+    float x_min, x_max, y_min, y_max;   // Visible range as of the last draw
     Vector2 drag_start;
     Vector2 drag_offset;
 } PlotView;
 
+#define PLOT_MAX_PANES 3
+
+void ChannelViewFromSamples(ChannelData* ch, const uint16_t* drive, const uint16_t* raw, int count);
+void ChannelViewCalibrated(ChannelData* ch, const uint16_t* drive, const uint16_t* raw, int count,
+                           const CalibrationTable* calib, float ma_per_volt);
+
+void ChannelViewCombine(ChannelData* out, const ChannelData* a, const ChannelData* b, bool average);
+void ChannelViewCopy(ChannelData* dst, const ChannelData* src);
+void ChannelViewBounds(const ChannelData* ch, float* bounds);
+
+// On a zeroed CurveData; it holds no frames until CurveDataReserve
+void CurveDataInit(CurveData* data);
+
+// Grows the views and splines to frames of samples points, keeping what the
+// views show. Called when the device or a capture is opened; CurveDataStore
+// also grows them for a larger frame, so steady state never allocates.
+bool CurveDataReserve(CurveData* data, int samples);
+void CurveDataFree(CurveData* data);
+int CurveDataAddDerived(CurveData* data, CurveSource source, int a, int b, const char* name);
+int CurveDataAddReference(CurveData* data, int from, const char* name);
+void CurveDataRemoveChannels(CurveData* data, CurveSource source);
+bool CurveDataAlternating(const CurveData* data);
+int CurveDataFindSource(const CurveData* data, CurveSource source);
+bool CurveDataChannelShown(const CurveData* data, int channel, bool single_channel);
+bool CurveDataBounds(CurveData* data, const PlotView* view, bool single_channel, bool both_excitations,
+                     float* x_min, float* x_max, float* y_min, float* y_max);
+void CurveDataStore(CurveData* data, const RawFrame* frame, bool weak);
+void CurveDataUpdateViews(CurveData* data);
+void CurveDataUpdateSplines(CurveData* data);
+void CurveDataUpdateMetrics(CurveData* data, bool weak);
+
+void PlotAxesRaw(PlotAxes* axes, int bits, int origin);
+void PlotAxesCalibrated(PlotAxes* axes, const CalibrationTable* calib, int bits, int origin, bool weak);
+
 void PlotViewInit(PlotView* view, Rectangle area);
+void PlotPanesSetSplit(PlotView* views, bool split);
+int PlotViewExcitation(const PlotView* view, const CurveData* data);
+bool PlotViewShowsBoth(const PlotView* view, const CurveData* data);
+bool PlotViewShowsChannel(const PlotView* view, const CurveData* data, int channel, bool single_channel);
+void PlotViewLink(PlotView* views, int count, int from);
 void PlotViewDraw(PlotView* view, CurveData* data, Config* config, bool single_channel);
 void PlotViewHandlePan(PlotView* view, Vector2 mouse_pos);
 void PlotViewHandleZoom(PlotView* view, float wheel);
@@ -0,0 +1,482 @@
+#include "raster.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ASCII 32-126, seven rows per glyph, bit 4 is the leftmost column
+static const uint8_t RASTER_FONT[95][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04},  // '!'
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00},  // '"'
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A},  // '#'
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04},  // '$'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03},  // '%'
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D},  // '&'
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00},  // '\''
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02},  // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08},  // ')'
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00},  // '*'
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00},  // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08},  // ','
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},  // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},  // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00},  // '/'
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},  // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},  // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},  // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},  // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},  // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},  // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},  // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},  // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},  // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},  // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00},  // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08},  // ';'
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02},  // '<'
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00},  // '='
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08},  // '>'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04},  // '?'
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E},  // '@'
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},  // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},  // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},  // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},  // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},  // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},  // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},  // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},  // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},  // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},  // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},  // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},  // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},  // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},  // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},  // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},  // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},  // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},  // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},  // 'X'
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},  // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F},  // 'Z'
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E},  // '['
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00},  // '\\'
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E},  // ']'
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00},  // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},  // '_'
+    {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00},  // '`'
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F},  // 'a'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E},  // 'b'
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E},  // 'c'
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F},  // 'd'
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E},  // 'e'
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08},  // 'f'
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E},  // 'g'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11},  // 'h'
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E},  // 'i'
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C},  // 'j'
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12},  // 'k'
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},  // 'l'
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11},  // 'm'
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11},  // 'n'
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E},  // 'o'
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10},  // 'p'
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01},  // 'q'
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10},  // 'r'
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E},  // 's'
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06},  // 't'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D},  // 'u'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04},  // 'v'
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A},  // 'w'
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11},  // 'x'
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E},  // 'y'
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F},  // 'z'
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02},  // '{'
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},  // '|'
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08},  // '}'
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00},  // '~'
+};
+
+bool RasterImageCreate(RasterImage* image, int width, int height) {
+    image->width = width;
+    image->height = height;
+    image->pixels = malloc((size_t)width * height * 4);
+    RasterResetClip(image);
+    return image->pixels != NULL;
+}
+
+void RasterSetClip(RasterImage* image, int x, int y, int width, int height) {
+    image->clip_x0 = x < 0 ? 0 : x;
+    image->clip_y0 = y < 0 ? 0 : y;
+    image->clip_x1 = x + width > image->width ? image->width : x + width;
+    image->clip_y1 = y + height > image->height ? image->height : y + height;
+}
+
+void RasterResetClip(RasterImage* image) {
+    RasterSetClip(image, 0, 0, image->width, image->height);
+}
+
+void RasterImageFree(RasterImage* image) {
+    free(image->pixels);
+    image->pixels = NULL;
+}
+
+void RasterClear(RasterImage* image, Color color) {
+    uint8_t* p = image->pixels;
+    size_t count = (size_t)image->width * image->height;
+    for (size_t i = 0; i < count; i++, p += 4) {
+        p[0] = color.r;
+        p[1] = color.g;
+        p[2] = color.b;
+        p[3] = color.a;
+    }
+}
+
+// Source-over with coverage in 0..256
+static void RasterBlend(RasterImage* image, int x, int y, Color color, int coverage) {
+    if (x < image->clip_x0 || y < image->clip_y0 || x >= image->clip_x1 || y >= image->clip_y1) return;
+    
+    int a = color.a * coverage >> 8;
+    uint8_t* p = image->pixels + ((size_t)y * image->width + x) * 4;
+    p[0] = (uint8_t)(p[0] + ((color.r - p[0]) * a) / 255);
+    p[1] = (uint8_t)(p[1] + ((color.g - p[1]) * a) / 255);
+    p[2] = (uint8_t)(p[2] + ((color.b - p[2]) * a) / 255);
+    p[3] = (uint8_t)(p[3] + ((255 - p[3]) * a) / 255);
+}
+
+void RasterFillRect(RasterImage* image, float x, float y, float width, float height, Color color) {
+    int x0 = (int)floorf(x), y0 = (int)floorf(y);
+    int x1 = (int)ceilf(x + width), y1 = (int)ceilf(y + height);
+    if (x0 < image->clip_x0) x0 = image->clip_x0;
+    if (y0 < image->clip_y0) y0 = image->clip_y0;
+    if (x1 > image->clip_x1) x1 = image->clip_x1;
+    if (y1 > image->clip_y1) y1 = image->clip_y1;
+    
+    for (int py = y0; py < y1; py++) {
+        for (int px = x0; px < x1; px++) {
+            RasterBlend(image, px, py, color, 256);
+        }
+    }
+}
+
+void RasterRectLines(RasterImage* image, float x, float y, float width, float height, float thick, Color color) {
+    RasterFillRect(image, x, y, width, thick, color);
+    RasterFillRect(image, x, y + height - thick, width, thick, color);
+    RasterFillRect(image, x, y + thick, thick, height - 2 * thick, color);
+    RasterFillRect(image, x + width - thick, y + thick, thick, height - 2 * thick, color);
+}
+
+// Coverage is one pixel of falloff around the capsule, from the distance of
+// each pixel centre to the segment. Cost follows the segment's bounding box.
+void RasterLine(RasterImage* image, float x1, float y1, float x2, float y2, float thick, Color color) {
+    float half = thick * 0.5f;
+    float pad = half + 1.0f;
+    
+    int bx0 = (int)floorf(fminf(x1, x2) - pad), bx1 = (int)ceilf(fmaxf(x1, x2) + pad);
+    int by0 = (int)floorf(fminf(y1, y2) - pad), by1 = (int)ceilf(fmaxf(y1, y2) + pad);
+    if (bx0 < image->clip_x0) bx0 = image->clip_x0;
+    if (by0 < image->clip_y0) by0 = image->clip_y0;
+    if (bx1 > image->clip_x1) bx1 = image->clip_x1;
+    if (by1 > image->clip_y1) by1 = image->clip_y1;
+    
+    float dx = x2 - x1, dy = y2 - y1;
+    float len2 = dx * dx + dy * dy;
+    float inv_len2 = len2 > 0 ? 1.0f / len2 : 0;
+    
+    for (int py = by0; py < by1; py++) {
+        float cy = py + 0.5f - y1;
+        for (int px = bx0; px < bx1; px++) {
+            float cx = px + 0.5f - x1;
+            float t = (cx * dx + cy * dy) * inv_len2;
+            if (t < 0) t = 0;
+            if (t > 1) t = 1;
+            
+            float ex = cx - t * dx, ey = cy - t * dy;
+            float cover = half + 0.5f - sqrtf(ex * ex + ey * ey);
+            if (cover <= 0) continue;
+            if (cover > 1) cover = 1;
+            RasterBlend(image, px, py, color, (int)(cover * 256));
+        }
+    }
+}
+
+static int RasterTextScale(int size) {
+    int scale = (size + 5) / 10;
+    return scale < 1 ? 1 : scale;
+}
+
+int RasterTextWidth(const char* text, int size) {
+    return (int)strlen(text) * 6 * RasterTextScale(size);
+}
+
+void RasterText(RasterImage* image, const char* text, int x, int y, int size, Color color) {
+    int scale = RasterTextScale(size);
+    
+    for (; *text; text++, x += 6 * scale) {
+        unsigned char ch = (unsigned char)*text;
+        if (ch < 32 || ch > 126) ch = '?';
+        const uint8_t* glyph = RASTER_FONT[ch - 32];
+        
+        for (int row = 0; row < 7; row++) {
+            for (int col = 0; col < 5; col++) {
+                if (!(glyph[row] & (0x10 >> col))) continue;
+                RasterFillRect(image, (float)(x + col * scale), (float)(y + row * scale),
+                               (float)scale, (float)scale, color);
+            }
+        }
+    }
+}
+
+// PNG output: adaptive row filters, then zlib with a fixed-Huffman deflate and
+// a hash-chain LZ77. Plots are mostly flat fills, which this packs tightly
+// without pulling in zlib.
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+    uint32_t bits;
+    int bit_count;
+    bool failed;
+} RasterBuffer;
+
+static void RasterPutByte(RasterBuffer* buf, uint8_t v) {
+    if (buf->length == buf->capacity) {
+        size_t capacity = buf->capacity ? buf->capacity * 2 : 65536;
+        uint8_t* data = realloc(buf->data, capacity);
+        if (!data) {
+            buf->failed = true;
+            return;
+        }
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+    buf->data[buf->length++] = v;
+}
+
+static void RasterPut32BE(RasterBuffer* buf, uint32_t v) {
+    for (int i = 3; i >= 0; i--) RasterPutByte(buf, (uint8_t)(v >> (i * 8)));
+}
+
+static void RasterPutBits(RasterBuffer* buf, uint32_t value, int count) {
+    buf->bits |= value << buf->bit_count;
+    buf->bit_count += count;
+    while (buf->bit_count >= 8) {
+        RasterPutByte(buf, (uint8_t)buf->bits);
+        buf->bits >>= 8;
+        buf->bit_count -= 8;
+    }
+}
+
+// Huffman codes go out most significant bit first
+static void RasterPutCode(RasterBuffer* buf, uint32_t code, int length) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+    RasterPutBits(buf, reversed, length);
+}
+
+static void RasterPutLiteral(RasterBuffer* buf, int symbol) {
+    if (symbol < 144) RasterPutCode(buf, 0x30 + symbol, 8);
+    else if (symbol < 256) RasterPutCode(buf, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) RasterPutCode(buf, symbol - 256, 7);
+    else RasterPutCode(buf, 0xC0 + symbol - 280, 8);
+}
+
+static const uint16_t RASTER_LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t RASTER_LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t RASTER_DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t RASTER_DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void RasterPutMatch(RasterBuffer* buf, int length, int distance) {
+    int l = 28;
+    while (RASTER_LEN_BASE[l] > length) l--;
+    RasterPutLiteral(buf, 257 + l);
+    RasterPutBits(buf, length - RASTER_LEN_BASE[l], RASTER_LEN_EXTRA[l]);
+    
+    int d = 29;
+    while (RASTER_DIST_BASE[d] > distance) d--;
+    RasterPutCode(buf, d, 5);
+    RasterPutBits(buf, distance - RASTER_DIST_BASE[d], RASTER_DIST_EXTRA[d]);
+}
+
+#define RASTER_WINDOW 32768
+#define RASTER_HASH_BITS 15
+#define RASTER_MAX_CHAIN 32
+
+static uint32_t RasterHash(const uint8_t* p) {
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - RASTER_HASH_BITS);
+}
+
+static bool RasterDeflate(RasterBuffer* buf, const uint8_t* in, size_t length) {
+    int32_t* head = malloc(sizeof(int32_t) << RASTER_HASH_BITS);
+    int32_t* prev = malloc(sizeof(int32_t) * RASTER_WINDOW);
+    if (!head || !prev) {
+        free(head);
+        free(prev);
+        return false;
+    }
+    for (int i = 0; i < (1 << RASTER_HASH_BITS); i++) head[i] = -1;
+    
+    // One final block with the fixed code tables
+    RasterPutBits(buf, 1, 1);
+    RasterPutBits(buf, 1, 2);
+    
+    size_t i = 0;
+    while (i < length) {
+        int best_len = 0, best_dist = 0;
+        
+        if (i + 3 <= length) {
+            uint32_t h = RasterHash(in + i);
+            size_t max_len = length - i < 258 ? length - i : 258;
+            int32_t candidate = head[h];
+            
+            for (int chain = 0; chain < RASTER_MAX_CHAIN && candidate >= 0; chain++) {
+                size_t dist = i - (size_t)candidate;
+                if (dist > RASTER_WINDOW - 1) break;
+                
+                size_t n = 0;
+                while (n < max_len && in[candidate + n] == in[i + n]) n++;
+                if ((int)n > best_len) {
+                    best_len = (int)n;
+                    best_dist = (int)dist;
+                    if (n == max_len) break;
+                }
+                candidate = prev[candidate & (RASTER_WINDOW - 1)];
+            }
+        }
+        
+        size_t advance = best_len >= 3 ? (size_t)best_len : 1;
+        if (best_len >= 3) {
+            RasterPutMatch(buf, best_len, best_dist);
+        } else {
+            RasterPutLiteral(buf, in[i]);
+        }
+        
+        // Index every position covered so later matches can find it
+        for (size_t end = i + advance; i < end; i++) {
+            if (i + 3 > length) continue;
+            uint32_t h = RasterHash(in + i);
+            prev[i & (RASTER_WINDOW - 1)] = head[h];
+            head[h] = (int32_t)i;
+        }
+    }
+    
+    RasterPutLiteral(buf, 256);
+    if (buf->bit_count > 0) RasterPutBits(buf, 0, 8 - buf->bit_count);
+    
+    free(head);
+    free(prev);
+    return !buf->failed;
+}
+
+static uint32_t RasterCrc(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void RasterChunk(RasterBuffer* out, const char* type, const uint8_t* data, size_t length) {
+    RasterPut32BE(out, (uint32_t)length);
+    size_t start = out->length;
+    for (int i = 0; i < 4; i++) RasterPutByte(out, (uint8_t)type[i]);
+    for (size_t i = 0; i < length; i++) RasterPutByte(out, data[i]);
+    if (out->failed) return;
+    RasterPut32BE(out, RasterCrc(out->data + start, out->length - start, 0));
+}
+
+// Pick the cheapest of None, Sub and Up by sum of absolute residuals
+static void RasterFilterRow(const uint8_t* row, const uint8_t* above, int bytes, uint8_t* out) {
+    uint8_t* candidates[3] = {out + 1, out + 2 + bytes, out + 3 + 2 * bytes};
+    uint32_t cost[3] = {0, 0, 0};
+    
+    for (int i = 0; i < bytes; i++) {
+        uint8_t left = i >= 4 ? row[i - 4] : 0;
+        uint8_t up = above ? above[i] : 0;
+        uint8_t v[3] = {row[i], (uint8_t)(row[i] - left), (uint8_t)(row[i] - up)};
+        for (int f = 0; f < 3; f++) {
+            candidates[f][i] = v[f];
+            cost[f] += v[f] < 128 ? v[f] : 256 - v[f];
+        }
+    }
+    
+    int best = 0;
+    for (int f = 1; f < 3; f++) {
+        if (cost[f] < cost[best]) best = f;
+    }
+    out[0] = (uint8_t)best;
+    if (best != 0) memmove(out + 1, candidates[best], bytes);
+}
+
+bool RasterWritePng(const RasterImage* image, const char* path) {
+    int row_bytes = image->width * 4;
+    size_t raw_length = (size_t)(row_bytes + 1) * image->height;
+    
+    // Filter scratch holds all three candidates for one row past the end
+    uint8_t* raw = malloc(raw_length + 3 * (size_t)row_bytes + 3);
+    if (!raw) return false;
+    
+    for (int y = 0; y < image->height; y++) {
+        const uint8_t* row = image->pixels + (size_t)y * row_bytes;
+        const uint8_t* above = y > 0 ? row - row_bytes : NULL;
+        uint8_t* scratch = raw + raw_length;
+        RasterFilterRow(row, above, row_bytes, scratch);
+        memcpy(raw + (size_t)y * (row_bytes + 1), scratch, row_bytes + 1);
+    }
+    
+    RasterBuffer z = {0};
+    RasterPutByte(&z, 0x78);
+    RasterPutByte(&z, 0x01);
+    bool ok = RasterDeflate(&z, raw, raw_length);
+    
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw_length; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    RasterPut32BE(&z, (b << 16) | a);
+    free(raw);
+    
+    RasterBuffer png = {0};
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    for (int i = 0; i < 8; i++) RasterPutByte(&png, signature[i]);
+    
+    uint8_t ihdr[13] = {0};
+    for (int i = 0; i < 4; i++) {
+        ihdr[i] = (uint8_t)(image->width >> (24 - i * 8));
+        ihdr[4 + i] = (uint8_t)(image->height >> (24 - i * 8));
+    }
+    ihdr[8] = 8;        // Bit depth
+    ihdr[9] = 6;        // RGBA
+    RasterChunk(&png, "IHDR", ihdr, sizeof(ihdr));
+    if (ok && !z.failed) RasterChunk(&png, "IDAT", z.data, z.length);
+    RasterChunk(&png, "IEND", NULL, 0);
+    free(z.data);
+    
+    ok = ok && !z.failed && !png.failed;
+    if (ok) {
+        FILE* f = fopen(path, "wb");
+        ok = f && fwrite(png.data, 1, png.length, f) == png.length;
+        if (f && fclose(f) != 0) ok = false;
+    }
+    
+    free(png.data);
+    return ok;
+}
\ No newline at end of file
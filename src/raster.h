@@ -0,0 +1,38 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <raylib.h>
+
+// CPU rasterizer for rendering plots without a window or GL context.
+// Only raylib's plain data types are used, none of its functions, so code
+// built on this runs on headless machines.
+typedef struct {
+    int width;
+    int height;
+    uint8_t* pixels;            // RGBA8, rows top to bottom
+    int clip_x0, clip_y0, clip_x1, clip_y1;
+} RasterImage;
+
+bool RasterImageCreate(RasterImage* image, int width, int height);
+void RasterImageFree(RasterImage* image);
+
+// Drawing outside the clip rectangle is discarded; Create sets it to the whole image
+void RasterSetClip(RasterImage* image, int x, int y, int width, int height);
+void RasterResetClip(RasterImage* image);
+
+void RasterClear(RasterImage* image, Color color);
+void RasterFillRect(RasterImage* image, float x, float y, float width, float height, Color color);
+void RasterRectLines(RasterImage* image, float x, float y, float width, float height, float thick, Color color);
+
+// Antialiased line with round caps, thickness in pixels
+void RasterLine(RasterImage* image, float x1, float y1, float x2, float y2, float thick, Color color);
+
+// Built-in 5x7 font, scaled to roughly match DrawText at the same size
+void RasterText(RasterImage* image, const char* text, int x, int y, int size, Color color);
+int RasterTextWidth(const char* text, int size);
+
+bool RasterWritePng(const RasterImage* image, const char* path);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE         // pthread_setaffinity_np
+#endif
+
+#include "realtime.h"
+#include "sync.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <sched.h>
+    #include <sys/mman.h>
+#endif
+
+const uint32_t REALTIME_JITTER_LIMITS_US[REALTIME_JITTER_BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+
+static size_t RealtimePageSize(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+#endif
+}
+
+void RealtimeQuery(RealtimeStatus* status) {
+    memset(status, 0, sizeof(*status));
+    status->cpu = -1;
+    
+#ifdef _WIN32
+    int priority = GetThreadPriority(GetCurrentThread());
+    status->fifo = priority == THREAD_PRIORITY_TIME_CRITICAL;
+    if (status->fifo) {
+        snprintf(status->policy, sizeof(status->policy), "TIME_CRITICAL");
+    } else {
+        snprintf(status->policy, sizeof(status->policy), "priority %d", priority);
+    }
+#else
+    int policy;
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) {
+        snprintf(status->policy, sizeof(status->policy), "unknown");
+        return;
+    }
+    status->fifo = policy == SCHED_FIFO || policy == SCHED_RR;
+    if (status->fifo) {
+        snprintf(status->policy, sizeof(status->policy), "%s %d",
+                 policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", param.sched_priority);
+    } else {
+        snprintf(status->policy, sizeof(status->policy), "SCHED_OTHER");
+    }
+#endif
+}
+
+static bool RealtimePin(int cpu) {
+#if defined(_WIN32)
+    if (cpu >= (int)(sizeof(DWORD_PTR) * 8)) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    // macOS only takes affinity hints, nothing it promises to honour
+    (void)cpu;
+    return false;
+#endif
+}
+
+static bool RealtimeRaise(int priority) {
+#ifdef _WIN32
+    (void)priority;
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+    int lo = sched_get_priority_min(SCHED_FIFO);
+    int hi = sched_get_priority_max(SCHED_FIFO);
+    struct sched_param param = {0};
+    param.sched_priority = priority < lo ? lo : priority > hi ? hi : priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
+
+bool RealtimeEnter(RealtimeStatus* status, int cpu, int priority) {
+    if (cpu < 0) cpu = ThreadCpuCount() - 1;
+    bool pinned = RealtimePin(cpu);
+    bool raised = RealtimeRaise(priority);
+    
+    RealtimeQuery(status);
+    status->cpu = pinned ? cpu : -1;
+    return pinned && raised && status->fifo;
+}
+
+void RealtimePrefault(RealtimeStatus* status, void* ptr, size_t size) {
+    if (!ptr || size == 0) return;
+    
+    // A read alone would map the shared zero page; the write makes it private
+    size_t page = RealtimePageSize();
+    volatile uint8_t* bytes = (volatile uint8_t*)ptr;
+    size_t first = page - ((uintptr_t)ptr % page);
+    bytes[0] = bytes[0];
+    for (size_t i = first; i < size; i += page) {
+        bytes[i] = bytes[i];
+    }
+    status->prefaulted_bytes += size;
+}
+
+bool RealtimeLock(RealtimeStatus* status, void* ptr, size_t size) {
+    if (!ptr || size == 0) return true;
+    RealtimePrefault(status, ptr, size);
+    
+#ifdef _WIN32
+    // VirtualLock only succeeds within the minimum working set
+    SIZE_T min_ws, max_ws;
+    bool locked = false;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws) &&
+        SetProcessWorkingSetSize(GetCurrentProcess(), min_ws + size, max_ws + size)) {
+        locked = VirtualLock(ptr, size) != 0;
+    }
+#else
+    bool locked = mlock(ptr, size) == 0;
+#endif
+    
+    if (locked) {
+        status->locked_bytes += size;
+    } else {
+        status->lock_failed_bytes += size;
+    }
+    return locked;
+}
+
+void RealtimeJitterInit(RealtimeJitter* jitter) {
+    memset(jitter, 0, sizeof(*jitter));
+}
+
+void RealtimeJitterAdd(RealtimeJitter* jitter, uint64_t timestamp_us) {
+    if (jitter->last_us && timestamp_us > jitter->last_us) {
+        uint64_t interval = timestamp_us - jitter->last_us;
+        jitter->intervals++;
+        jitter->interval_sum_us += interval;
+        if (interval > jitter->interval_max_us) jitter->interval_max_us = interval;
+        
+        if (jitter->last_interval_us) {
+            uint64_t delta = interval > jitter->last_interval_us ? interval - jitter->last_interval_us
+                                                                 : jitter->last_interval_us - interval;
+            int b = 0;
+            while (b < REALTIME_JITTER_BUCKETS - 1 && delta >= REALTIME_JITTER_LIMITS_US[b]) b++;
+            jitter->counts[b]++;
+            jitter->samples++;
+            if (delta > jitter->jitter_max_us) jitter->jitter_max_us = delta;
+        }
+        jitter->last_interval_us = interval;
+    }
+    jitter->last_us = timestamp_us;
+}
+
+void RealtimeJitterBreak(RealtimeJitter* jitter) {
+    jitter->last_us = 0;
+    jitter->last_interval_us = 0;
+}
+
+void RealtimeJitterMiss(RealtimeJitter* jitter) {
+    jitter->misses++;
+    RealtimeJitterBreak(jitter);
+}
\ No newline at end of file
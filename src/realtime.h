@@ -0,0 +1,65 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Opt-in real-time treatment of the acquisition path: the calling thread is
+// pinned to one core and raised to SCHED_FIFO (time-critical priority on
+// Windows), and the buffers it touches per frame are locked into RAM. Pinning
+// and the class act on the calling thread, and threads it starts afterwards
+// inherit both, so the acquisition thread applies them to itself and starts
+// nothing. Without the privilege for a step that step is skipped, and the
+// status says what was actually achieved.
+typedef struct {
+    int cpu;                    // Core the thread is pinned to, -1 = not pinned
+    bool fifo;                  // Real-time class granted
+    char policy[32];            // Scheduling class read back, e.g. "SCHED_FIFO 20"
+    uint64_t locked_bytes;
+    uint64_t lock_failed_bytes; // Refused, usually RLIMIT_MEMLOCK; prefaulted only
+    uint64_t prefaulted_bytes;
+} RealtimeStatus;
+
+// Reads back the calling thread's scheduling class without changing it
+void RealtimeQuery(RealtimeStatus* status);
+
+// cpu < 0 picks the last online core. Returns true if both pinning and the
+// real-time class were granted.
+bool RealtimeEnter(RealtimeStatus* status, int cpu, int priority);
+
+// Writes every page so the first frame does not take the page faults
+void RealtimePrefault(RealtimeStatus* status, void* ptr, size_t size);
+
+// Prefaults and keeps the pages resident. False if the lock was refused.
+bool RealtimeLock(RealtimeStatus* status, void* ptr, size_t size);
+
+// Inter-frame jitter: how much each interval between frames differs from the
+// one before, so a steady rate of any period reads as zero. Buckets are upper
+// limits from REALTIME_JITTER_LIMITS_US, the last one takes everything above.
+#define REALTIME_JITTER_BUCKETS 12
+
+extern const uint32_t REALTIME_JITTER_LIMITS_US[REALTIME_JITTER_BUCKETS - 1];
+
+typedef struct {
+    uint64_t last_us;           // Previous frame, 0 = chain broken
+    uint64_t last_interval_us;  // 0 = no interval yet
+    uint64_t counts[REALTIME_JITTER_BUCKETS];
+    uint64_t samples;
+    uint64_t intervals;
+    uint64_t interval_sum_us;
+    uint64_t interval_max_us;
+    uint64_t jitter_max_us;
+    uint64_t misses;            // Acquisitions that timed out
+} RealtimeJitter;
+
+void RealtimeJitterInit(RealtimeJitter* jitter);
+void RealtimeJitterAdd(RealtimeJitter* jitter, uint64_t timestamp_us);
+
+// Acquisition stopped on purpose (pause, settings, review); the gap is not jitter
+void RealtimeJitterBreak(RealtimeJitter* jitter);
+
+// Counts a timed out acquisition and breaks the chain
+void RealtimeJitterMiss(RealtimeJitter* jitter);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,411 @@
+#include "sequence.h"
+#include "capture.h"
+#include "classify.h"
+#include "trigger.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char* SEQUENCE_OUTCOME_NAMES[4] = {"PASS", "FAIL", "TAUGHT", "SKIPPED"};
+
+bool SequencePlanLoad(SequencePlan* plan, const char* path) {
+    memset(plan, 0, sizeof(*plan));
+    plan->average = 6;
+    plan->limit = 12.0f;
+    plan->settle = 6.0f;
+    plan->channels = 1;
+    
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    
+    bool valid = true;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char section[64];
+        if (sscanf(line, " [%63[^]]]", section) == 1) {
+            strcpy(plan->board, section);
+            continue;
+        }
+        
+        line[strcspn(line, ";#\r\n")] = '\0';
+        char key[128], value[384];
+        if (sscanf(line, " %127[^= ] = %383[^\n]", key, value) != 2) continue;
+        
+        // Trailing spaces before a comment are not part of the value
+        size_t len = strlen(value);
+        while (len > 0 && value[len - 1] == ' ') value[--len] = '\0';
+        
+        if (strcmp(key, "point") == 0 && plan->point_count < SEQUENCE_MAX_POINTS) {
+            SequencePoint* point = &plan->points[plan->point_count++];
+            // Names are only shown, so a long one is cut short
+            snprintf(point->name, sizeof(point->name), "%.*s", (int)sizeof(point->name) - 1, value);
+            point->limit = plan->limit;
+        } else if (strcmp(key, "limit") == 0) {
+            // Before the first point it is the default, after one it belongs to that point
+            if (plan->point_count > 0) plan->points[plan->point_count - 1].limit = (float)atof(value);
+            else plan->limit = (float)atof(value);
+        } else if (strcmp(key, "references") == 0) {
+            // Cut short it would name another file, and taught references would go there
+            int n = snprintf(plan->references, sizeof(plan->references), "%s", value);
+            if (n < 0 || (size_t)n >= sizeof(plan->references)) valid = false;
+        } else if (strcmp(key, "average") == 0) {
+            plan->average = atoi(value);
+        } else if (strcmp(key, "settle") == 0) {
+            plan->settle = (float)atof(value);
+        } else if (strcmp(key, "channels") == 0) {
+            plan->channels = atoi(value) == 2 ? 2 : 1;
+        }
+    }
+    fclose(f);
+    
+    if (plan->average < 1) plan->average = 1;
+    if (plan->average > SEQUENCE_MAX_AVERAGE) plan->average = SEQUENCE_MAX_AVERAGE;
+    return valid && plan->point_count > 0;
+}
+
+static void SequenceTraceStore(SequenceTrace* trace, const FrameSamples* samples) {
+    memcpy(trace->drive, samples->drive, sizeof(uint16_t) * samples->count);
+    memcpy(trace->ch1, samples->ch1, sizeof(uint16_t) * samples->count);
+    memcpy(trace->ch2, samples->ch2, sizeof(uint16_t) * samples->count);
+    trace->count = samples->count;
+    trace->bits = samples->bits;
+    trace->origin = samples->origin;
+}
+
+static void SequenceTraceCopy(SequenceTrace* dst, const SequenceTrace* src) {
+    memcpy(dst->drive, src->drive, sizeof(uint16_t) * src->count);
+    memcpy(dst->ch1, src->ch1, sizeof(uint16_t) * src->count);
+    memcpy(dst->ch2, src->ch2, sizeof(uint16_t) * src->count);
+    dst->count = src->count;
+    dst->bits = src->bits;
+    dst->origin = src->origin;
+}
+
+static void SequenceTraceSplit(const RawFrame* frame, SequenceTrace* trace) {
+    for (int i = 0; i < frame->samples; i++) {
+        trace->drive[i] = frame->values[i * 3];
+        trace->ch1[i] = frame->values[i * 3 + 1];
+        trace->ch2[i] = frame->values[i * 3 + 2];
+    }
+    trace->count = frame->samples;
+    trace->bits = frame->bits;
+    trace->origin = frame->origin;
+}
+
+static void SequenceTraceJoin(const SequenceTrace* trace, RawFrame* frame) {
+    for (int i = 0; i < trace->count; i++) {
+        frame->values[i * 3] = trace->drive[i];
+        frame->values[i * 3 + 1] = trace->ch1[i];
+        frame->values[i * 3 + 2] = trace->ch2[i];
+    }
+    frame->samples = trace->count;
+    frame->bits = trace->bits;
+    frame->origin = trace->origin;
+}
+
+// Largest reference on file, so the block sized for the live geometry holds it too
+static int SequenceReferenceSamples(const SequencePlan* plan) {
+    CaptureReader reader;
+    if (!plan->references[0] || !CaptureReaderOpen(&reader, plan->references)) return 0;
+    
+    int samples = 0;
+    RawFrame frame;
+    CaptureFrameInfo info;
+    while (CaptureReaderNext(&reader, &frame, &info)) {
+        if (frame.samples > samples) samples = frame.samples;
+    }
+    CaptureReaderClose(&reader);
+    return samples;
+}
+
+static void SequenceLoadReferences(Sequencer* seq) {
+    CaptureReader reader;
+    if (!seq->plan.references[0] || !CaptureReaderOpen(&reader, seq->plan.references)) return;
+    
+    // One record per point and excitation, the point index in the sequence field
+    RawFrame frame;
+    CaptureFrameInfo info;
+    while (CaptureReaderNext(&reader, &frame, &info)) {
+        if (info.sequence >= (uint32_t)seq->plan.point_count || frame.samples > seq->stride) continue;
+        int e = info.excitation ? 1 : 0;
+        SequenceTraceSplit(&frame, &seq->references[info.sequence * 2 + e]);
+        seq->has_reference[info.sequence * 2 + e] = true;
+    }
+    CaptureReaderClose(&reader);
+}
+
+static bool SequenceSaveReferences(const Sequencer* seq) {
+    CaptureWriter writer;
+    if (!seq->plan.references[0] || !CaptureWriterOpen(&writer, seq->plan.references, CODEC_DELTA)) return false;
+    
+    bool ok = true;
+    for (int p = 0; p < seq->plan.point_count; p++) {
+        for (int e = 0; e < 2; e++) {
+            if (!seq->has_reference[p * 2 + e]) continue;
+            
+            RawFrame frame;
+            SequenceTraceJoin(&seq->references[p * 2 + e], &frame);
+            CaptureFrameInfo info = {0, (uint32_t)p, (uint8_t)e};
+            ok = CaptureWriterAppend(&writer, &frame, &info) && ok;
+        }
+    }
+    CaptureWriterClose(&writer);
+    return ok;
+}
+
+static uint16_t* SequenceTraceAssign(SequenceTrace* trace, uint16_t* codes, int stride) {
+    trace->drive = codes;
+    trace->ch1 = codes + stride;
+    trace->ch2 = codes + stride * 2;
+    return codes + stride * 3;
+}
+
+// References, windows and signatures share one block, 32 byte aligned like FrameSamples
+static bool SequenceAllocate(Sequencer* seq, int samples) {
+    int references = seq->plan.point_count * 2;
+    int traces = references + (seq->plan.average + 1) * 2;
+    seq->stride = (samples + 15) & ~15;
+    seq->references = calloc(references, sizeof(SequenceTrace));
+    seq->has_reference = calloc(references, sizeof(bool));
+    seq->codes = malloc(sizeof(uint16_t) * 3 * seq->stride * traces + 31);
+    if (!seq->references || !seq->has_reference || !seq->codes) return false;
+    
+    uint16_t* codes = (uint16_t*)(((uintptr_t)seq->codes + 31) & ~(uintptr_t)31);
+    for (int i = 0; i < references; i++) {
+        codes = SequenceTraceAssign(&seq->references[i], codes, seq->stride);
+    }
+    for (int e = 0; e < 2; e++) {
+        for (int k = 0; k < seq->plan.average; k++) {
+            codes = SequenceTraceAssign(&seq->window[e].frames[k], codes, seq->stride);
+        }
+        codes = SequenceTraceAssign(&seq->signature[e], codes, seq->stride);
+    }
+    return true;
+}
+
+bool SequenceStart(Sequencer* seq, const SequencePlan* plan, const FrameGeometry* geometry,
+                   const char* log_path, double time) {
+    memset(seq, 0, sizeof(*seq));
+    seq->plan = *plan;
+    
+    int samples = SequenceReferenceSamples(plan);
+    if (samples < geometry->samples) samples = geometry->samples;
+    if (!SequenceAllocate(seq, samples)) {
+        SequenceStop(seq);
+        return false;
+    }
+    SequenceLoadReferences(seq);
+    
+    strncpy(seq->log_path, log_path, sizeof(seq->log_path) - 1);
+    seq->log = fopen(log_path, "w");
+    if (seq->log) {
+        fprintf(seq->log, "point,name,result,dev_4k7_dut1,dev_4k7_dut2,dev_100k_dut1,dev_100k_dut2,"
+                          "limit,operator_s,acquire_s\n");
+    }
+    
+    // The probe may already sit on the first point
+    seq->state = SEQUENCE_CONTACT;
+    seq->start_time = seq->prompt_time = seq->last_time = time;
+    return true;
+}
+
+// Anything but an open circuit on every probed lead counts as contact
+static bool SequenceContact(const FrameSamples* s, int channels) {
+    ClassifyParams params;
+    ClassifyParamsRaw(&params, s->bits, s->origin);
+    
+    float voltage[FRAME_MAX_SAMPLES], current[FRAME_MAX_SAMPLES];
+    for (int c = 0; c < channels; c++) {
+        const uint16_t* raw = c ? s->ch2 : s->ch1;
+        for (int i = 0; i < s->count; i++) {
+            voltage[i] = (float)raw[i];
+            current[i] = (float)(s->drive[i] - raw[i]);
+        }
+        ClassifyResult result;
+        ClassifyCurve(voltage, current, s->count, &params, &result);
+        if (result.label == CLASS_OPEN) return false;
+    }
+    return true;
+}
+
+// Mean |a - b| in 12-bit counts, so plan limits hold at any depth
+static float SequenceDeviation(const uint16_t* a, const uint16_t* b, int count, int bits) {
+    int max_dev;
+    int64_t sum;
+    TriggerChannelDeviation(a, b, count, &max_dev, &sum);
+    return count > 0 ? (float)sum / count / FrameCountScale(bits) : 0.0f;
+}
+
+static bool SequenceSameGeometry(const SequenceTrace* a, const SequenceTrace* b) {
+    return a->count == b->count && a->bits == b->bits && a->origin == b->origin;
+}
+
+// Average of the window, and whether every frame in it stays within settle
+static bool SequenceAverage(const Sequencer* seq, const SequenceWindow* w, SequenceTrace* avg) {
+    int32_t sums[3][FRAME_MAX_SAMPLES] = {{0}};
+    int count = w->frames[0].count;
+    
+    for (int k = 0; k < w->count; k++) {
+        const SequenceTrace* s = &w->frames[k];
+        if (s->count < count) count = s->count;
+        for (int i = 0; i < count; i++) {
+            sums[0][i] += s->drive[i];
+            sums[1][i] += s->ch1[i];
+            sums[2][i] += s->ch2[i];
+        }
+    }
+    
+    int half = w->count / 2;
+    for (int i = 0; i < count; i++) {
+        avg->drive[i] = (uint16_t)((sums[0][i] + half) / w->count);
+        avg->ch1[i] = (uint16_t)((sums[1][i] + half) / w->count);
+        avg->ch2[i] = (uint16_t)((sums[2][i] + half) / w->count);
+    }
+    avg->count = count;
+    avg->bits = w->frames[0].bits;
+    avg->origin = w->frames[0].origin;
+    
+    for (int k = 0; k < w->count; k++) {
+        for (int c = 0; c < seq->plan.channels; c++) {
+            const uint16_t* a = c ? w->frames[k].ch2 : w->frames[k].ch1;
+            const uint16_t* b = c ? avg->ch2 : avg->ch1;
+            if (SequenceDeviation(a, b, count, avg->bits) > seq->plan.settle) return false;
+        }
+    }
+    return true;
+}
+
+static void SequenceFinishPoint(Sequencer* seq, SequenceResult* result, double time) {
+    const SequencePoint* point = &seq->plan.points[seq->point];
+    
+    if (seq->log) {
+        fprintf(seq->log, "%d,\"%s\",%s", seq->point + 1, point->name, SEQUENCE_OUTCOME_NAMES[result->outcome]);
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 2; c++) {
+                if (isnan(result->deviation[e][c])) fprintf(seq->log, ",");
+                else fprintf(seq->log, ",%.2f", result->deviation[e][c]);
+            }
+        }
+        fprintf(seq->log, ",%g,%.3f,%.3f\n", point->limit, result->operator_s, result->acquire_s);
+        fflush(seq->log);
+    }
+    
+    seq->results[seq->point] = *result;
+    if (result->outcome == SEQUENCE_PASS) seq->passed++;
+    if (result->outcome == SEQUENCE_FAIL) seq->failed++;
+    
+    seq->point++;
+    seq->state = seq->point < seq->plan.point_count ? SEQUENCE_RELEASE : SEQUENCE_DONE;
+    seq->prompt_time = seq->last_time = time;
+    seq->window[0].count = seq->window[1].count = 0;
+    seq->touching = false;
+}
+
+bool SequenceProcess(Sequencer* seq, const FrameSamples* samples, int excitation, double time) {
+    if (seq->state != SEQUENCE_RELEASE && seq->state != SEQUENCE_CONTACT) return false;
+    if (samples->count > seq->stride) return false;     // Not the geometry the sequence started with
+    
+    bool contact = SequenceContact(samples, seq->plan.channels);
+    if (seq->state == SEQUENCE_RELEASE) {
+        if (!contact) seq->state = SEQUENCE_CONTACT;
+        return false;
+    }
+    
+    // Sliding off the point restarts the window
+    if (!contact) {
+        seq->window[0].count = seq->window[1].count = 0;
+        seq->touching = false;
+        return false;
+    }
+    if (!seq->touching) {
+        seq->touching = true;
+        seq->contact_time = time;
+    }
+    
+    int e = excitation ? 1 : 0;
+    SequenceWindow* w = &seq->window[e];
+    
+    // A window only averages frames of one geometry
+    if (w->count > 0) {
+        const SequenceTrace* last = &w->frames[(w->head + seq->plan.average - 1) % seq->plan.average];
+        if (last->count != samples->count || last->bits != samples->bits || last->origin != samples->origin) {
+            w->count = w->head = 0;
+        }
+    }
+    SequenceTraceStore(&w->frames[w->head], samples);
+    w->head = (w->head + 1) % seq->plan.average;
+    if (w->count < seq->plan.average) w->count++;
+    
+    if (seq->window[0].count < seq->plan.average || seq->window[1].count < seq->plan.average) return false;
+    if (!SequenceAverage(seq, &seq->window[0], &seq->signature[0]) ||
+        !SequenceAverage(seq, &seq->window[1], &seq->signature[1])) {
+        return false;
+    }
+    
+    SequenceResult result;
+    result.outcome = SEQUENCE_PASS;
+    result.worst = 0;
+    result.operator_s = seq->contact_time - seq->prompt_time;
+    result.acquire_s = time - seq->contact_time;
+    
+    int p = seq->point;
+    for (int x = 0; x < 2; x++) {
+        for (int c = 0; c < 2; c++) {
+            result.deviation[x][c] = NAN;
+            if (c >= seq->plan.channels || !seq->has_reference[p * 2 + x]) continue;
+            
+            const SequenceTrace* ref = &seq->references[p * 2 + x];
+            const SequenceTrace* sig = &seq->signature[x];
+            // A reference taken at another geometry cannot pass
+            float dev = INFINITY;
+            if (SequenceSameGeometry(sig, ref)) {
+                dev = SequenceDeviation(c ? sig->ch2 : sig->ch1, c ? ref->ch2 : ref->ch1, sig->count, sig->bits);
+            }
+            result.deviation[x][c] = dev;
+            if (dev > result.worst) result.worst = dev;
+        }
+        
+        if (!seq->has_reference[p * 2 + x]) {
+            SequenceTraceCopy(&seq->references[p * 2 + x], &seq->signature[x]);
+            seq->has_reference[p * 2 + x] = true;
+            seq->taught = true;
+            result.outcome = SEQUENCE_TAUGHT;
+        }
+    }
+    if (result.outcome == SEQUENCE_PASS && result.worst > seq->plan.points[p].limit) result.outcome = SEQUENCE_FAIL;
+    
+    SequenceFinishPoint(seq, &result, time);
+    return true;
+}
+
+void SequenceSkip(Sequencer* seq, double time) {
+    if (seq->state != SEQUENCE_RELEASE && seq->state != SEQUENCE_CONTACT) return;
+    
+    SequenceResult result = {SEQUENCE_SKIPPED, {{NAN, NAN}, {NAN, NAN}}, 0, time - seq->prompt_time, 0};
+    SequenceFinishPoint(seq, &result, time);
+}
+
+float SequencePointsPerMinute(const Sequencer* seq) {
+    double elapsed = seq->last_time - seq->start_time;
+    return seq->point > 0 && elapsed > 0 ? (float)(seq->point / elapsed * 60.0) : 0.0f;
+}
+
+void SequenceStop(Sequencer* seq) {
+    if (seq->taught) SequenceSaveReferences(seq);
+    seq->taught = false;
+    
+    if (seq->log) {
+        fprintf(seq->log, "# %s: %d of %d points, %d pass, %d fail, %.1f points/min\n", seq->plan.board,
+                seq->point, seq->plan.point_count, seq->passed, seq->failed, SequencePointsPerMinute(seq));
+        fclose(seq->log);
+        seq->log = NULL;
+    }
+    
+    free(seq->references);
+    free(seq->has_reference);
+    free(seq->codes);
+    seq->references = NULL;
+    seq->has_reference = NULL;
+    seq->codes = NULL;
+    if (seq->state != SEQUENCE_DONE) seq->state = SEQUENCE_IDLE;   // Results stay readable
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "frame.h"
+
+// Test-point sequencer for board repair. A plan lists the points of one board
+// type in probing order. For each point the operator is prompted, contact is
+// detected from the curve shape, and once the last frames of both excitations
+// agree their average is compared with the point's reference signature and the
+// sequencer moves on. Frames are averaged over a sliding window from the moment
+// of contact, so the signature is ready as soon as the probe is still and the
+// only wait left is the operator moving to the next point.
+//
+// Plan file:
+//   [BOARD-NAME]
+//   references=board.ref.cbc    ; missing file = teach the references on this run
+//   average=6                   ; frames per excitation in a signature
+//   limit=12                    ; default pass limit, mean |sample - reference|, 12-bit counts
+//   settle=6                    ; how far a window frame may stray from the average
+//   channels=1                  ; 1 = DUT1 lead only, 2 = both leads
+//   point=J1 pin 1
+//   point=U3 pin 5
+//   limit=25                    ; after a point: overrides the limit for that point
+#define SEQUENCE_MAX_POINTS 256
+#define SEQUENCE_MAX_AVERAGE 32
+
+typedef struct {
+    char name[64];
+    float limit;
+} SequencePoint;
+
+typedef struct {
+    char board[64];
+    char references[256];
+    int average;
+    float limit;
+    float settle;
+    int channels;
+    SequencePoint points[SEQUENCE_MAX_POINTS];
+    int point_count;
+} SequencePlan;
+
+typedef enum {
+    SEQUENCE_IDLE = 0,
+    SEQUENCE_RELEASE,           // Waiting for the probe to leave the previous point
+    SEQUENCE_CONTACT,           // Waiting for contact and a stable window
+    SEQUENCE_DONE
+} SequenceState;
+
+typedef enum {
+    SEQUENCE_PASS = 0,
+    SEQUENCE_FAIL,
+    SEQUENCE_TAUGHT,            // No reference yet, this signature becomes it
+    SEQUENCE_SKIPPED
+} SequenceOutcome;
+
+typedef struct {
+    SequenceOutcome outcome;
+    float deviation[2][2];      // [excitation][channel], NAN where not compared
+    float worst;
+    double operator_s;          // Prompt to contact
+    double acquire_s;           // Contact to result
+} SequenceResult;
+
+// One frame's channels as the sequencer keeps them. The codes live in a block
+// allocated when the sequence starts, stride codes per channel, 32 byte aligned.
+typedef struct {
+    uint16_t* drive;
+    uint16_t* ch1;
+    uint16_t* ch2;
+    int count;
+    int bits;
+    int origin;
+} SequenceTrace;
+
+typedef struct {
+    SequenceTrace frames[SEQUENCE_MAX_AVERAGE];
+    int head;
+    int count;
+} SequenceWindow;
+
+typedef struct {
+    SequencePlan plan;
+    SequenceState state;
+    int point;
+    
+    SequenceTrace* references;  // [point * 2 + excitation]
+    bool* has_reference;
+    bool taught;                // Some references were learned and need saving
+    
+    SequenceWindow window[2];
+    SequenceTrace signature[2];
+    bool touching;
+    
+    // Codes of every trace above. Sized for the geometry the sequence starts
+    // with, or a larger reference on file; larger live frames are ignored.
+    void* codes;
+    int stride;
+    
+    SequenceResult results[SEQUENCE_MAX_POINTS];
+    int passed;
+    int failed;
+    double start_time;
+    double prompt_time;
+    double contact_time;
+    double last_time;
+    
+    FILE* log;
+    char log_path[64];
+} Sequencer;
+
+extern const char* SEQUENCE_OUTCOME_NAMES[4];
+
+bool SequencePlanLoad(SequencePlan* plan, const char* path);
+
+// Loads the plan's references and opens the results CSV. Windows and references
+// are allocated for frames of the geometry.
+bool SequenceStart(Sequencer* seq, const SequencePlan* plan, const FrameGeometry* geometry,
+                   const char* log_path, double time);
+
+// Feed one frame. Returns true when it completed a point.
+bool SequenceProcess(Sequencer* seq, const FrameSamples* samples, int excitation, double time);
+
+// Record the current point as skipped and prompt for the next one
+void SequenceSkip(Sequencer* seq, double time);
+
+// Completed points per minute since the start
+float SequencePointsPerMinute(const Sequencer* seq);
+
+// Writes learned references and the summary line. Results stay readable.
+void SequenceStop(Sequencer* seq);
+
+#endif
\ No newline at end of file
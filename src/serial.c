@@ -14,11 +14,46 @@
     #include <termios.h>
     #include <unistd.h>
     #include <dirent.h>
+    #include <poll.h>
+    #include <limits.h>
+    #include <time.h>
+    #include <sys/ioctl.h>
     #define INVALID_SERIAL -1
 #endif
 
+#ifdef __linux__
+    #include <linux/serial.h>
+    #include <asm/ioctls.h>
+    
+    // glibc does not expose termios2, declare the asm-generic layout here.
+    // <asm/termbits.h> can't be used since it clashes with <termios.h>.
+    #if defined(TCGETS2) && !defined(__powerpc__) && !defined(__mips__) && !defined(__sparc__)
+        #define SERIAL_HAVE_TERMIOS2
+        struct termios2 {
+            tcflag_t c_iflag;
+            tcflag_t c_oflag;
+            tcflag_t c_cflag;
+            tcflag_t c_lflag;
+            cc_t c_line;
+            cc_t c_cc[19];
+            speed_t c_ispeed;
+            speed_t c_ospeed;
+        };
+        #ifndef BOTHER
+            #define BOTHER 0010000
+        #endif
+        #ifndef IBSHIFT
+            #define IBSHIFT 16
+        #endif
+    #endif
+#endif
+
 bool SerialOpen(SerialPort* port, const char* device, int baudrate) {
     port->is_open = false;
+    port->low_latency = false;
+    port->read_timeout_ms = 0;
+    port->set_async_low_latency = false;
+    port->saved_latency_timer = -1;
     strncpy(port->port_name, device, sizeof(port->port_name) - 1);
     
 #ifdef _WIN32
@@ -105,11 +140,18 @@ bool SerialOpen(SerialPort* port, const char* device, int baudrate) {
     return true;
 }
 
+#ifdef __linux__
+static void SerialRestoreLowLatency(SerialPort* port);
+#endif
+
 void SerialClose(SerialPort* port) {
     if (port->is_open) {
 #ifdef _WIN32
         CloseHandle(port->handle);
 #else
+#ifdef __linux__
+        SerialRestoreLowLatency(port);
+#endif
         close(port->handle);
 #endif
         port->is_open = false;
@@ -140,10 +182,44 @@ int SerialRead(SerialPort* port, void* buffer, size_t len) {
     }
     return -1;
 #else
+    if (port->low_latency) {
+        // Reads block until VMIN bytes arrive, so wait for the first byte here
+        struct pollfd pfd = {port->handle, POLLIN, 0};
+        if (poll(&pfd, 1, port->read_timeout_ms) <= 0) return 0;
+    }
     return read(port->handle, buffer, len);
 #endif
 }
 
+double SerialGetTimeMs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+bool SerialReadExact(SerialPort* port, void* buffer, size_t len, int timeout_ms) {
+    uint8_t* dst = buffer;
+    size_t total_read = 0;
+    double start = SerialGetTimeMs();
+    
+    while (total_read < len) {
+        if (SerialGetTimeMs() - start > timeout_ms) break;
+        
+        int n = SerialRead(port, dst + total_read, len - total_read);
+        if (n > 0) total_read += n;
+    }
+    
+    return total_read == len;
+}
+
 void SerialFlush(SerialPort* port) {
     if (!port->is_open) return;
     
@@ -154,6 +230,167 @@ void SerialFlush(SerialPort* port) {
 #endif
 }
 
+#ifdef SERIAL_HAVE_TERMIOS2
+static bool SerialSetCustomBaud(int fd, int baudrate) {
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0) return false;
+    
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = baudrate;
+    tio.c_ospeed = baudrate;
+    
+    return ioctl(fd, TCSETS2, &tio) == 0;
+}
+#endif
+
+#ifdef __linux__
+// FTDI adapters hold partial USB packets for latency_timer ms (16 by default)
+static bool SerialFtdiLatencyPath(const char* device, char* path, size_t size) {
+    char resolved[PATH_MAX];
+    if (!realpath(device, resolved)) return false;
+    
+    const char* name = strrchr(resolved, '/');
+    name = name ? name + 1 : resolved;
+    
+    int n = snprintf(path, size, "/sys/bus/usb-serial/devices/%s/latency_timer", name);
+    return n > 0 && (size_t)n < size;
+}
+
+// Returns the previous value, -1 if there is no timer or it could not be set
+static int SerialSetFtdiLatencyTimer(const char* device, int latency_ms) {
+    char path[PATH_MAX];
+    if (!SerialFtdiLatencyPath(device, path, sizeof(path))) return -1;
+    
+    int previous = -1;
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    if (fscanf(f, "%d", &previous) != 1) previous = -1;
+    fclose(f);
+    if (previous < 0) return -1;
+    
+    f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "%d", latency_ms);
+    return fclose(f) == 0 ? previous : -1;
+}
+
+static void SerialRestoreLowLatency(SerialPort* port) {
+    if (port->set_async_low_latency) {
+        struct serial_struct serial;
+        if (ioctl(port->handle, TIOCGSERIAL, &serial) == 0) {
+            serial.flags &= ~ASYNC_LOW_LATENCY;
+            ioctl(port->handle, TIOCSSERIAL, &serial);
+        }
+        port->set_async_low_latency = false;
+    }
+    if (port->saved_latency_timer >= 0) {
+        SerialSetFtdiLatencyTimer(port->port_name, port->saved_latency_timer);
+        port->saved_latency_timer = -1;
+    }
+}
+#endif
+
+bool SerialSetLowLatency(SerialPort* port, int baudrate, size_t frame_size) {
+    if (!port->is_open) return false;
+    
+#ifdef _WIN32
+    // No VMIN equivalent, so let ReadFile block for the whole frame instead
+    COMMTIMEOUTS timeouts = {0};
+    timeouts.ReadIntervalTimeout = 0;
+    timeouts.ReadTotalTimeoutConstant = 100;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
+    if (!SetCommTimeouts(port->handle, &timeouts)) return false;
+    
+    if (baudrate > 0) {
+        DCB dcb = {0};
+        dcb.DCBlength = sizeof(dcb);
+        if (GetCommState(port->handle, &dcb)) {
+            dcb.BaudRate = baudrate;
+            SetCommState(port->handle, &dcb);
+        }
+    }
+#else
+    int fd = port->handle;
+    
+#ifdef __linux__
+    struct serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0 && !(serial.flags & ASYNC_LOW_LATENCY)) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if (ioctl(fd, TIOCSSERIAL, &serial) == 0) port->set_async_low_latency = true;
+    }
+    
+    // Only the first call saves, so switching twice still restores the original
+    int previous = SerialSetFtdiLatencyTimer(port->port_name, 1);
+    if (port->saved_latency_timer < 0) port->saved_latency_timer = previous;
+#endif
+    
+    // Blocking reads, otherwise VMIN is ignored
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == -1) return false;
+    
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) return false;
+    
+    // VMIN is a cc_t, so frames larger than 255 bytes wake every 255 bytes
+    tty.c_cc[VMIN]  = frame_size > 255 ? 255 : (cc_t)frame_size;
+    tty.c_cc[VTIME] = 1;
+    
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) return false;
+    
+#ifdef SERIAL_HAVE_TERMIOS2
+    if (baudrate > 0) SerialSetCustomBaud(fd, baudrate);
+#else
+    (void)baudrate;
+#endif
+#endif
+    
+    port->low_latency = true;
+    port->read_timeout_ms = 100;
+    return true;
+}
+
+SerialRoundTrip SerialMeasureRoundTrip(SerialPort* port, char cmd, size_t response_len, int samples) {
+    SerialRoundTrip rtt = {0};
+    uint8_t* buffer = malloc(response_len);
+    if (!buffer) return rtt;
+    
+    double total = 0;
+    for (int i = 0; i < samples; i++) {
+        SerialFlush(port);
+        
+        double start = SerialGetTimeMs();
+        if (SerialWrite(port, &cmd, 1) != 1) break;
+        if (!SerialReadExact(port, buffer, response_len, 1000)) continue;
+        double elapsed = SerialGetTimeMs() - start;
+        
+        if (rtt.samples == 0 || elapsed < rtt.min_ms) rtt.min_ms = elapsed;
+        if (elapsed > rtt.max_ms) rtt.max_ms = elapsed;
+        total += elapsed;
+        rtt.samples++;
+    }
+    
+    if (rtt.samples > 0) rtt.avg_ms = total / rtt.samples;
+    
+    free(buffer);
+    return rtt;
+}
+
+int SerialBytesAvailable(SerialPort* port) {
+    if (!port->is_open) return -1;
+    
+#ifdef _WIN32
+    COMSTAT stat;
+    DWORD errors;
+    if (!ClearCommError(port->handle, &errors, &stat)) return -1;
+    return (int)stat.cbInQue;
+#else
+    int available = 0;
+    if (ioctl(port->handle, FIONREAD, &available) != 0) return -1;
+    return available;
+#endif
+}
+
 char** SerialListPorts(int* count) {
     char** ports = malloc(sizeof(char*) * 32);
     *count = 0;
@@ -301,4 +538,91 @@ char* SerialFindCurveBug(void) {
     closedir(dir);
     return NULL;
 #endif
+}
+
+bool SerialGetUsbSerial(const char* device, char* serial, size_t len) {
+    if (len == 0) return false;
+    serial[0] = '\0';
+    
+#ifdef _WIN32
+    HDEVINFO device_info = SetupDiGetClassDevs(&GUID_DEVCLASS_PORTS, NULL, NULL, 
+                                                 DIGCF_PRESENT);
+    if (device_info == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    // Accept both "COM4" and "\\.\COM4"
+    const char* wanted = strrchr(device, '\\');
+    wanted = wanted ? wanted + 1 : device;
+    
+    bool found = false;
+    SP_DEVINFO_DATA device_data;
+    device_data.cbSize = sizeof(SP_DEVINFO_DATA);
+    
+    for (DWORD i = 0; !found && SetupDiEnumDeviceInfo(device_info, i, &device_data); i++) {
+        HKEY key = SetupDiOpenDevRegKey(device_info, &device_data, 
+            DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+        if (key == INVALID_HANDLE_VALUE) continue;
+        
+        char port_name[256];
+        DWORD size = sizeof(port_name);
+        bool match = RegQueryValueExA(key, "PortName", NULL, NULL, 
+            (LPBYTE)port_name, &size) == ERROR_SUCCESS && _stricmp(port_name, wanted) == 0;
+        RegCloseKey(key);
+        if (!match) continue;
+        
+        // Instance ID is USB\VID_xxxx&PID_xxxx\<serial>. Devices without a
+        // serial number get a generated ID containing '&' instead.
+        char instance_id[256];
+        if (SetupDiGetDeviceInstanceIdA(device_info, &device_data, instance_id, 
+            sizeof(instance_id), NULL)) {
+            const char* last = strrchr(instance_id, '\\');
+            if (last && !strchr(last + 1, '&')) {
+                strncpy(serial, last + 1, len - 1);
+                serial[len - 1] = '\0';
+                found = true;
+            }
+        }
+    }
+    
+    SetupDiDestroyDeviceInfoList(device_info);
+    return found;
+    
+#elif defined(__linux__)
+    char resolved[PATH_MAX];
+    if (!realpath(device, resolved)) return false;
+    
+    const char* name = strrchr(resolved, '/');
+    name = name ? name + 1 : resolved;
+    
+    char link[PATH_MAX], dir[PATH_MAX];
+    int n = snprintf(link, sizeof(link), "/sys/class/tty/%s/device", name);
+    if (n < 0 || (size_t)n >= sizeof(link) || !realpath(link, dir)) return false;
+    
+    // ACM ttys link to the USB interface and FTDI ones to a port below it, so
+    // walk up until the USB device that holds the serial number
+    while (strcmp(dir, "/sys/devices") != 0) {
+        char path[PATH_MAX];
+        n = snprintf(path, sizeof(path), "%s/serial", dir);
+        if (n > 0 && (size_t)n < sizeof(path)) {
+            FILE* f = fopen(path, "r");
+            if (f) {
+                bool found = fgets(serial, (int)len, f) != NULL;
+                fclose(f);
+                
+                if (found) serial[strcspn(serial, "\r\n")] = '\0';
+                return found && serial[0] != '\0';
+            }
+        }
+        
+        char* slash = strrchr(dir, '/');
+        if (!slash || slash == dir) break;
+        *slash = '\0';
+    }
+    return false;
+    
+#else
+    (void)device;
+    return false;
+#endif
 }
\ No newline at end of file
@@ -16,15 +16,40 @@ typedef struct {
     serial_t handle;
     bool is_open;
     char port_name[256];
+    
+    bool low_latency;
+    int read_timeout_ms;    // Per-read wait in low latency mode (blocking reads)
+    
+    // Driver settings low latency mode changed, put back by SerialClose since
+    // they outlive the process
+    bool set_async_low_latency;     // ASYNC_LOW_LATENCY was off until we set it
+    int saved_latency_timer;        // FTDI latency_timer before, -1 = untouched
 } SerialPort;
 
+// Round trip timings for one command, in milliseconds
+typedef struct {
+    double min_ms;
+    double avg_ms;
+    double max_ms;
+    int samples;            // Successful round trips
+} SerialRoundTrip;
+
 bool SerialOpen(SerialPort* port, const char* device, int baudrate);
 void SerialClose(SerialPort* port);
 int SerialWrite(SerialPort* port, const void* data, size_t len);
 int SerialRead(SerialPort* port, void* buffer, size_t len);
 void SerialFlush(SerialPort* port);
+int SerialBytesAvailable(SerialPort* port);
 char** SerialListPorts(int* count);
 void SerialFreePortList(char** ports, int count);
 char* SerialFindCurveBug(void);
+bool SerialGetUsbSerial(const char* device, char* serial, size_t len);
+
+// Low latency mode: ASYNC_LOW_LATENCY, FTDI latency_timer, custom baud and
+// VMIN sized to the frame so a read wakes once per frame instead of per byte.
+bool SerialSetLowLatency(SerialPort* port, int baudrate, size_t frame_size);
+bool SerialReadExact(SerialPort* port, void* buffer, size_t len, int timeout_ms);
+SerialRoundTrip SerialMeasureRoundTrip(SerialPort* port, char cmd, size_t response_len, int samples);
+double SerialGetTimeMs(void);
 
 #endif
\ No newline at end of file
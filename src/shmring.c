@@ -0,0 +1,201 @@
+#include "shmring.h"
+#include "sync.h"
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static size_t ShmRingSize(void) {
+    return sizeof(ShmRingHeader) + sizeof(ShmSlot) * SHM_RING_SLOTS;
+}
+
+static void* ShmRingMap(ShmRing* ring, const char* name, bool create) {
+    strncpy(ring->name, name, sizeof(ring->name) - 1);
+    
+#ifdef _WIN32
+    if (create) {
+        ring->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                           0, (DWORD)ring->size, name);
+    } else {
+        ring->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    }
+    if (!ring->mapping) return NULL;
+    
+    void* base = MapViewOfFile(ring->mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(ring->mapping);
+        ring->mapping = NULL;
+    }
+    return base;
+#else
+    ring->fd = shm_open(name, create ? (O_CREAT | O_RDWR) : O_RDONLY, 0644);
+    if (ring->fd == -1) return NULL;
+    
+    if (create) {
+        if (ftruncate(ring->fd, (off_t)ring->size) != 0) {
+            close(ring->fd);
+            shm_unlink(name);
+            return NULL;
+        }
+    } else {
+        struct stat st;
+        if (fstat(ring->fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmRingHeader)) {
+            close(ring->fd);
+            return NULL;
+        }
+        ring->size = (size_t)st.st_size;
+    }
+    
+    void* base = mmap(NULL, ring->size, create ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                      MAP_SHARED, ring->fd, 0);
+    if (base == MAP_FAILED) {
+        close(ring->fd);
+        if (create) shm_unlink(name);
+        return NULL;
+    }
+    return base;
+#endif
+}
+
+bool ShmRingCreate(ShmRing* ring, const char* name) {
+    memset(ring, 0, sizeof(*ring));
+    ring->size = ShmRingSize();
+    ring->owner = true;
+    
+    uint8_t* base = ShmRingMap(ring, name, true);
+    if (!base) return false;
+    
+    ring->header = (ShmRingHeader*)base;
+    ring->slots = (ShmSlot*)(base + sizeof(ShmRingHeader));
+    memset(base, 0, ring->size);
+    
+    ring->header->version = SHM_RING_VERSION;
+    ring->header->slot_count = SHM_RING_SLOTS;
+    ring->header->slot_size = sizeof(ShmSlot);
+    
+    // Readers check the magic last, so it is published after the layout
+    AtomicFenceRelease();
+    AtomicStore32(&ring->header->magic, SHM_RING_MAGIC);
+    return true;
+}
+
+void ShmRingPublish(ShmRing* ring, const FrameSamples* samples, uint32_t excitation, uint64_t timestamp_us) {
+    if (!ring->header) return;
+    
+    uint64_t index = ring->header->head;
+    ShmSlot* slot = &ring->slots[index % SHM_RING_SLOTS];
+    uint32_t lock = slot->lock;
+    
+    AtomicStore32(&slot->lock, lock + 1);
+    AtomicFenceRelease();
+    
+    slot->frame.sequence = index + 1;
+    slot->frame.timestamp_us = timestamp_us;
+    slot->frame.excitation = excitation;
+    slot->frame.samples = *samples;
+    
+    AtomicStore32(&slot->lock, lock + 2);
+    AtomicStore64(&ring->header->head, index + 1);
+}
+
+bool ShmRingAttach(ShmRing* ring, const char* name) {
+    memset(ring, 0, sizeof(*ring));
+    ring->size = ShmRingSize();
+    
+    uint8_t* base = ShmRingMap(ring, name, false);
+    if (!base) return false;
+    
+    ring->header = (ShmRingHeader*)base;
+    ring->slots = (ShmSlot*)(base + sizeof(ShmRingHeader));
+    
+    if (AtomicLoad32(&ring->header->magic) != SHM_RING_MAGIC ||
+        ring->header->version != SHM_RING_VERSION ||
+        ring->header->slot_count != SHM_RING_SLOTS ||
+        ring->header->slot_size != sizeof(ShmSlot)) {
+        ShmRingClose(ring);
+        return false;
+    }
+    
+    // Start with the next frame published after attaching
+    ring->next = AtomicLoad64(&ring->header->head);
+    return true;
+}
+
+// Moves the cursor past frames the writer has already lapped
+static bool ShmRingAdvance(ShmRing* ring, uint64_t* index) {
+    uint64_t head = AtomicLoad64(&ring->header->head);
+    if (ring->next >= head) return false;
+    
+    // Slot head % SLOTS may be in the middle of being rewritten
+    if (head - ring->next >= SHM_RING_SLOTS) {
+        uint64_t oldest = head - SHM_RING_SLOTS + 1;
+        ring->dropped += oldest - ring->next;
+        ring->next = oldest;
+    }
+    
+    *index = ring->next;
+    return true;
+}
+
+const ShmFrame* ShmRingPeek(ShmRing* ring, uint32_t* token) {
+    uint64_t index;
+    
+    while (ShmRingAdvance(ring, &index)) {
+        const ShmSlot* slot = &ring->slots[index % SHM_RING_SLOTS];
+        uint32_t lock = AtomicLoad32(&slot->lock);
+        
+        if ((lock & 1) == 0 && slot->frame.sequence == index + 1) {
+            *token = lock;
+            return &slot->frame;
+        }
+        
+        // Lapped while looking at it, try the oldest frame still intact
+        ring->dropped++;
+        ring->next++;
+    }
+    
+    return NULL;
+}
+
+bool ShmRingRelease(ShmRing* ring, const ShmFrame* frame, uint32_t token) {
+    const ShmSlot* slot = (const ShmSlot*)((const uint8_t*)frame - offsetof(ShmSlot, frame));
+    
+    AtomicFenceAcquire();
+    bool intact = AtomicLoad32(&slot->lock) == token;
+    
+    ring->next++;
+    if (!intact) ring->dropped++;
+    return intact;
+}
+
+bool ShmRingRead(ShmRing* ring, ShmFrame* frame) {
+    uint32_t token;
+    const ShmFrame* shared;
+    
+    while ((shared = ShmRingPeek(ring, &token)) != NULL) {
+        memcpy(frame, shared, sizeof(*frame));
+        if (ShmRingRelease(ring, shared, token)) return true;
+    }
+    
+    return false;
+}
+
+void ShmRingClose(ShmRing* ring) {
+    if (!ring->header) return;
+    
+#ifdef _WIN32
+    UnmapViewOfFile(ring->header);
+    CloseHandle(ring->mapping);
+#else
+    munmap(ring->header, ring->size);
+    close(ring->fd);
+    if (ring->owner) shm_unlink(ring->name);
+#endif
+    
+    ring->header = NULL;
+    ring->slots = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "frame.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+    #define SHM_RING_DEFAULT_NAME "Local\\curvebug_frames"
+#else
+    #define SHM_RING_DEFAULT_NAME "/curvebug_frames"
+#endif
+
+#define SHM_RING_MAGIC 0x47554243u      // "CBUG"
+#define SHM_RING_VERSION 2          // FrameSamples sized for FRAME_MAX_SAMPLES, with bits and origin
+#define SHM_RING_SLOTS 256
+
+// Single writer, any number of readers. Each slot carries a sequence lock:
+// odd while the writer is inside it. Readers never write to the mapping.
+typedef struct {
+    uint64_t sequence;          // 1-based frame number
+    uint64_t timestamp_us;      // Monotonic clock of the producer
+    uint32_t excitation;        // 0=4.7K, 1=100K
+    uint32_t reserved;
+    FrameSamples samples;
+} ShmFrame;
+
+typedef struct {
+    volatile uint32_t lock;
+    uint32_t reserved[15];      // Keeps the lock on its own cache line
+    ShmFrame frame;
+} ShmSlot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    volatile uint64_t head;     // Frames published so far
+    uint8_t reserved[40];
+} ShmRingHeader;
+
+typedef struct {
+    ShmRingHeader* header;
+    ShmSlot* slots;
+    size_t size;
+    bool owner;
+    char name[64];
+#ifdef _WIN32
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    
+    // Reader state
+    uint64_t next;              // Next frame index to read
+    uint64_t dropped;           // Frames overwritten before this reader got to them
+} ShmRing;
+
+bool ShmRingCreate(ShmRing* ring, const char* name);
+void ShmRingPublish(ShmRing* ring, const FrameSamples* samples, uint32_t excitation, uint64_t timestamp_us);
+
+bool ShmRingAttach(ShmRing* ring, const char* name);
+bool ShmRingRead(ShmRing* ring, ShmFrame* frame);
+
+// Zero-copy access: use the frame in place, then check it was not overwritten
+const ShmFrame* ShmRingPeek(ShmRing* ring, uint32_t* token);
+bool ShmRingRelease(ShmRing* ring, const ShmFrame* frame, uint32_t token);
+
+void ShmRingClose(ShmRing* ring);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "spatial.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool SpatialGridInit(SpatialGrid* grid, int capacity, int max_cells) {
+    memset(grid, 0, sizeof(*grid));
+    grid->points = malloc(sizeof(SpatialPoint) * capacity);
+    grid->cell_start = malloc(sizeof(int) * (max_cells + 1));
+    if (!grid->points || !grid->cell_start) {
+        SpatialGridFree(grid);
+        return false;
+    }
+    grid->capacity = capacity;
+    grid->cell_capacity = max_cells + 1;
+    return true;
+}
+
+void SpatialGridFree(SpatialGrid* grid) {
+    free(grid->points);
+    free(grid->cell_start);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static int SpatialCell(const SpatialGrid* grid, float x, float y) {
+    int cx = (int)((x - grid->origin_x) / grid->cell);
+    int cy = (int)((y - grid->origin_y) / grid->cell);
+    if (cx < 0) cx = 0;
+    if (cy < 0) cy = 0;
+    if (cx >= grid->cols) cx = grid->cols - 1;
+    if (cy >= grid->rows) cy = grid->rows - 1;
+    return cy * grid->cols + cx;
+}
+
+bool SpatialGridBuild(SpatialGrid* grid, float x, float y, float width, float height, float cell,
+                      const SpatialPoint* const* lists, const int* counts, int list_count) {
+    if (!grid->cell_start) return false;
+    
+    // Coarser cells only cost a few more points per lookup
+    while (((int)(width / cell) + 1) * ((int)(height / cell) + 1) + 1 > grid->cell_capacity) {
+        cell *= 1.25f;
+    }
+    
+    grid->origin_x = x;
+    grid->origin_y = y;
+    grid->cell = cell;
+    grid->cols = (int)(width / cell) + 1;
+    grid->rows = (int)(height / cell) + 1;
+    grid->count = 0;
+    
+    int cells = grid->cols * grid->rows;
+    
+    // Count per cell, prefix sum, then scatter; cell_start ends up as the
+    // first index of each cell
+    memset(grid->cell_start, 0, sizeof(int) * (cells + 1));
+    int total = 0;
+    for (int l = 0; l < list_count; l++) {
+        for (int i = 0; i < counts[l] && total < grid->capacity; i++, total++) {
+            grid->cell_start[SpatialCell(grid, lists[l][i].x, lists[l][i].y) + 1]++;
+        }
+    }
+    for (int c = 0; c < cells; c++) grid->cell_start[c + 1] += grid->cell_start[c];
+    
+    int placed = 0;
+    for (int l = 0; l < list_count; l++) {
+        for (int i = 0; i < counts[l] && placed < total; i++, placed++) {
+            int c = SpatialCell(grid, lists[l][i].x, lists[l][i].y);
+            grid->points[grid->cell_start[c]++] = lists[l][i];
+        }
+    }
+    for (int c = cells; c > 0; c--) grid->cell_start[c] = grid->cell_start[c - 1];
+    grid->cell_start[0] = 0;
+    
+    grid->count = total;
+    return true;
+}
+
+bool SpatialGridNearest(const SpatialGrid* grid, float x, float y, float max_dist, SpatialPoint* out) {
+    if (grid->count == 0) return false;
+    
+    int home = SpatialCell(grid, x, y);
+    int hx = home % grid->cols;
+    int hy = home / grid->cols;
+    float best = max_dist * max_dist;
+    bool found = false;
+    
+    // Rings of cells outward; anything beyond ring r is at least r cells away
+    int max_ring = (int)(max_dist / grid->cell) + 1;
+    for (int r = 0; r <= max_ring; r++) {
+        float reach = (r - 1) * grid->cell;
+        if (r > 0 && reach > 0 && reach * reach > best) break;
+        
+        for (int cy = hy - r; cy <= hy + r; cy++) {
+            if (cy < 0 || cy >= grid->rows) continue;
+            bool edge_row = cy == hy - r || cy == hy + r;
+            
+            for (int cx = hx - r; cx <= hx + r; cx += (edge_row || r == 0) ? 1 : 2 * r) {
+                if (cx < 0 || cx >= grid->cols) continue;
+                
+                int c = cy * grid->cols + cx;
+                for (int i = grid->cell_start[c]; i < grid->cell_start[c + 1]; i++) {
+                    float dx = grid->points[i].x - x;
+                    float dy = grid->points[i].y - y;
+                    float d = dx * dx + dy * dy;
+                    if (d <= best) {
+                        best = d;
+                        *out = grid->points[i];
+                        found = true;
+                    }
+                }
+            }
+        }
+    }
+    return found;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Uniform grid over screen space for nearest point queries. Points are bucketed
+// by a counting sort, so a rebuild is linear and a lookup only visits the few
+// cells around the query.
+typedef struct {
+    float x, y;
+    uint32_t id;                // Caller's payload
+} SpatialPoint;
+
+typedef struct {
+    float origin_x, origin_y;
+    float cell;
+    int cols, rows;
+    
+    int* cell_start;            // cols * rows + 1 offsets into points
+    int cell_capacity;          // Fixed at init; larger areas get larger cells
+    SpatialPoint* points;       // Sorted by cell
+    int count;
+    int capacity;
+} SpatialGrid;
+
+// Both tables are allocated here and never grow, so rebuilding on every frame
+// stays off the heap
+bool SpatialGridInit(SpatialGrid* grid, int capacity, int max_cells);
+void SpatialGridFree(SpatialGrid* grid);
+
+// Buckets the concatenation of several point lists. Points outside the
+// bounds are clamped into the edge cells. If the area at this cell size needs
+// more than max_cells, the cells are enlarged until it does not.
+bool SpatialGridBuild(SpatialGrid* grid, float x, float y, float width, float height, float cell,
+                      const SpatialPoint* const* lists, const int* counts, int list_count);
+
+// Nearest point within max_dist of (x, y)
+bool SpatialGridNearest(const SpatialGrid* grid, float x, float y, float max_dist, SpatialPoint* out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "spline.h"
+
+// Tangents at each point for one coordinate. Zero at local extrema, otherwise
+// the harmonic mean of the neighbouring slopes, which keeps each piece monotone.
+static void SplineTangents(const float* v, int count, float* m) {
+    m[0] = v[1] - v[0];
+    m[count - 1] = v[count - 1] - v[count - 2];
+    
+    for (int i = 1; i < count - 1; i++) {
+        float d0 = v[i] - v[i - 1];
+        float d1 = v[i + 1] - v[i];
+        m[i] = (d0 * d1 > 0) ? 2.0f * d0 * d1 / (d0 + d1) : 0.0f;
+    }
+}
+
+static void SplineCoefficients(float* c, float v0, float v1, float m0, float m1) {
+    float d = v1 - v0;
+    c[0] = v0;
+    c[1] = m0;
+    c[2] = 3.0f * d - 2.0f * m0 - m1;
+    c[3] = m0 + m1 - 2.0f * d;
+}
+
+void SplineBuild(Spline* spline, const float* x, const float* y, int count) {
+    if (count > spline->capacity + 1) count = spline->capacity + 1;
+    if (count > SPLINE_MAX_POINTS) count = SPLINE_MAX_POINTS;
+    spline->count = count > 1 ? count - 1 : 0;
+    if (count < 2) return;
+    
+    float mx[SPLINE_MAX_POINTS];
+    float my[SPLINE_MAX_POINTS];
+    SplineTangents(x, count, mx);
+    SplineTangents(y, count, my);
+    
+    for (int i = 0; i < count - 1; i++) {
+        SplineSegment* s = &spline->segments[i];
+        SplineCoefficients(s->x, x[i], x[i + 1], mx[i], mx[i + 1]);
+        SplineCoefficients(s->y, y[i], y[i + 1], my[i], my[i + 1]);
+    }
+}
\ No newline at end of file
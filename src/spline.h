@@ -0,0 +1,28 @@
+#ifndef SPLINE_H
+#define SPLINE_H
+
+#include <stdbool.h>
+#include "frame.h"
+
+#define SPLINE_MAX_POINTS FRAME_MAX_SAMPLES
+
+// One cubic piece between samples i and i+1, t in [0, 1]:
+// x(t) = x[0] + x[1] t + x[2] t^2 + x[3] t^3, likewise y
+typedef struct {
+    float x[4];
+    float y[4];
+} SplineSegment;
+
+// Monotone cubic (Fritsch-Carlson) through a sampled curve, parametrised by
+// sample index. Never overshoots between samples, so noise and the diode knee
+// are not turned into ringing.
+typedef struct {
+    SplineSegment* segments;    // Storage of the owner, room for capacity segments
+    int capacity;
+    int count;      // Segments, one less than the points it was built from
+} Spline;
+
+// Points past capacity + 1 are left out
+void SplineBuild(Spline* spline, const float* x, const float* y, int count);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "summary.h"
+#include "capture.h"
+#include "metrics.h"
+#include "trigger.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SUMMARY_VERSION 1
+#define SUMMARY_HEADER_BYTES 16
+#define SUMMARY_RECORD_BYTES (24 + 12 * SUMMARY_SERIES)
+
+const char* SUMMARY_KEY_NAMES[SUMMARY_KEYS] = {
+    "Deviation", "R small", "I leak", "Loop area", "Noise"
+};
+
+static void SummaryPut32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static void SummaryPut64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (i * 8));
+}
+
+static void SummaryPutFloat(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    SummaryPut32(p, bits);
+}
+
+static uint32_t SummaryGet32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float SummaryGetFloat(const uint8_t* p) {
+    uint32_t bits = SummaryGet32(p);
+    float v;
+    memcpy(&v, &bits, 4);
+    return v;
+}
+
+static void SummaryAccumReset(SummaryAccum* acc, uint32_t first_frame, uint64_t offset) {
+    memset(acc, 0, sizeof(*acc));
+    acc->bucket.first_frame = first_frame;
+    acc->bucket.offset = offset;
+    for (int s = 0; s < SUMMARY_SERIES; s++) {
+        acc->bucket.min[s] = INFINITY;
+        acc->bucket.max[s] = -INFINITY;
+    }
+}
+
+static void SummaryAccumMerge(SummaryAccum* acc, int s, float min, float max, double sum, uint32_t valid) {
+    if (valid == 0) return;
+    if (min < acc->bucket.min[s]) acc->bucket.min[s] = min;
+    if (max > acc->bucket.max[s]) acc->bucket.max[s] = max;
+    acc->sum[s] += sum;
+    acc->valid[s] += valid;
+}
+
+static bool SummaryEmit(SummaryWriter* writer, int level) {
+    SummaryAccum* acc = &writer->levels[level];
+    SummaryBucket* b = &acc->bucket;
+    
+    for (int s = 0; s < SUMMARY_SERIES; s++) {
+        b->mean[s] = acc->valid[s] ? (float)(acc->sum[s] / acc->valid[s]) : NAN;
+    }
+    
+    uint8_t record[SUMMARY_RECORD_BYTES] = {0};
+    record[0] = (uint8_t)level;
+    SummaryPut32(record + 4, b->first_frame);
+    SummaryPut32(record + 8, b->count);
+    SummaryPut64(record + 16, b->offset);
+    for (int s = 0; s < SUMMARY_SERIES; s++) {
+        SummaryPutFloat(record + 24 + s * 4, b->min[s]);
+        SummaryPutFloat(record + 24 + (SUMMARY_SERIES + s) * 4, b->max[s]);
+        SummaryPutFloat(record + 24 + (2 * SUMMARY_SERIES + s) * 4, b->mean[s]);
+    }
+    
+    bool ok = fwrite(record, 1, sizeof(record), writer->file) == sizeof(record);
+    
+    // Fold the finished bucket into its parent; start the parent if this is its first child
+    if (level + 1 < SUMMARY_MAX_LEVELS) {
+        SummaryAccum* parent = &writer->levels[level + 1];
+        if (parent->children == 0) SummaryAccumReset(parent, b->first_frame, b->offset);
+        for (int s = 0; s < SUMMARY_SERIES; s++) {
+            SummaryAccumMerge(parent, s, b->min[s], b->max[s], acc->sum[s], acc->valid[s]);
+        }
+        parent->bucket.count += b->count;
+        parent->children++;
+    }
+    
+    acc->children = 0;
+    acc->bucket.count = 0;
+    return ok;
+}
+
+bool SummaryWriterOpen(SummaryWriter* writer, const char* path) {
+    memset(writer, 0, sizeof(*writer));
+    
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+    
+    uint8_t header[SUMMARY_HEADER_BYTES];
+    memcpy(header, SUMMARY_MAGIC, 8);
+    header[8] = SUMMARY_BASE;
+    header[9] = 0;
+    header[10] = SUMMARY_FANOUT;
+    header[11] = 0;
+    header[12] = SUMMARY_SERIES;
+    header[13] = 0;
+    header[14] = SUMMARY_VERSION;
+    header[15] = 0;
+    
+    if (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) {
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void SummaryRawView(const uint16_t* drive, const uint16_t* raw, int count, float* voltage, float* current) {
+    for (int i = 0; i < count; i++) {
+        voltage[i] = (float)raw[i];
+        current[i] = (float)(drive[i] - raw[i]);
+    }
+}
+
+bool SummaryWriterAdd(SummaryWriter* writer, uint64_t offset, const FrameSamples* samples, int excitation) {
+    if (!writer->file) return false;
+    
+    int e = excitation ? 1 : 0;
+    if (!writer->has_first[e]) {
+        writer->first[e] = *samples;
+        writer->has_first[e] = true;
+    }
+    
+    MetricsParams params;
+    MetricsParamsRaw(&params, samples->bits, samples->origin, e == 1);
+    
+    // No deviation from a first frame of another geometry
+    const FrameSamples* f = &writer->first[e];
+    bool comparable = f->count == samples->count && f->bits == samples->bits && f->origin == samples->origin;
+    
+    float values[SUMMARY_SERIES];
+    float voltage[FRAME_MAX_SAMPLES], current[FRAME_MAX_SAMPLES];
+    const uint16_t* channels[2] = {samples->ch1, samples->ch2};
+    const uint16_t* first[2] = {f->ch1, f->ch2};
+    
+    for (int c = 0; c < 2; c++) {
+        MetricsResult m;
+        SummaryRawView(samples->drive, channels[c], samples->count, voltage, current);
+        MetricsCompute(voltage, current, samples->drive, channels[c], samples->count, &params, &m);
+        
+        int max_dev;
+        int64_t sum;
+        TriggerChannelDeviation(channels[c], first[c], comparable ? samples->count : 0, &max_dev, &sum);
+        
+        values[SUMMARY_DEVIATION * 2 + c] = !comparable ? NAN : samples->count > 0 ? (float)sum / samples->count : 0;
+        values[SUMMARY_R_SMALL * 2 + c] = m.r_small;
+        values[SUMMARY_I_LEAK * 2 + c] = m.i_leak;
+        values[SUMMARY_LOOP_AREA * 2 + c] = m.loop_area;
+        values[SUMMARY_NOISE * 2 + c] = m.noise;
+    }
+    
+    SummaryAccum* acc = &writer->levels[0];
+    if (acc->bucket.count == 0) SummaryAccumReset(acc, writer->frames, offset);
+    for (int s = 0; s < SUMMARY_SERIES; s++) {
+        if (!isnan(values[s])) SummaryAccumMerge(acc, s, values[s], values[s], values[s], 1);
+    }
+    acc->bucket.count++;
+    writer->frames++;
+    
+    // Completing a bucket can complete its parent, and so on up
+    bool ok = true;
+    for (int level = 0; level < SUMMARY_MAX_LEVELS; level++) {
+        SummaryAccum* a = &writer->levels[level];
+        bool full = level == 0 ? a->bucket.count == SUMMARY_BASE : a->children == SUMMARY_FANOUT;
+        if (!full) break;
+        ok = SummaryEmit(writer, level) && ok;
+    }
+    return ok;
+}
+
+void SummaryWriterClose(SummaryWriter* writer) {
+    if (!writer->file) return;
+    
+    // Flush the partial buckets bottom up so each parent includes its last child
+    for (int level = 0; level < SUMMARY_MAX_LEVELS; level++) {
+        SummaryAccum* a = &writer->levels[level];
+        bool open = level == 0 ? a->bucket.count > 0 : a->children > 0;
+        if (open) SummaryEmit(writer, level);
+    }
+    
+    fclose(writer->file);
+    writer->file = NULL;
+}
+
+bool SummaryLoad(Summary* summary, const char* path) {
+    memset(summary, 0, sizeof(*summary));
+    
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    
+    uint8_t header[SUMMARY_HEADER_BYTES];
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, SUMMARY_MAGIC, 8) != 0 ||
+        header[8] != SUMMARY_BASE || header[10] != SUMMARY_FANOUT || header[12] != SUMMARY_SERIES) {
+        fclose(f);
+        return false;
+    }
+    
+    // Count first so every level is a single allocation
+    uint8_t record[SUMMARY_RECORD_BYTES];
+    long start = ftell(f);
+    while (fread(record, 1, sizeof(record), f) == sizeof(record)) {
+        if (record[0] < SUMMARY_MAX_LEVELS) summary->counts[record[0]]++;
+    }
+    
+    for (int level = 0; level < SUMMARY_MAX_LEVELS; level++) {
+        if (summary->counts[level] == 0) break;
+        summary->levels[level] = malloc(sizeof(SummaryBucket) * summary->counts[level]);
+        if (!summary->levels[level]) {
+            fclose(f);
+            SummaryFree(summary);
+            return false;
+        }
+        summary->level_count = level + 1;
+        summary->counts[level] = 0;
+    }
+    
+    fseek(f, start, SEEK_SET);
+    while (fread(record, 1, sizeof(record), f) == sizeof(record)) {
+        int level = record[0];
+        if (level >= summary->level_count) continue;
+        
+        SummaryBucket* b = &summary->levels[level][summary->counts[level]++];
+        b->first_frame = SummaryGet32(record + 4);
+        b->count = SummaryGet32(record + 8);
+        b->offset = (uint64_t)SummaryGet32(record + 16) | ((uint64_t)SummaryGet32(record + 20) << 32);
+        for (int s = 0; s < SUMMARY_SERIES; s++) {
+            b->min[s] = SummaryGetFloat(record + 24 + s * 4);
+            b->max[s] = SummaryGetFloat(record + 24 + (SUMMARY_SERIES + s) * 4);
+            b->mean[s] = SummaryGetFloat(record + 24 + (2 * SUMMARY_SERIES + s) * 4);
+        }
+        if (level == 0) summary->frames += b->count;
+    }
+    
+    fclose(f);
+    
+    if (summary->level_count == 0) return false;
+    return true;
+}
+
+void SummaryFree(Summary* summary) {
+    for (int level = 0; level < SUMMARY_MAX_LEVELS; level++) {
+        free(summary->levels[level]);
+    }
+    memset(summary, 0, sizeof(*summary));
+}
+
+bool SummaryBuild(const char* capture_path, const char* summary_path) {
+    CaptureReader reader;
+    if (!CaptureReaderOpen(&reader, capture_path)) return false;
+    
+    SummaryWriter writer;
+    if (!SummaryWriterOpen(&writer, summary_path)) {
+        CaptureReaderClose(&reader);
+        return false;
+    }
+    
+    RawFrame frame;
+    FrameSamples samples;
+    CaptureFrameInfo info;
+    bool ok = true;
+    
+    uint64_t offset = reader.offset;
+    while (ok && CaptureReaderNext(&reader, &frame, &info)) {
+        FrameSplit(&frame, &samples);
+        ok = SummaryWriterAdd(&writer, offset, &samples, info.excitation);
+        offset = reader.offset;
+    }
+    
+    SummaryWriterClose(&writer);
+    CaptureReaderClose(&reader);
+    return ok;
+}
+
+static uint32_t SummarySpan(int level) {
+    uint32_t span = SUMMARY_BASE;
+    for (int i = 0; i < level; i++) span *= SUMMARY_FANOUT;
+    return span;
+}
+
+bool SummaryLocate(const Summary* summary, uint32_t frame, uint64_t* offset, uint32_t* skip) {
+    if (summary->level_count == 0 || frame >= summary->frames) return false;
+    
+    const SummaryBucket* b = &summary->levels[0][frame / SUMMARY_BASE];
+    *offset = b->offset;
+    *skip = frame - b->first_frame;
+    return true;
+}
+
+bool SummaryQuery(const Summary* summary, uint32_t first, uint32_t last, int series,
+                  float* min, float* max, float* mean) {
+    if (summary->level_count == 0 || first >= summary->frames) return false;
+    if (last > summary->frames) last = summary->frames;
+    if (last <= first) last = first + 1;
+    
+    int level = 0;
+    while (level + 1 < summary->level_count && SummarySpan(level + 1) <= last - first) level++;
+    
+    // Buckets are aligned to their span, so the ones touching the range are contiguous
+    uint32_t span = SummarySpan(level);
+    uint32_t b0 = first / span;
+    uint32_t b1 = (last - 1) / span;
+    if (b1 >= summary->counts[level]) b1 = summary->counts[level] - 1;
+    
+    float lo = INFINITY, hi = -INFINITY;
+    double sum = 0, weight = 0;
+    for (uint32_t i = b0; i <= b1; i++) {
+        const SummaryBucket* b = &summary->levels[level][i];
+        if (isnan(b->mean[series])) continue;
+        if (b->min[series] < lo) lo = b->min[series];
+        if (b->max[series] > hi) hi = b->max[series];
+        sum += (double)b->mean[series] * b->count;
+        weight += b->count;
+    }
+    
+    if (weight == 0) return false;
+    *min = lo;
+    *max = hi;
+    *mean = (float)(sum / weight);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+// Multiresolution overview of a capture, stored next to it as <capture>.sum.
+// Level 0 buckets cover SUMMARY_BASE frames, each higher level SUMMARY_FANOUT
+// buckets of the level below. Buckets hold min/max/mean of a few key metrics
+// per DUT (raw ADC units, so the summary does not depend on calibration) and
+// the file offset of their first frame, which doubles as a seek index.
+//
+// The file is a header followed by bucket records in the order they complete,
+// so it can be appended while recording and a crash loses at most the open buckets.
+#define SUMMARY_MAGIC "CBUGSUM1"
+#define SUMMARY_BASE 16
+#define SUMMARY_FANOUT 8
+#define SUMMARY_MAX_LEVELS 8
+
+typedef enum {
+    SUMMARY_DEVIATION,          // Mean |sample - first frame of same excitation|
+    SUMMARY_R_SMALL,
+    SUMMARY_I_LEAK,
+    SUMMARY_LOOP_AREA,
+    SUMMARY_NOISE,
+    SUMMARY_KEYS
+} SummaryKey;
+
+// Series index is key * 2 + DUT
+#define SUMMARY_SERIES (SUMMARY_KEYS * 2)
+
+typedef struct {
+    uint64_t offset;            // Capture file offset of the first frame
+    uint32_t first_frame;
+    uint32_t count;
+    float min[SUMMARY_SERIES];
+    float max[SUMMARY_SERIES];
+    float mean[SUMMARY_SERIES];  // NAN when no frame had a value
+} SummaryBucket;
+
+typedef struct {
+    SummaryBucket bucket;
+    double sum[SUMMARY_SERIES];
+    uint32_t valid[SUMMARY_SERIES];
+    uint32_t children;
+} SummaryAccum;
+
+typedef struct {
+    FILE* file;
+    SummaryAccum levels[SUMMARY_MAX_LEVELS];
+    uint32_t frames;
+    FrameSamples first[2];
+    bool has_first[2];
+} SummaryWriter;
+
+typedef struct {
+    SummaryBucket* levels[SUMMARY_MAX_LEVELS];
+    uint32_t counts[SUMMARY_MAX_LEVELS];
+    int level_count;
+    uint32_t frames;
+} Summary;
+
+extern const char* SUMMARY_KEY_NAMES[SUMMARY_KEYS];
+
+bool SummaryWriterOpen(SummaryWriter* writer, const char* path);
+bool SummaryWriterAdd(SummaryWriter* writer, uint64_t offset, const FrameSamples* samples, int excitation);
+void SummaryWriterClose(SummaryWriter* writer);
+
+bool SummaryLoad(Summary* summary, const char* path);
+void SummaryFree(Summary* summary);
+
+// Scan a whole capture and write its summary, for files recorded without one
+bool SummaryBuild(const char* capture_path, const char* summary_path);
+
+// Capture offset of the level 0 bucket holding frame, and how many records to skip from there
+bool SummaryLocate(const Summary* summary, uint32_t frame, uint64_t* offset, uint32_t* skip);
+
+// Combined min/max/mean of one series over frames [first, last), read from the
+// coarsest level whose buckets still fit in the range. False if nothing valid.
+bool SummaryQuery(const Summary* summary, uint32_t first, uint32_t last, int series,
+                  float* min, float* max, float* mean);
+                  
+#endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Minimal atomics and threads shared by the shared memory ring, the control
+// server and the frame pipeline. MSVC's C mode has no usable <stdatomic.h> or
+// <threads.h>, so every compiler goes through here.
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    
+    static inline uint32_t AtomicLoad32(const volatile uint32_t* p) {
+        uint32_t v = *p;
+        _ReadWriteBarrier();
+        return v;
+    }
+    static inline void AtomicStore32(volatile uint32_t* p, uint32_t v) {
+        _ReadWriteBarrier();
+        *p = v;
+    }
+    static inline uint64_t AtomicLoad64(const volatile uint64_t* p) {
+        return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)p, 0, 0);
+    }
+    static inline void AtomicStore64(volatile uint64_t* p, uint64_t v) {
+        InterlockedExchange64((volatile LONG64*)p, (LONG64)v);
+    }
+    static inline uint64_t AtomicFetchAdd64(volatile uint64_t* p, uint64_t v) {
+        return (uint64_t)InterlockedExchangeAdd64((volatile LONG64*)p, (LONG64)v);
+    }
+    static inline bool AtomicCompareExchange64(volatile uint64_t* p, uint64_t* expected, uint64_t desired) {
+        uint64_t prev = (uint64_t)InterlockedCompareExchange64((volatile LONG64*)p, (LONG64)desired, (LONG64)*expected);
+        if (prev == *expected) return true;
+        *expected = prev;
+        return false;
+    }
+    static inline void AtomicFenceAcquire(void) { MemoryBarrier(); }
+    static inline void AtomicFenceRelease(void) { MemoryBarrier(); }
+    static inline void AtomicFenceFull(void) { MemoryBarrier(); }
+#else
+    static inline uint32_t AtomicLoad32(const volatile uint32_t* p) {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+    static inline void AtomicStore32(volatile uint32_t* p, uint32_t v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+    static inline uint64_t AtomicLoad64(const volatile uint64_t* p) {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+    static inline void AtomicStore64(volatile uint64_t* p, uint64_t v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+    static inline uint64_t AtomicFetchAdd64(volatile uint64_t* p, uint64_t v) {
+        return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+    }
+    static inline bool AtomicCompareExchange64(volatile uint64_t* p, uint64_t* expected, uint64_t desired) {
+        return __atomic_compare_exchange_n(p, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+    static inline void AtomicFenceAcquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+    static inline void AtomicFenceRelease(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+    static inline void AtomicFenceFull(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#endif
+
+typedef struct {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    void (*fn)(void*);
+    void* arg;
+} Thread;
+
+typedef struct {
+#ifdef _WIN32
+    CRITICAL_SECTION cs;
+#else
+    pthread_mutex_t m;
+#endif
+} Mutex;
+
+typedef struct {
+#ifdef _WIN32
+    CONDITION_VARIABLE cv;
+#else
+    pthread_cond_t cv;
+#endif
+} Cond;
+
+#ifdef _WIN32
+    static inline DWORD WINAPI ThreadTrampoline(LPVOID p) {
+        Thread* t = (Thread*)p;
+        t->fn(t->arg);
+        return 0;
+    }
+    // The Thread must stay in place until ThreadJoin returns
+    static inline bool ThreadCreate(Thread* t, void (*fn)(void*), void* arg) {
+        t->fn = fn;
+        t->arg = arg;
+        t->handle = CreateThread(NULL, 0, ThreadTrampoline, t, 0, NULL);
+        return t->handle != NULL;
+    }
+    static inline void ThreadJoin(Thread* t) {
+        WaitForSingleObject(t->handle, INFINITE);
+        CloseHandle(t->handle);
+    }
+    static inline void MutexInit(Mutex* m) { InitializeCriticalSection(&m->cs); }
+    static inline void MutexLock(Mutex* m) { EnterCriticalSection(&m->cs); }
+    static inline void MutexUnlock(Mutex* m) { LeaveCriticalSection(&m->cs); }
+    static inline void MutexDestroy(Mutex* m) { DeleteCriticalSection(&m->cs); }
+    static inline void CondInit(Cond* c) { InitializeConditionVariable(&c->cv); }
+    static inline void CondWait(Cond* c, Mutex* m) { SleepConditionVariableCS(&c->cv, &m->cs, INFINITE); }
+    // Also returns early on a signal or spuriously; callers recheck their condition
+    static inline void CondWaitMs(Cond* c, Mutex* m, int ms) { SleepConditionVariableCS(&c->cv, &m->cs, (DWORD)ms); }
+    static inline void CondSignal(Cond* c) { WakeConditionVariable(&c->cv); }
+    static inline void CondBroadcast(Cond* c) { WakeAllConditionVariable(&c->cv); }
+    static inline void CondDestroy(Cond* c) { (void)c; }
+    static inline int ThreadCpuCount(void) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (int)info.dwNumberOfProcessors;
+    }
+#else
+    static inline void* ThreadTrampoline(void* p) {
+        Thread* t = (Thread*)p;
+        t->fn(t->arg);
+        return NULL;
+    }
+    // The Thread must stay in place until ThreadJoin returns
+    static inline bool ThreadCreate(Thread* t, void (*fn)(void*), void* arg) {
+        t->fn = fn;
+        t->arg = arg;
+        return pthread_create(&t->handle, NULL, ThreadTrampoline, t) == 0;
+    }
+    static inline void ThreadJoin(Thread* t) { pthread_join(t->handle, NULL); }
+    static inline void MutexInit(Mutex* m) { pthread_mutex_init(&m->m, NULL); }
+    static inline void MutexLock(Mutex* m) { pthread_mutex_lock(&m->m); }
+    static inline void MutexUnlock(Mutex* m) { pthread_mutex_unlock(&m->m); }
+    static inline void MutexDestroy(Mutex* m) { pthread_mutex_destroy(&m->m); }
+    static inline void CondInit(Cond* c) { pthread_cond_init(&c->cv, NULL); }
+    static inline void CondWait(Cond* c, Mutex* m) { pthread_cond_wait(&c->cv, &m->m); }
+    static inline void CondWaitMs(Cond* c, Mutex* m, int ms) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += ms / 1000;
+        until.tv_nsec += (long)(ms % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&c->cv, &m->m, &until);
+    }
+    static inline void CondSignal(Cond* c) { pthread_cond_signal(&c->cv); }
+    static inline void CondBroadcast(Cond* c) { pthread_cond_broadcast(&c->cv); }
+    static inline void CondDestroy(Cond* c) { pthread_cond_destroy(&c->cv); }
+    static inline int ThreadCpuCount(void) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+    }
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "textexport.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const char* METRIC_NAMES[] = {
+    "r_small", "v_knee", "i_leak", "v_zero", "i_zero", "noise", "loop_area", "clipped"
+};
+#define METRIC_COUNT 8
+
+static int FormatUnsigned(char* out, uint64_t v) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (int i = 0; i < n; i++) out[i] = digits[n - 1 - i];
+    return n;
+}
+
+static int FormatInt(char* out, int64_t v) {
+    if (v < 0) {
+        out[0] = '-';
+        return 1 + FormatUnsigned(out + 1, (uint64_t)-v);
+    }
+    return FormatUnsigned(out, (uint64_t)v);
+}
+
+// m * 10^k rounded once in double is exact for m < 2^53 and |k| <= 22, so the
+// candidate is the same float strtof would give unless the decimal sits within
+// 2^-53 of a float midpoint; ties exactly on one round to even in both.
+static bool DecimalIsFloat(uint64_t m, int k, float v) {
+    double d = k >= 0 ? (double)m * POW10[k] : (double)m / POW10[-k];
+    return (float)d == v;
+}
+
+static int FormatDigits(char* out, uint64_t m, int digits, int point) {
+    char d[10];
+    FormatUnsigned(d, m);
+    int n = 0;
+    
+    // point is where the decimal point goes relative to the first digit
+    if (point > 0 && point <= 9) {
+        for (int i = 0; i < digits || i < point; i++) {
+            if (i == point) out[n++] = '.';
+            out[n++] = i < digits ? d[i] : '0';
+        }
+    } else if (point <= 0 && point > -5) {
+        out[n++] = '0';
+        out[n++] = '.';
+        for (int i = point; i < 0; i++) out[n++] = '0';
+        memcpy(out + n, d, digits);
+        n += digits;
+    } else {
+        out[n++] = d[0];
+        if (digits > 1) {
+            out[n++] = '.';
+            memcpy(out + n, d + 1, digits - 1);
+            n += digits - 1;
+        }
+        out[n++] = 'e';
+        n += FormatInt(out + n, point - 1);
+    }
+    return n;
+}
+
+int TextExportFloat(char* out, float v) {
+    if (isnan(v)) {
+        memcpy(out, "nan", 3);
+        return 3;
+    }
+    if (isinf(v)) {
+        if (v < 0) {
+            memcpy(out, "-inf", 4);
+            return 4;
+        }
+        memcpy(out, "inf", 3);
+        return 3;
+    }
+    
+    int n = 0;
+    if (signbit(v)) {
+        out[n++] = '-';
+        v = -v;
+    }
+    
+    // ADC counts and most raw-unit metrics land here
+    if (v < 16777216.0f && v == (float)(int32_t)v) {
+        return n + FormatUnsigned(out + n, (uint64_t)(int32_t)v);
+    }
+    
+    // Fewest digits first: round to p significant digits and keep the first
+    // that reads back as v. Nine always do for a float.
+    int e10 = (int)floor(log10((double)v));
+    for (int p = 1; p <= 9; p++) {
+        int k = e10 - (p - 1);
+        if (k > 22 || k < -22) break;
+        
+        double scaled = k >= 0 ? (double)v / POW10[k] : (double)v * POW10[-k];
+        uint64_t m = (uint64_t)llround(scaled);
+        int digits = p;
+        int point = e10 + 1;
+        
+        // log10 is off by one near powers of ten, and rounding can carry into a new digit
+        if (m >= (uint64_t)POW10[p]) {
+            m /= 10;
+            k++;
+            point++;
+        } else if (m < (uint64_t)POW10[p - 1]) {
+            continue;
+        }
+        if (!DecimalIsFloat(m, k, v)) continue;
+        
+        while (digits > 1 && m % 10 == 0) {
+            m /= 10;
+            digits--;
+        }
+        return n + FormatDigits(out + n, m, digits, point);
+    }
+    
+    // Denormals and the far ends of the range are not worth a table
+    char text[32];
+    for (int p = 1; p <= 9; p++) {
+        snprintf(text, sizeof(text), "%.*e", p - 1, v);
+        if (strtof(text, NULL) == v) break;
+    }
+    int length = (int)strlen(text);
+    memcpy(out + n, text, length);
+    return n + length;
+}
+
+bool TextExportParseFormat(const char* name, TextExportFormat* format) {
+    if (strcmp(name, "csv") == 0) *format = TEXT_EXPORT_CSV;
+    else if (strcmp(name, "jsonl") == 0) *format = TEXT_EXPORT_JSONL;
+    else return false;
+    return true;
+}
+
+const char* TextExportExtension(TextExportFormat format) {
+    return format == TEXT_EXPORT_JSONL ? "jsonl" : "csv";
+}
+
+static void Append(TextExporter* ex, const char* text, size_t length) {
+    memcpy(ex->buffer + ex->length, text, length);
+    ex->length += length;
+}
+
+static void AppendText(TextExporter* ex, const char* text) {
+    Append(ex, text, strlen(text));
+}
+
+// Neither format has a spelling for NaN that every reader accepts, so a
+// missing metric is an empty CSV field or a JSON null
+static void AppendMetric(TextExporter* ex, float v) {
+    if (!isfinite(v)) {
+        if (ex->params.format == TEXT_EXPORT_JSONL) AppendText(ex, "null");
+        return;
+    }
+    ex->length += TextExportFloat(ex->buffer + ex->length, v);
+}
+
+static void WriteCsvHeader(TextExporter* ex, int samples) {
+    AppendText(ex, "sequence,timestamp_us,excitation");
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < METRIC_COUNT; i++) {
+            char name[32];
+            int length = snprintf(name, sizeof(name), ",dut%d_%s", c + 1, METRIC_NAMES[i]);
+            Append(ex, name, length);
+        }
+    }
+    if (ex->params.samples) {
+        static const char* arrays[3] = {"drive", "ch1", "ch2"};
+        for (int a = 0; a < 3; a++) {
+            for (int i = 0; i < samples; i++) {
+                char name[32];
+                int length = snprintf(name, sizeof(name), ",%s_%d", arrays[a], i);
+                Append(ex, name, length);
+            }
+        }
+    }
+    Append(ex, "\n", 1);
+}
+
+static bool WriteBuffer(TextExporter* ex) {
+    if (ex->length == 0) return true;
+    if (!ex->file) return false;
+    
+    if (fwrite(ex->buffer, 1, ex->length, ex->file) != ex->length) {
+        ex->write_errors++;
+        fclose(ex->file);
+        ex->file = NULL;
+        ex->length = 0;
+        return false;
+    }
+    ex->file_bytes += ex->length;
+    ex->bytes += ex->length;
+    ex->length = 0;
+    return true;
+}
+
+static bool OpenNextFile(TextExporter* ex, uint64_t timestamp_us, int samples) {
+    snprintf(ex->path, sizeof(ex->path), "%s_%03d.%s", ex->base, ex->file_index,
+             TextExportExtension(ex->params.format));
+    ex->file = fopen(ex->path, "wb");
+    if (!ex->file) {
+        ex->write_errors++;
+        return false;
+    }
+    ex->file_index++;
+    ex->file_bytes = 0;
+    ex->file_start_us = timestamp_us;
+    ex->buffer_start_us = timestamp_us;
+    ex->header_samples = samples;
+    
+    // JSON Lines rows describe themselves
+    if (ex->params.format == TEXT_EXPORT_CSV) WriteCsvHeader(ex, samples);
+    return true;
+}
+
+bool TextExporterOpen(TextExporter* ex, const char* base, const TextExportParams* params) {
+    memset(ex, 0, sizeof(*ex));
+    ex->params = *params;
+    snprintf(ex->base, sizeof(ex->base), "%s", base);
+    
+    ex->buffer = malloc(TEXT_EXPORT_BUFFER);
+    if (!ex->buffer) return false;
+    
+    // The first file starts on the first frame so its time limit runs from there
+    ex->file_start_us = UINT64_MAX;
+    return true;
+}
+
+static void FormatCsvRow(TextExporter* ex, uint64_t sequence, uint64_t timestamp_us, int excitation,
+                         const RawFrame* frame, const MetricsResult metrics[2]) {
+    ex->length += FormatUnsigned(ex->buffer + ex->length, sequence);
+    Append(ex, ",", 1);
+    ex->length += FormatUnsigned(ex->buffer + ex->length, timestamp_us);
+    Append(ex, ",", 1);
+    ex->length += FormatInt(ex->buffer + ex->length, excitation);
+    
+    for (int c = 0; c < 2; c++) {
+        const MetricsResult* m = &metrics[c];
+        const float values[METRIC_COUNT - 1] = {
+            m->r_small, m->v_knee, m->i_leak, m->v_zero, m->i_zero, m->noise, m->loop_area
+        };
+        for (int i = 0; i < METRIC_COUNT - 1; i++) {
+            Append(ex, ",", 1);
+            AppendMetric(ex, values[i]);
+        }
+        Append(ex, ",", 1);
+        ex->length += FormatInt(ex->buffer + ex->length, m->clipped);
+    }
+    
+    if (ex->params.samples) {
+        char* p = ex->buffer + ex->length;
+        for (int a = 0; a < 3; a++) {
+            for (int i = 0; i < frame->samples; i++) {
+                *p++ = ',';
+                p += FormatUnsigned(p, frame->values[i * 3 + a]);
+            }
+        }
+        ex->length = (size_t)(p - ex->buffer);
+    }
+    Append(ex, "\n", 1);
+}
+
+static void FormatJsonRow(TextExporter* ex, uint64_t sequence, uint64_t timestamp_us, int excitation,
+                          const RawFrame* frame, const MetricsResult metrics[2]) {
+    AppendText(ex, "{\"sequence\":");
+    ex->length += FormatUnsigned(ex->buffer + ex->length, sequence);
+    AppendText(ex, ",\"timestamp_us\":");
+    ex->length += FormatUnsigned(ex->buffer + ex->length, timestamp_us);
+    AppendText(ex, ",\"excitation\":");
+    ex->length += FormatInt(ex->buffer + ex->length, excitation);
+    
+    for (int c = 0; c < 2; c++) {
+        const MetricsResult* m = &metrics[c];
+        const float values[METRIC_COUNT - 1] = {
+            m->r_small, m->v_knee, m->i_leak, m->v_zero, m->i_zero, m->noise, m->loop_area
+        };
+        AppendText(ex, c ? ",\"dut2\":{" : ",\"dut1\":{");
+        for (int i = 0; i < METRIC_COUNT - 1; i++) {
+            if (i) Append(ex, ",", 1);
+            Append(ex, "\"", 1);
+            AppendText(ex, METRIC_NAMES[i]);
+            Append(ex, "\":", 2);
+            AppendMetric(ex, values[i]);
+        }
+        AppendText(ex, ",\"clipped\":");
+        ex->length += FormatInt(ex->buffer + ex->length, m->clipped);
+        Append(ex, "}", 1);
+    }
+    
+    if (ex->params.samples) {
+        static const char* arrays[3] = {",\"drive\":[", ",\"ch1\":[", ",\"ch2\":["};
+        for (int a = 0; a < 3; a++) {
+            AppendText(ex, arrays[a]);
+            char* p = ex->buffer + ex->length;
+            for (int i = 0; i < frame->samples; i++) {
+                if (i) *p++ = ',';
+                p += FormatUnsigned(p, frame->values[i * 3 + a]);
+            }
+            *p++ = ']';
+            ex->length = (size_t)(p - ex->buffer);
+        }
+    }
+    Append(ex, "}\n", 2);
+}
+
+bool TextExporterAdd(TextExporter* ex, uint64_t sequence, uint64_t timestamp_us, int excitation,
+                     const RawFrame* frame, const MetricsResult metrics[2]) {
+    if (!ex->buffer) return false;
+    
+    // Rotation goes by what the file will hold once the buffer is written
+    bool rotate = ex->file &&
+        ((ex->params.rotate_bytes && ex->file_bytes + ex->length >= ex->params.rotate_bytes) ||
+         (ex->params.rotate_us && timestamp_us - ex->file_start_us >= ex->params.rotate_us) ||
+         (ex->params.samples && ex->params.format == TEXT_EXPORT_CSV && frame->samples != ex->header_samples));
+    if (rotate) {
+        bool ok = WriteBuffer(ex);
+        if (ex->file) fclose(ex->file);
+        ex->file = NULL;
+        if (!ok) return false;
+    }
+    if (!ex->file) {
+        if (ex->write_errors || !OpenNextFile(ex, timestamp_us, frame->samples)) return false;
+    }
+    
+    if (ex->length == 0) ex->buffer_start_us = timestamp_us;
+    if (ex->params.format == TEXT_EXPORT_JSONL) {
+        FormatJsonRow(ex, sequence, timestamp_us, excitation, frame, metrics);
+    } else {
+        FormatCsvRow(ex, sequence, timestamp_us, excitation, frame, metrics);
+    }
+    ex->rows++;
+    
+    // Slow frame rates would otherwise sit in the buffer for minutes
+    if (ex->length + TEXT_EXPORT_ROW_MAX > TEXT_EXPORT_BUFFER ||
+        timestamp_us - ex->buffer_start_us >= TEXT_EXPORT_FLUSH_US) {
+        return TextExporterFlush(ex);
+    }
+    return true;
+}
+
+bool TextExporterFlush(TextExporter* ex) {
+    if (!WriteBuffer(ex)) return false;
+    if (ex->file && fflush(ex->file) != 0) {
+        ex->write_errors++;
+        return false;
+    }
+    return true;
+}
+
+void TextExporterClose(TextExporter* ex) {
+    if (ex->file) {
+        TextExporterFlush(ex);
+        if (ex->file) fclose(ex->file);
+    }
+    ex->file = NULL;
+    free(ex->buffer);
+    ex->buffer = NULL;
+    ex->length = 0;
+}
\ No newline at end of file
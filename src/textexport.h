@@ -0,0 +1,69 @@
+#ifndef TEXTEXPORT_H
+#define TEXTEXPORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "metrics.h"
+
+// Frames and metrics as CSV or JSON Lines for tools that cannot read captures.
+// Rows are formatted into one large buffer with hand-rolled integer and
+// shortest round-trip float conversion, and the file only sees a write when
+// the buffer fills, so a frame costs microseconds rather than a few thousand
+// fprintf calls. Not thread-safe; the live export runs it on a pipeline sink.
+#define TEXT_EXPORT_BUFFER (256 * 1024)
+#define TEXT_EXPORT_ROW_MAX (32 * 1024)     // Worst case for one frame with samples
+#define TEXT_EXPORT_FLUSH_US 1000000        // Buffered frame time before a write anyway
+
+typedef enum {
+    TEXT_EXPORT_CSV,
+    TEXT_EXPORT_JSONL
+} TextExportFormat;
+
+typedef struct {
+    TextExportFormat format;
+    bool samples;               // Raw drive, ch1 and ch2 sweeps as well as the metrics
+    uint64_t rotate_bytes;      // Start the next file past this size, 0 = never
+    uint64_t rotate_us;         // or after this much frame time, 0 = never
+} TextExportParams;
+
+typedef struct {
+    TextExportParams params;
+    char base[200];             // Files are <base>_000.csv, <base>_001.csv, ...
+    char path[256];             // Current file
+    FILE* file;
+    int file_index;
+    uint64_t file_bytes;
+    uint64_t file_start_us;
+    int header_samples;         // Sweep length the CSV columns were named for
+    
+    char* buffer;
+    size_t length;
+    uint64_t buffer_start_us;
+    
+    uint64_t rows;
+    uint64_t bytes;
+    volatile uint32_t write_errors;
+} TextExporter;
+
+// Shortest decimal that reads back as the same float, e.g. 0.1f -> "0.1".
+// Integers below 2^24 are written without exponent. Returns the length;
+// out needs room for 16 characters. Non-finite values give "nan", "inf", "-inf".
+int TextExportFloat(char* out, float v);
+
+bool TextExportParseFormat(const char* name, TextExportFormat* format);
+const char* TextExportExtension(TextExportFormat format);
+
+bool TextExporterOpen(TextExporter* ex, const char* base, const TextExportParams* params);
+
+// Metrics are in whatever units the caller computed them in. With samples, a
+// frame of another sweep length than the CSV header starts the next file.
+// Returns false once the file can no longer be written.
+bool TextExporterAdd(TextExporter* ex, uint64_t sequence, uint64_t timestamp_us, int excitation,
+                     const RawFrame* frame, const MetricsResult metrics[2]);
+
+bool TextExporterFlush(TextExporter* ex);
+void TextExporterClose(TextExporter* ex);
+
+#endif
\ No newline at end of file
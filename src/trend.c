@@ -0,0 +1,139 @@
+#include "trend.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char* TREND_KEY_NAMES[TREND_KEYS] = {
+    "DUT1-DUT2 RMS", "DUT1 I@V", "DUT2 I@V"
+};
+
+static void TrendBucketClear(TrendBucket* b) {
+    for (int s = 0; s < TREND_SERIES; s++) {
+        b->min[s] = INFINITY;
+        b->max[s] = -INFINITY;
+    }
+}
+
+static void TrendBucketMerge(TrendBucket* into, const TrendBucket* b) {
+    for (int s = 0; s < TREND_SERIES; s++) {
+        if (b->min[s] < into->min[s]) into->min[s] = b->min[s];
+        if (b->max[s] > into->max[s]) into->max[s] = b->max[s];
+    }
+}
+
+// Moves the ring forward to index, clearing the buckets it passes over
+static void TrendLevelAdvance(TrendLevel* level, int64_t index) {
+    if (index <= level->newest) return;
+    
+    int64_t from = level->newest + 1;
+    if (index - from >= TREND_LEVEL_BUCKETS) from = index - TREND_LEVEL_BUCKETS + 1;
+    for (int64_t i = from; i <= index; i++) {
+        TrendBucketClear(&level->buckets[i % TREND_LEVEL_BUCKETS]);
+    }
+    level->newest = index;
+}
+
+// The new top level starts as the fold of the one below, which has not wrapped yet
+static void TrendGrow(Trend* trend) {
+    TrendLevel* level = &trend->levels[trend->level_count];
+    level->buckets = trend->pool + (size_t)trend->level_count * TREND_LEVEL_BUCKETS;
+    level->newest = -1;
+    
+    if (trend->level_count > 0) {
+        const TrendLevel* below = &trend->levels[trend->level_count - 1];
+        for (int64_t i = 0; i <= below->newest; i++) {
+            TrendLevelAdvance(level, i / 2);
+            TrendBucketMerge(&level->buckets[(i / 2) % TREND_LEVEL_BUCKETS], &below->buckets[i]);
+        }
+    }
+    trend->level_count++;
+}
+
+bool TrendInit(Trend* trend) {
+    memset(trend, 0, sizeof(*trend));
+    trend->pool = malloc(sizeof(TrendBucket) * TREND_LEVEL_BUCKETS * TREND_MAX_LEVELS);
+    return trend->pool != NULL;
+}
+
+void TrendFree(Trend* trend) {
+    free(trend->pool);
+    memset(trend, 0, sizeof(*trend));
+}
+
+void TrendClear(Trend* trend) {
+    TrendBucket* pool = trend->pool;
+    memset(trend, 0, sizeof(*trend));
+    trend->pool = pool;
+}
+
+bool TrendAdd(Trend* trend, double time, const float* values) {
+    if (!trend->pool) return false;
+    if (trend->samples == 0) trend->start = time;
+    double t = time - trend->start;
+    if (t < trend->last) t = trend->last;   // Clock steps back: keep buckets in order
+    
+    int64_t index = (int64_t)(t / TREND_BASE_SECONDS);
+    while (trend->level_count == 0 ||
+           (trend->level_count < TREND_MAX_LEVELS &&
+            (index >> (trend->level_count - 1)) >= TREND_LEVEL_BUCKETS)) {
+        TrendGrow(trend);
+    }
+    
+    for (int l = 0; l < trend->level_count; l++) {
+        TrendLevel* level = &trend->levels[l];
+        TrendLevelAdvance(level, index >> l);
+        TrendBucket* b = &level->buckets[(index >> l) % TREND_LEVEL_BUCKETS];
+        for (int s = 0; s < TREND_SERIES; s++) {
+            if (isnan(values[s])) continue;
+            if (values[s] < b->min[s]) b->min[s] = values[s];
+            if (values[s] > b->max[s]) b->max[s] = values[s];
+        }
+    }
+    
+    trend->last = t;
+    trend->samples++;
+    return true;
+}
+
+int TrendRead(const Trend* trend, int series, double t0, double t1, int columns, float* min, float* max) {
+    for (int c = 0; c < columns; c++) {
+        min[c] = NAN;
+        max[c] = NAN;
+    }
+    if (trend->level_count == 0 || columns <= 0 || t1 <= t0) return 0;
+    
+    // Finest level with at most two buckets per column that still holds t0
+    double span = t1 - t0;
+    int l = 0;
+    for (; l < trend->level_count - 1; l++) {
+        double width = TREND_BASE_SECONDS * (double)((int64_t)1 << l);
+        int64_t oldest = trend->levels[l].newest - TREND_LEVEL_BUCKETS + 1;
+        if (span / width <= 2.0 * columns && (double)oldest * width <= t0) break;
+    }
+    
+    const TrendLevel* level = &trend->levels[l];
+    double width = TREND_BASE_SECONDS * (double)((int64_t)1 << l);
+    int64_t oldest = level->newest - TREND_LEVEL_BUCKETS + 1;
+    if (oldest < 0) oldest = 0;
+    
+    // Buckets wider than a column are shared by the columns they cover
+    for (int c = 0; c < columns; c++) {
+        int64_t first = (int64_t)floor((t0 + span * c / columns) / width);
+        int64_t last = (int64_t)ceil((t0 + span * (c + 1) / columns) / width) - 1;
+        if (last < first) last = first;
+        if (first < oldest) first = oldest;
+        if (last > level->newest) last = level->newest;
+        
+        float lo = INFINITY, hi = -INFINITY;
+        for (int64_t i = first; i <= last; i++) {
+            const TrendBucket* b = &level->buckets[i % TREND_LEVEL_BUCKETS];
+            if (b->min[series] < lo) lo = b->min[series];
+            if (b->max[series] > hi) hi = b->max[series];
+        }
+        if (lo <= hi) {
+            min[c] = lo;
+            max[c] = hi;
+        }
+    }
+    return l;
+}
\ No newline at end of file
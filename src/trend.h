@@ -0,0 +1,64 @@
+#ifndef TREND_H
+#define TREND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Scalar metrics against time for soak runs. Every level is a ring of
+// TREND_LEVEL_BUCKETS min/max buckets; level 0 buckets span TREND_BASE_SECONDS
+// and each level above doubles that. A level only comes into use once the run
+// outgrows the one below, so levels grow with the log of the run length. Their
+// rings are carved from one block allocated up front (about 1.2 MB), so a long
+// run never allocates on the frame loop. Any time window can be read from a
+// level with about one bucket per pixel column, so drawing costs the same
+// after ten seconds or ten hours.
+#define TREND_BASE_SECONDS 0.25
+#define TREND_LEVEL_BUCKETS 1024
+#define TREND_MAX_LEVELS 24
+
+typedef enum {
+    TREND_DIFF_RMS,             // DUT1 - DUT2 over the whole sweep, ADC counts
+    TREND_I_DUT1,               // Current at the probe voltage, plot units
+    TREND_I_DUT2,
+    TREND_KEYS
+} TrendKey;
+
+// Series index is key * 2 + excitation
+#define TREND_SERIES (TREND_KEYS * 2)
+
+typedef struct {
+    float min[TREND_SERIES];    // INFINITY/-INFINITY while a series has no value
+    float max[TREND_SERIES];
+} TrendBucket;
+
+typedef struct {
+    TrendBucket* buckets;
+    int64_t newest;             // Absolute index of the newest bucket
+} TrendLevel;
+
+typedef struct {
+    TrendBucket* pool;          // TREND_MAX_LEVELS rings of TREND_LEVEL_BUCKETS
+    TrendLevel levels[TREND_MAX_LEVELS];
+    int level_count;
+    double start;               // Time of the first sample, seconds
+    double last;                // Newest sample, seconds after start
+    uint64_t samples;
+} Trend;
+
+extern const char* TREND_KEY_NAMES[TREND_KEYS];
+
+bool TrendInit(Trend* trend);
+void TrendFree(Trend* trend);
+
+// Starts over without giving back the pool
+void TrendClear(Trend* trend);
+
+// values holds TREND_SERIES entries, NAN where a series has no sample.
+// False only if TrendInit could not allocate the pool.
+bool TrendAdd(Trend* trend, double time, const float* values);
+
+// Min/max of one series in columns equal slices of [t0, t1), seconds after
+// start. Slices without samples are NAN. Returns the level read.
+int TrendRead(const Trend* trend, int series, double t0, double t1, int columns, float* min, float* max);
+
+#endif
\ No newline at end of file
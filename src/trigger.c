@@ -0,0 +1,190 @@
+#include "trigger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define TRIGGER_SSE2
+#endif
+
+bool TriggerInit(Trigger* trigger, const TriggerParams* params, const FrameGeometry* geometry) {
+    memset(trigger, 0, sizeof(*trigger));
+    trigger->params = *params;
+    
+    if (trigger->params.pre_frames < 0) trigger->params.pre_frames = 0;
+    if (trigger->params.pre_frames > TRIGGER_MAX_PRE) trigger->params.pre_frames = TRIGGER_MAX_PRE;
+    if (trigger->params.post_frames < 0) trigger->params.post_frames = 0;
+    
+    if (trigger->params.pre_frames == 0) return true;
+    trigger->pre_samples = geometry->samples;
+    trigger->pre_slot_size = RawFrameSlotBytes(offsetof(TriggerEntry, frame), geometry->samples);
+    trigger->pre = malloc(trigger->pre_slot_size * trigger->params.pre_frames);
+    if (!trigger->pre) {
+        trigger->params.pre_frames = 0;
+        return false;
+    }
+    return true;
+}
+
+void TriggerFree(Trigger* trigger) {
+    TriggerReset(trigger);
+    free(trigger->pre);
+    trigger->pre = NULL;
+    trigger->params.pre_frames = 0;
+}
+
+static TriggerEntry* TriggerPreSlot(const Trigger* trigger, int index) {
+    return (TriggerEntry*)(trigger->pre + (size_t)(index % trigger->params.pre_frames) * trigger->pre_slot_size);
+}
+
+void TriggerChannelDeviation(const uint16_t* a, const uint16_t* b, int count, int* max_dev, int64_t* sum) {
+    int worst = 0;
+    int64_t total = 0;
+    int i = 0;
+    
+#ifdef TRIGGER_SSE2
+    // Unsigned 16-bit samples: |a - b| and the max come from saturating
+    // subtractions, and the deviations widen to int32 for the sum. Even 16-bit
+    // deviations over FRAME_MAX_SAMPLES cannot overflow the lanes.
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero;
+    __m128i vsum = zero;
+    for (; i + 8 <= count; i += 8) {
+        __m128i va = _mm_load_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_load_si128((const __m128i*)(b + i));
+        __m128i d = _mm_or_si128(_mm_subs_epu16(va, vb), _mm_subs_epu16(vb, va));
+        vmax = _mm_add_epi16(_mm_subs_epu16(vmax, d), d);
+        vsum = _mm_add_epi32(vsum, _mm_add_epi32(_mm_unpacklo_epi16(d, zero), _mm_unpackhi_epi16(d, zero)));
+    }
+    __m128i shifted = _mm_srli_si128(vmax, 8);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    shifted = _mm_srli_si128(vmax, 4);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    shifted = _mm_srli_si128(vmax, 2);
+    vmax = _mm_add_epi16(_mm_subs_epu16(vmax, shifted), shifted);
+    worst = _mm_cvtsi128_si32(vmax) & 0xFFFF;
+    
+    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 8));
+    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
+    total = _mm_cvtsi128_si32(vsum);
+#endif
+    
+    for (; i < count; i++) {
+        int d = a[i] - b[i];
+        if (d < 0) d = -d;
+        if (d > worst) worst = d;
+        total += d;
+    }
+    
+    *max_dev = worst;
+    *sum = total;
+}
+
+void TriggerCompare(const FrameSamples* samples, const FrameSamples* baseline, const TriggerParams* params,
+                    TriggerResult* result) {
+    memset(result, 0, sizeof(*result));
+    if (samples->count != baseline->count || samples->bits != baseline->bits ||
+        samples->origin != baseline->origin) {
+        return;
+    }
+    
+    int count = samples->count;
+    int max1, max2;
+    int64_t sum1, sum2;
+    
+    TriggerChannelDeviation(samples->ch1, baseline->ch1, count, &max1, &sum1);
+    TriggerChannelDeviation(samples->ch2, baseline->ch2, count, &max2, &sum2);
+    
+    int64_t worst_sum = sum1 > sum2 ? sum1 : sum2;
+    result->max_dev = max1 > max2 ? max1 : max2;
+    result->mean_dev = count > 0 ? (float)worst_sum / count : 0;
+    float scale = FrameCountScale(samples->bits);
+    result->fired = result->max_dev > params->max_dev * scale || result->mean_dev > params->mean_dev * scale;
+}
+
+static void TriggerWrite(Trigger* trigger, const RawFrame* frame, const CaptureFrameInfo* info) {
+    CaptureFrameInfo rel = *info;
+    rel.timestamp_us = info->timestamp_us - trigger->event_start_us;
+    
+    if (!CaptureWriterAppend(&trigger->writer, frame, &rel)) {
+        trigger->write_errors++;
+        CaptureWriterClose(&trigger->writer);
+        trigger->post_remaining = 0;
+    }
+}
+
+static bool TriggerStartEvent(Trigger* trigger, const CaptureFrameInfo* info) {
+    char path[64];
+    time_t now = time(NULL);
+    size_t n = strftime(path, sizeof(path), "event_%Y%m%d_%H%M%S", localtime(&now));
+    snprintf(path + n, sizeof(path) - n, "_%03u.cbc", trigger->events % 1000);
+    
+    if (!CaptureWriterOpen(&trigger->writer, path, CODEC_DELTA)) {
+        trigger->write_errors++;
+        return false;
+    }
+    
+    // Oldest pre-trigger frame first, times relative to it
+    int start = trigger->pre_head - trigger->pre_count + trigger->params.pre_frames;
+    trigger->event_start_us = trigger->pre_count > 0 ? TriggerPreSlot(trigger, start)->info.timestamp_us
+                                                     : info->timestamp_us;
+    
+    for (int i = 0; i < trigger->pre_count; i++) {
+        const TriggerEntry* e = TriggerPreSlot(trigger, start + i);
+        TriggerWrite(trigger, &e->frame, &e->info);
+    }
+    trigger->pre_count = 0;
+    
+    snprintf(trigger->last_path, sizeof(trigger->last_path), "%s", path);
+    trigger->events++;
+    return true;
+}
+
+bool TriggerProcess(Trigger* trigger, const RawFrame* frame, const FrameSamples* samples,
+                    const CaptureFrameInfo* info) {
+    int e = info->excitation ? 1 : 0;
+    
+    TriggerResult result = {0};
+    if (trigger->has_baseline[e]) {
+        TriggerCompare(samples, &trigger->baseline[e], &trigger->params, &result);
+    }
+    trigger->last = result;
+    
+    if (result.fired) {
+        // A change during the post window extends the event instead of starting another
+        if (trigger->writer.file || TriggerStartEvent(trigger, info)) {
+            trigger->post_remaining = trigger->params.post_frames;
+        }
+    } else {
+        // Only quiet frames become the reference, so a fault cannot hide in the baseline
+        trigger->baseline[e] = *samples;
+        trigger->has_baseline[e] = true;
+    }
+    
+    if (trigger->writer.file) {
+        TriggerWrite(trigger, frame, info);
+        if (!result.fired) trigger->post_remaining--;
+        if (trigger->post_remaining <= 0) CaptureWriterClose(&trigger->writer);
+        return true;
+    }
+    
+    if (trigger->params.pre_frames > 0 && frame->samples <= trigger->pre_samples) {
+        TriggerEntry* slot = TriggerPreSlot(trigger, trigger->pre_head);
+        slot->info = *info;
+        memcpy(&slot->frame, frame, RawFrameBytes(frame->samples));
+        trigger->pre_head = (trigger->pre_head + 1) % trigger->params.pre_frames;
+        if (trigger->pre_count < trigger->params.pre_frames) trigger->pre_count++;
+    }
+    return false;
+}
+
+void TriggerReset(Trigger* trigger) {
+    CaptureWriterClose(&trigger->writer);
+    trigger->post_remaining = 0;
+    trigger->pre_count = 0;
+    trigger->has_baseline[0] = false;
+    trigger->has_baseline[1] = false;
+    memset(&trigger->last, 0, sizeof(trigger->last));
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+#include "capture.h"
+
+// Scope-style change trigger for long unattended runs. Each frame is compared
+// with the last stable frame of the same excitation; when either channel moves
+// further than the thresholds, the frames kept in the pre-trigger ring, the
+// triggering frame and the following post frames are written to an event file.
+#define TRIGGER_MAX_PRE 256
+
+typedef struct {
+    int max_dev;                // Largest single sample deviation, 12-bit counts
+    float mean_dev;             // Area between the curves per sample, 12-bit counts
+    int pre_frames;
+    int post_frames;
+} TriggerParams;
+
+typedef struct {
+    int max_dev;                // Worse of the two channels, in the frame's counts
+    float mean_dev;
+    bool fired;
+} TriggerResult;
+
+// The frame comes last: a ring slot holds only the samples of its geometry
+typedef struct {
+    CaptureFrameInfo info;      // timestamp_us is absolute until written
+    RawFrame frame;
+} TriggerEntry;
+
+typedef struct {
+    TriggerParams params;
+    
+    FrameSamples baseline[2];   // Per excitation
+    bool has_baseline[2];
+    
+    // pre_frames slots sized for the geometry at init, nothing is allocated while armed
+    uint8_t* pre;
+    size_t pre_slot_size;
+    int pre_samples;            // Larger frames are written if they fire but never kept
+    int pre_head;
+    int pre_count;
+    
+    CaptureWriter writer;
+    uint64_t event_start_us;
+    int post_remaining;
+    
+    // Read by the UI thread
+    volatile uint32_t events;
+    volatile uint32_t write_errors;     // Events that could not be saved or were cut short
+    TriggerResult last;
+    char last_path[256];
+} Trigger;
+
+// False if the pre-trigger ring could not be allocated
+bool TriggerInit(Trigger* trigger, const TriggerParams* params, const FrameGeometry* geometry);
+void TriggerFree(Trigger* trigger);
+
+// Largest absolute deviation and sum of absolute deviations of one channel
+void TriggerChannelDeviation(const uint16_t* a, const uint16_t* b, int count, int* max_dev, int64_t* sum);
+
+// Largest and mean absolute deviation of ch1 and ch2 from the baseline. A
+// frame of another geometry than the baseline is not compared and never fires.
+void TriggerCompare(const FrameSamples* samples, const FrameSamples* baseline, const TriggerParams* params,
+                    TriggerResult* result);
+
+// Feed one frame. Returns true while the frame belongs to an event being saved.
+bool TriggerProcess(Trigger* trigger, const RawFrame* frame, const FrameSamples* samples,
+                    const CaptureFrameInfo* info);
+
+// Finish any event in progress and forget the baselines and pre-trigger frames
+void TriggerReset(Trigger* trigger);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+// A stalled UI must cost neither acquisition nor the sinks. A capture is
+// replayed through the acquisition thread at its normal pace, once with the
+// UI draining its queue and once with the UI not reading at all. The frame
+// rate must not change, the recorder must get every frame both times, and
+// after the stall the UI must find the newest frames, not the oldest.
+
+#include "acquire.h"
+#include <stdio.h>
+#include <math.h>
+
+#define TEST_CAPTURE "test_acquire_stall.cbc"
+#define TEST_CAPTURE_FRAMES 8
+#define TEST_PHASE_MS 1500          // Twice the UI queue at the paced rate
+#define TEST_RATE_SLACK 2           // Frames either side of a phase boundary
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+// Stands in for the recorder: same policy and depth, and notes any gap
+typedef struct {
+    volatile uint64_t frames;
+    volatile uint64_t last_sequence;
+    volatile uint64_t gaps;
+} CountingSink;
+
+static void CountingSinkFn(void* ctx, const PipelineFrame* frame) {
+    CountingSink* sink = ctx;
+    if (frame->sequence != sink->last_sequence + 1) AtomicFetchAdd64(&sink->gaps, 1);
+    AtomicStore64(&sink->last_sequence, frame->sequence);
+    AtomicFetchAdd64(&sink->frames, 1);
+}
+
+static void WaitMs(int ms) {
+    Mutex lock;
+    Cond never;
+    MutexInit(&lock);
+    CondInit(&never);
+    
+    double end = SerialGetTimeMs() + ms;
+    MutexLock(&lock);
+    for (double now = SerialGetTimeMs(); now < end; now = SerialGetTimeMs()) {
+        CondWaitMs(&never, &lock, (int)(end - now) + 1);
+    }
+    MutexUnlock(&lock);
+    
+    CondDestroy(&never);
+    MutexDestroy(&lock);
+}
+
+// A resistor-like sweep the parser's checks accept
+static bool WriteCapture(const char* path) {
+    CaptureWriter writer = {0};
+    if (!CaptureWriterOpen(&writer, path, CODEC_DELTA)) return false;
+    
+    RawFrame frame;
+    frame.samples = FRAME_SAMPLES;
+    frame.bits = 12;
+    frame.origin = FRAME_ORIGIN;
+    bool ok = true;
+    for (int f = 0; f < TEST_CAPTURE_FRAMES && ok; f++) {
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            double phase = 2.0 * 3.14159265358979 * i / FRAME_SAMPLES;
+            int drive = FRAME_ORIGIN + (int)(1400 * sin(phase));
+            frame.values[3 * i] = (uint16_t)drive;
+            frame.values[3 * i + 1] = (uint16_t)(FRAME_ORIGIN + (drive - FRAME_ORIGIN) / 2);
+            frame.values[3 * i + 2] = (uint16_t)(FRAME_ORIGIN + (drive - FRAME_ORIGIN) / 2 + f);
+        }
+        CaptureFrameInfo info = {(uint64_t)f * 50000, (uint32_t)f, 0};
+        ok = CaptureWriterAppend(&writer, &frame, &info);
+    }
+    CaptureWriterClose(&writer);
+    return ok;
+}
+
+int main(void) {
+    if (!WriteCapture(TEST_CAPTURE)) {
+        printf("FAIL: could not write %s\n", TEST_CAPTURE);
+        return 1;
+    }
+    
+    static Replay replay;
+    static FrameParser parser;
+    SerialPort port = {0};
+    if (!ReplayOpen(&replay, TEST_CAPTURE, 0)) {
+        printf("FAIL: could not replay %s\n", TEST_CAPTURE);
+        remove(TEST_CAPTURE);
+        return 1;
+    }
+    FrameParserInit(&parser);
+    FrameParserSetGeometry(&parser, &replay.geometry);
+    
+    static Pipeline pipeline;
+    static CountingSink recorder;
+    PipelineInit(&pipeline, &replay.geometry);
+    CHECK(PipelineAddSink(&pipeline, "recorder", PIPELINE_DROP_NEWEST, 512, CountingSinkFn, &recorder),
+          "could not add the recorder sink");
+    
+    static Acquirer acq;
+    CHECK(AcquirerStart(&acq, &port, &parser, &replay, &pipeline, NULL, false, -1, 0),
+          "could not start the acquisition thread");
+    AcquirerSet(&acq, true, 0, false);
+    
+    // Draining: the UI takes everything as it comes
+    static AcquiredFrame acquired;
+    uint64_t taken = 0;
+    uint64_t start = AtomicLoad64(&recorder.frames);
+    double end = SerialGetTimeMs() + TEST_PHASE_MS;
+    while (SerialGetTimeMs() < end) {
+        while (AcquirerNext(&acq, &acquired)) taken++;
+        WaitMs(5);
+    }
+    uint64_t draining = AtomicLoad64(&recorder.frames) - start;
+    while (AcquirerNext(&acq, &acquired)) taken++;
+    uint64_t dropped_draining = AtomicLoad64(&acq.dropped);
+    
+    // Stalled: the UI reads nothing for as long again
+    start = AtomicLoad64(&recorder.frames);
+    WaitMs(TEST_PHASE_MS);
+    uint64_t stalled = AtomicLoad64(&recorder.frames) - start;
+    
+    // What the UI finds afterwards is a full queue ending on the last frame
+    AcquirerPause(&acq);
+    uint64_t first = 0, last = 0, queued = 0;
+    while (AcquirerNext(&acq, &acquired)) {
+        if (queued++ == 0) first = acquired.sequence;
+        last = acquired.sequence;
+    }
+    
+    AcquirerStop(&acq);
+    PipelineSinkStats recorder_stats;
+    PipelineGetStats(&pipeline, 0, &recorder_stats);
+    PipelineShutdown(&pipeline);
+    
+    printf("draining: %llu frames, ui took %llu, dropped %llu\n", (unsigned long long)draining,
+           (unsigned long long)taken, (unsigned long long)dropped_draining);
+    printf("stalled:  %llu frames, ui dropped %llu, queue %llu..%llu\n", (unsigned long long)stalled,
+           (unsigned long long)(acq.dropped - dropped_draining), (unsigned long long)first,
+           (unsigned long long)last);
+    
+    uint64_t paced = (uint64_t)(TEST_PHASE_MS / ACQUIRE_INTERVAL_MS);
+    CHECK(draining + TEST_RATE_SLACK >= paced, "only %llu frames while draining, expected about %llu",
+          (unsigned long long)draining, (unsigned long long)paced);
+    CHECK(stalled + TEST_RATE_SLACK >= draining && stalled <= draining + TEST_RATE_SLACK,
+          "%llu frames with the UI stalled against %llu draining", (unsigned long long)stalled,
+          (unsigned long long)draining);
+    CHECK(dropped_draining == 0, "a draining UI lost %llu frames", (unsigned long long)dropped_draining);
+    CHECK(acq.dropped > 0, "the stall never filled the UI queue");
+    
+    CHECK(recorder.frames == acq.sequence, "recorder got %llu of %llu frames", (unsigned long long)recorder.frames,
+          (unsigned long long)acq.sequence);
+    CHECK(recorder.gaps == 0, "recorder saw %llu gaps", (unsigned long long)recorder.gaps);
+    CHECK(recorder_stats.dropped == 0, "recorder queue dropped %llu frames", (unsigned long long)recorder_stats.dropped);
+    
+    CHECK(queued == ACQUIRE_QUEUE, "%llu frames queued after the stall, expected %d", (unsigned long long)queued,
+          ACQUIRE_QUEUE);
+    CHECK(last == acq.sequence && last - first + 1 == queued, "queue holds %llu..%llu, latest is %llu",
+          (unsigned long long)first, (unsigned long long)last, (unsigned long long)acq.sequence);
+    CHECK(taken + acq.dropped + queued == acq.sequence, "%llu taken, %llu dropped and %llu queued of %llu",
+          (unsigned long long)taken, (unsigned long long)acq.dropped, (unsigned long long)queued,
+          (unsigned long long)acq.sequence);
+    
+    ReplayClose(&replay);
+    remove(TEST_CAPTURE);
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("acquisition: a stalled UI cost no frames upstream\n");
+    return 0;
+}
@@ -0,0 +1,309 @@
+// Steady state without the heap, headless. A capture is replayed through the
+// parser on the acquisition thread as fast as it goes, and every frame fans
+// out to the same sinks the app runs: recorder with summary and metrics CSV,
+// text export, armed trigger, shared memory ring and control server with a
+// frame subscriber. This thread stands in for the UI and runs the per-frame
+// analysis. After each thread's warm-up, none of them may allocate.
+
+#include "acquire.h"
+#include "pipeline.h"
+#include "alloccheck.h"
+#include "summary.h"
+#include "textexport.h"
+#include "trigger.h"
+#include "shmring.h"
+#include "control.h"
+#include "diff.h"
+#include "classify.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define TEST_CAPTURE "test_alloc_steady.cbc"
+#define TEST_RECORDING "test_alloc_steady_rec.cbc"
+#define TEST_EXPORT "test_alloc_steady_export"
+#define TEST_SOCKET "test_alloc_steady.sock"
+#define TEST_SHM "/curvebug_alloc_steady"
+#define TEST_CAPTURE_FRAMES 50
+#define TEST_RUN_MS 2000
+#define TEST_UI_WARMUP 100          // Frames this thread takes before it counts
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef struct {
+    CaptureWriter capture;
+    SummaryWriter summary;
+    FILE* metrics_log;
+} TestRecorder;
+
+static void RecorderSinkFn(void* ctx, const PipelineFrame* frame) {
+    TestRecorder* rec = ctx;
+    CaptureFrameInfo info = {frame->timestamp_us, (uint32_t)frame->sequence, (uint8_t)frame->excitation};
+    uint64_t offset = rec->capture.bytes;
+    if (CaptureWriterAppend(&rec->capture, &frame->frame, &info)) {
+        FrameSamples samples;
+        FrameSplit(&frame->frame, &samples);
+        SummaryWriterAdd(&rec->summary, offset, &samples, frame->excitation);
+    }
+    for (int c = 0; c < 2; c++) {
+        MetricsWriteCsvRow(rec->metrics_log, (uint32_t)frame->sequence, frame->excitation, c, &frame->metrics[c]);
+    }
+}
+
+static void ExportSinkFn(void* ctx, const PipelineFrame* frame) {
+    TextExporterAdd(ctx, frame->sequence, frame->timestamp_us, frame->excitation, &frame->frame, frame->metrics);
+}
+
+static void TriggerSinkFn(void* ctx, const PipelineFrame* frame) {
+    FrameSamples samples;
+    FrameSplit(&frame->frame, &samples);
+    CaptureFrameInfo info = {frame->timestamp_us, (uint32_t)frame->sequence, (uint8_t)frame->excitation};
+    TriggerProcess(ctx, &frame->frame, &samples, &info);
+}
+
+static void ShmSinkFn(void* ctx, const PipelineFrame* frame) {
+    FrameSamples samples;
+    FrameSplit(&frame->frame, &samples);
+    ShmRingPublish(ctx, &samples, frame->excitation, frame->timestamp_us);
+}
+
+static void ControlSinkFn(void* ctx, const PipelineFrame* frame) {
+    ControlServerPublish(ctx, &frame->frame, frame->sequence, frame->timestamp_us, frame->excitation,
+                         frame->metrics);
+}
+
+// A resistor-like sweep with a little movement, never enough to fire the trigger
+static bool WriteCapture(const char* path) {
+    CaptureWriter writer = {0};
+    if (!CaptureWriterOpen(&writer, path, CODEC_DELTA)) return false;
+    
+    RawFrame frame;
+    frame.samples = FRAME_SAMPLES;
+    frame.bits = 12;
+    frame.origin = FRAME_ORIGIN;
+    bool ok = true;
+    for (int f = 0; f < TEST_CAPTURE_FRAMES && ok; f++) {
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            double phase = 2.0 * 3.14159265358979 * i / FRAME_SAMPLES;
+            int drive = FRAME_ORIGIN + (int)(1400 * sin(phase));
+            frame.values[3 * i] = (uint16_t)drive;
+            frame.values[3 * i + 1] = (uint16_t)(FRAME_ORIGIN + (drive - FRAME_ORIGIN) / 2 + f % 3);
+            frame.values[3 * i + 2] = (uint16_t)(FRAME_ORIGIN + (drive - FRAME_ORIGIN) / 3 - f % 2);
+        }
+        CaptureFrameInfo info = {(uint64_t)f * 50000, (uint32_t)f, (uint8_t)(f & 1)};
+        ok = CaptureWriterAppend(&writer, &frame, &info);
+    }
+    CaptureWriterClose(&writer);
+    return ok;
+}
+
+static int ConnectFrames(const char* path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Walks the frame stream by its headers, so frames are counted whole
+typedef struct {
+    uint8_t header[sizeof(ControlFrameHeader)];
+    size_t header_len;
+    uint32_t payload_left;
+    uint64_t frames;
+    bool broken;
+} StreamCounter;
+
+static void StreamRead(StreamCounter* counter, int fd) {
+    uint8_t buffer[16384];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < n;) {
+            if (counter->payload_left) {
+                uint32_t take = (uint32_t)(n - i) < counter->payload_left ? (uint32_t)(n - i) : counter->payload_left;
+                counter->payload_left -= take;
+                i += take;
+                continue;
+            }
+            counter->header[counter->header_len++] = buffer[i++];
+            if (counter->header_len < sizeof(counter->header)) continue;
+    
+            const uint8_t* h = counter->header;
+            uint32_t magic = (uint32_t)h[0] | (uint32_t)h[1] << 8 | (uint32_t)h[2] << 16 | (uint32_t)h[3] << 24;
+            if (magic != CONTROL_FRAME_MAGIC) counter->broken = true;
+            counter->payload_left = (uint32_t)h[4] | (uint32_t)h[5] << 8 | (uint32_t)h[6] << 16 | (uint32_t)h[7] << 24;
+            counter->header_len = 0;
+            counter->frames++;
+        }
+    }
+}
+
+static void ReportThread(const char* name, const AllocCounts* counts) {
+    printf("%-12s %llu allocations, %llu bytes\n", name, (unsigned long long)counts->allocs,
+           (unsigned long long)counts->bytes);
+    CHECK(counts->allocs == 0, "%s thread allocated after warm-up", name);
+}
+
+int main(void) {
+    if (!AllocCheckAvailable()) {
+        printf("allocation counting needs glibc, skipped\n");
+        return 77;
+    }
+    if (!WriteCapture(TEST_CAPTURE)) {
+        printf("FAIL: could not write %s\n", TEST_CAPTURE);
+        return 1;
+    }
+    
+    static Replay replay;
+    static FrameParser parser;
+    SerialPort port = {0};
+    if (!ReplayOpen(&replay, TEST_CAPTURE, 0)) {
+        printf("FAIL: could not replay %s\n", TEST_CAPTURE);
+        remove(TEST_CAPTURE);
+        return 1;
+    }
+    FrameParserInit(&parser);
+    FrameParserSetGeometry(&parser, &replay.geometry);
+    
+    // The sinks' outputs, opened before anything is counted as the app does
+    static TestRecorder recorder;
+    CHECK(CaptureWriterOpen(&recorder.capture, TEST_RECORDING, CODEC_DELTA), "could not create the recording");
+    CHECK(SummaryWriterOpen(&recorder.summary, TEST_RECORDING ".sum"), "could not create the summary");
+    recorder.metrics_log = fopen(TEST_RECORDING ".metrics.csv", "w");
+    CHECK(recorder.metrics_log != NULL, "could not create the metrics log");
+    if (recorder.metrics_log) MetricsWriteCsvHeader(recorder.metrics_log);
+    
+    static TextExporter exporter;
+    TextExportParams export_params = {TEXT_EXPORT_CSV, true, 0, 0};
+    CHECK(TextExporterOpen(&exporter, TEST_EXPORT, &export_params), "could not open the exporter");
+    
+    static Trigger trigger;
+    TriggerParams trigger_params = {2000, 500.0f, 16, 16};
+    CHECK(TriggerInit(&trigger, &trigger_params, &replay.geometry), "could not allocate the pre-trigger ring");
+    
+    static ShmRing ring;
+    CHECK(ShmRingCreate(&ring, TEST_SHM), "could not create %s", TEST_SHM);
+    
+    static ControlServer control;
+    CHECK(ControlServerStart(&control, TEST_SOCKET, &replay.geometry), "could not listen on %s", TEST_SOCKET);
+    int frames_fd = ConnectFrames(control.frames_path);
+    CHECK(frames_fd != -1, "could not subscribe to %s", control.frames_path);
+    
+    static Pipeline pipeline;
+    PipelineInit(&pipeline, &replay.geometry);
+    PipelineAddSink(&pipeline, "recorder", PIPELINE_DROP_NEWEST, 512, RecorderSinkFn, &recorder);
+    PipelineAddSink(&pipeline, "export", PIPELINE_DROP_NEWEST, 512, ExportSinkFn, &exporter);
+    PipelineAddSink(&pipeline, "trigger", PIPELINE_DROP_NEWEST, 64, TriggerSinkFn, &trigger);
+    PipelineAddSink(&pipeline, "shm", PIPELINE_DROP_OLDEST, 16, ShmSinkFn, &ring);
+    PipelineAddSink(&pipeline, "control", PIPELINE_DROP_OLDEST, 16, ControlSinkFn, &control);
+    CHECK(pipeline.sink_count == 5, "only %d of 5 sinks started", pipeline.sink_count);
+    
+    static Acquirer acq;
+    CHECK(AcquirerStart(&acq, &port, &parser, &replay, &pipeline, NULL, false, -1, 0),
+          "could not start the acquisition thread");
+    AcquirerSet(&acq, true, 2, true);
+    
+    // What the UI does with each frame, short of drawing it
+    static AcquiredFrame acquired;
+    static FrameSamples samples;
+    static DiffResult diff;
+    static float voltage[FRAME_MAX_SAMPLES], current[FRAME_MAX_SAMPLES];
+    MetricsResult metrics[2];
+    ClassifyResult classification;
+    DiffParams diff_params = {32, 40.0f, 200.0f};
+    StreamCounter stream = {0};
+    
+    uint64_t taken = 0;
+    AllocCounts ui_allocs = {0};
+    double end = SerialGetTimeMs() + TEST_RUN_MS;
+    while (SerialGetTimeMs() < end) {
+        if (frames_fd != -1) StreamRead(&stream, frames_fd);
+        if (!AcquirerNext(&acq, &acquired)) continue;
+        if (taken++ == TEST_UI_WARMUP) AllocCheckBegin();
+    
+        FrameSplit(&acquired.frame, &samples);
+        DiffCompute(&samples, &diff_params, &diff);
+        MetricsComputeFrame(&samples, NULL, acquired.weak, voltage, current, metrics);
+        ClassifyParams classify_params;
+        ClassifyParamsRaw(&classify_params, samples.bits, samples.origin);
+        for (int i = 0; i < samples.count; i++) {
+            voltage[i] = (float)samples.ch1[i];
+            current[i] = (float)(samples.drive[i] - samples.ch1[i]);
+        }
+        ClassifyCurve(voltage, current, samples.count, &classify_params, &classification);
+    }
+    if (taken > TEST_UI_WARMUP) AllocCheckEnd(&ui_allocs);
+    
+    AcquirerStop(&acq);
+    PipelineSinkStats stats[PIPELINE_MAX_SINKS];
+    int sink_count = pipeline.sink_count;
+    for (int i = 0; i < sink_count; i++) PipelineGetStats(&pipeline, i, &stats[i]);
+    PipelineShutdown(&pipeline);
+    if (frames_fd != -1) StreamRead(&stream, frames_fd);
+    ControlServerStop(&control);
+    
+    printf("%llu frames acquired, %llu taken here, %llu streamed to the subscriber\n",
+           (unsigned long long)acq.sequence, (unsigned long long)taken, (unsigned long long)stream.frames);
+    CHECK(taken > TEST_UI_WARMUP * 2, "only %llu frames reached this thread", (unsigned long long)taken);
+    CHECK(acq.alloc_attempts > ACQUIRE_ALLOC_WARMUP * 2, "only %llu acquisitions",
+          (unsigned long long)acq.alloc_attempts);
+    CHECK(stream.frames > CONTROL_ALLOC_WARMUP * 2 && !stream.broken, "subscriber got %llu frames%s",
+          (unsigned long long)stream.frames, stream.broken ? ", stream out of step" : "");
+    CHECK(trigger.events == 0, "trigger fired %u times; an event file is allowed to allocate", trigger.events);
+    
+    ReportThread("ui", &ui_allocs);
+    ReportThread("acquire", &acq.allocs);
+    for (int i = 0; i < sink_count; i++) {
+        CHECK(stats[i].delivered > PIPELINE_ALLOC_WARMUP * 2, "%s sink only took %llu frames",
+              pipeline.sinks[i].name, (unsigned long long)stats[i].delivered);
+        ReportThread(pipeline.sinks[i].name, &pipeline.sinks[i].allocs);
+    }
+    ReportThread("control loop", &control.allocs);
+    
+    if (frames_fd != -1) close(frames_fd);
+    TextExporterClose(&exporter);
+    char path[256];
+    for (int i = 0; i <= exporter.file_index; i++) {
+        snprintf(path, sizeof(path), "%s_%03d.csv", TEST_EXPORT, i);
+        remove(path);
+    }
+    TriggerFree(&trigger);
+    ShmRingClose(&ring);
+    CaptureWriterClose(&recorder.capture);
+    SummaryWriterClose(&recorder.summary);
+    if (recorder.metrics_log) fclose(recorder.metrics_log);
+    ReplayClose(&replay);
+    remove(TEST_RECORDING);
+    remove(TEST_RECORDING ".sum");
+    remove(TEST_RECORDING ".metrics.csv");
+    remove(TEST_CAPTURE);
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("steady state: no allocations on any thread after warm-up\n");
+    return 0;
+}
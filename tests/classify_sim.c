@@ -0,0 +1,103 @@
+// Simulated sweeps of the parts a probe meets, through the same raw view the
+// live plot uses: the drive is a sine around the origin, the excitation
+// resistor is one count per count, and the DUT decides how the drive divides.
+// Each curve must get its label with at least the given confidence.
+
+#include "classify.h"
+#include <stdio.h>
+#include <math.h>
+
+#define SIM_SAMPLES FRAME_SAMPLES
+#define SIM_AMPLITUDE 1400.0f       // Peak drive in counts, clear of the rails
+#define SIM_PI 3.14159265358979f
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef enum {
+    SIM_OPEN,
+    SIM_SHORT,
+    SIM_RESISTOR,
+    SIM_CAPACITOR,
+    SIM_DIODE,
+    SIM_ZENER
+} SimPart;
+
+static float SimDrive(int k) {
+    return SIM_AMPLITUDE * sinf(2.0f * SIM_PI * k / SIM_SAMPLES);
+}
+
+// Junction with a hard knee: blocks below it, then a small dynamic resistance
+static float SimClamp(float drive, float knee) {
+    const float dynamic = 0.02f;    // Relative to the excitation resistor
+    if (drive <= knee) return drive;
+    return knee + (drive - knee) * dynamic / (1.0f + dynamic);
+}
+
+// DUT voltage relative to the origin for one drive level
+static float SimVoltage(SimPart part, float drive, float previous) {
+    switch (part) {
+        case SIM_OPEN:      return drive;
+        case SIM_SHORT:     return 0.0f;
+        case SIM_RESISTOR:  return drive * 0.5f;                // Equal to the excitation resistor
+        case SIM_DIODE:     return SimClamp(drive, 250.0f);     // Forward on the positive side
+        case SIM_ZENER:     return drive >= 0 ? SimClamp(drive, 250.0f) : -SimClamp(-drive, 500.0f);
+        case SIM_CAPACITOR: return previous + (drive - previous) * (2.0f * SIM_PI / SIM_SAMPLES);   // RC at the sweep rate
+    }
+    return drive;
+}
+
+static void Simulate(SimPart part, float* voltage, float* current) {
+    // Two periods, so the capacitor has settled by the one kept
+    float v = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 0; k < SIM_SAMPLES; k++) {
+            float drive = SimDrive(k);
+            v = SimVoltage(part, drive, v);
+            voltage[k] = FRAME_ORIGIN + v;
+            current[k] = drive - v;
+        }
+    }
+}
+
+static void CheckPart(const char* name, SimPart part, ClassifyLabel expected, float min_confidence) {
+    float voltage[SIM_SAMPLES], current[SIM_SAMPLES];
+    Simulate(part, voltage, current);
+    
+    ClassifyParams params;
+    ClassifyParamsRaw(&params, 12, FRAME_ORIGIN);
+    ClassifyResult result;
+    ClassifyCurve(voltage, current, SIM_SAMPLES, &params, &result);
+    
+    printf("%-10s %-10s %.2f\n", name, CLASSIFY_LABEL_NAMES[result.label], result.confidence);
+    CHECK(result.label == expected, "%s classified as %s, expected %s", name,
+          CLASSIFY_LABEL_NAMES[result.label], CLASSIFY_LABEL_NAMES[expected]);
+    CHECK(result.confidence >= min_confidence, "%s confidence %.2f below %.2f", name,
+          result.confidence, min_confidence);
+}
+
+int main(void) {
+    CheckPart("open", SIM_OPEN, CLASS_OPEN, 0.9f);
+    CheckPart("short", SIM_SHORT, CLASS_SHORT, 0.9f);
+    CheckPart("resistor", SIM_RESISTOR, CLASS_RESISTOR, 0.9f);
+    CheckPart("capacitor", SIM_CAPACITOR, CLASS_CAPACITOR, 0.9f);
+    CheckPart("diode", SIM_DIODE, CLASS_DIODE, 0.9f);
+    // Clamps forward and at its breakdown, so it reads as a clamp both ways
+    CheckPart("zener", SIM_ZENER, CLASS_ESD, 0.8f);
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("classifier: all simulated parts recognised\n");
+    return 0;
+}
@@ -0,0 +1,344 @@
+// Round trip and format checks for the frame codec. Every frame must come
+// back exactly, in the default geometry and in denser, deeper and odd-sized
+// ones, the delta stream must match a plain bit-at-a-time writer of the
+// documented format, and damaged input must be refused.
+
+#include "codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define TEST_FRAMES 64
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint32_t rng = 1;
+
+static uint32_t NextRandom(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void SetGeometry(RawFrame* frame, int samples, int bits, int origin) {
+    frame->samples = samples;
+    frame->bits = bits;
+    frame->origin = origin;
+}
+
+static void FillRandom(RawFrame* frame) {
+    for (int i = 0; i < frame->samples * 3; i++) {
+        frame->values[i] = (uint16_t)(NextRandom() & FrameCodeMax(frame->bits));
+    }
+}
+
+// What the tracer sends: a sine drive and two DUT leads following it with noise
+static void FillSweep(RawFrame* frame, int noise) {
+    int full = FrameCodeMax(frame->bits);
+    float scale = FrameCountScale(frame->bits);
+    for (int i = 0; i < frame->samples; i++) {
+        double phase = 2.0 * 3.14159265358979 * i / frame->samples;
+        int drive = frame->origin + (int)(1800 * scale * sin(phase));
+        int ch1 = frame->origin + (int)(900 * scale * sin(phase)) + (noise ? (int)(NextRandom() % (2 * noise + 1)) - noise : 0);
+        int ch2 = frame->origin + (int)(850 * scale * sin(phase + 0.1)) + (noise ? (int)(NextRandom() % (2 * noise + 1)) - noise : 0);
+        frame->values[3 * i] = (uint16_t)(drive < 0 ? 0 : drive > full ? full : drive);
+        frame->values[3 * i + 1] = (uint16_t)(ch1 < 0 ? 0 : ch1 > full ? full : ch1);
+        frame->values[3 * i + 2] = (uint16_t)(ch2 < 0 ? 0 : ch2 > full ? full : ch2);
+    }
+}
+
+static void FillConstant(RawFrame* frame, uint16_t value) {
+    for (int i = 0; i < frame->samples * 3; i++) {
+        frame->values[i] = value;
+    }
+}
+
+// Worst case for the delta coder: every step is a full-scale jump
+static void FillAlternating(RawFrame* frame) {
+    for (int i = 0; i < frame->samples * 3; i++) {
+        frame->values[i] = (uint16_t)((i / 3) & 1 ? FrameCodeMax(frame->bits) : 0);
+    }
+}
+
+static bool DefaultGeometry(const RawFrame* frame) {
+    return frame->samples == FRAME_SAMPLES && frame->bits == 12 && frame->origin == FRAME_ORIGIN;
+}
+
+// The delta format written the slow way: tag, the geometry unless it is the
+// default, one width nibble per block of 16 codes (low nibble first, 15 for
+// 16 bits), then each block's zigzag codes at that width as one little
+// endian bit stream, least significant bit first. The last block is padded
+// with zero codes.
+static size_t ReferenceEncodeDelta(const RawFrame* frame, uint8_t* out) {
+    int count = frame->samples * 3;
+    int blocks = (count + CODEC_BLOCK - 1) / CODEC_BLOCK;
+    
+    uint16_t codes[CODEC_MAX_BLOCKS * CODEC_BLOCK] = {0};
+    for (int i = 0; i < count; i++) {
+        int prev = i < 3 ? frame->origin : frame->values[i - 3];
+        int d = (int16_t)(uint16_t)(frame->values[i] - prev);
+        codes[i] = (uint16_t)(d < 0 ? -2 * d - 1 : 2 * d);
+    }
+    
+    memset(out, 0, CODEC_MAX_BYTES);
+    size_t widths = 1;
+    out[0] = CODEC_DELTA;
+    if (!DefaultGeometry(frame)) {
+        out[0] |= CODEC_GEOMETRY;
+        out[1] = (uint8_t)frame->samples;
+        out[2] = (uint8_t)(frame->samples >> 8);
+        out[3] = (uint8_t)frame->bits;
+        out[4] = (uint8_t)frame->origin;
+        out[5] = (uint8_t)(frame->origin >> 8);
+        widths += CODEC_GEOMETRY_BYTES;
+    }
+    size_t header = widths + (blocks + 1) / 2;
+    
+    size_t bit = 0;
+    for (int b = 0; b < blocks; b++) {
+        int width = 0;
+        for (int i = 0; i < CODEC_BLOCK; i++) {
+            while ((codes[b * CODEC_BLOCK + i] >> width) != 0) width++;
+        }
+        if (width == 15) width = 16;
+        out[widths + b / 2] |= (uint8_t)((width == 16 ? 15 : width) << ((b & 1) * 4));
+        
+        for (int i = 0; i < CODEC_BLOCK; i++) {
+            for (int k = 0; k < width; k++, bit++) {
+                if ((codes[b * CODEC_BLOCK + i] >> k) & 1) {
+                    out[header + bit / 8] |= (uint8_t)(1 << (bit % 8));
+                }
+            }
+        }
+    }
+    return header + (bit + 7) / 8;
+}
+
+static bool SameFrame(const RawFrame* a, const RawFrame* b) {
+    return a->samples == b->samples && a->bits == b->bits && a->origin == b->origin &&
+           memcmp(a->values, b->values, sizeof(uint16_t) * a->samples * 3) == 0;
+}
+
+static void CheckFrame(const char* name, const RawFrame* frame) {
+    uint8_t encoded[CODEC_MAX_BYTES];
+    uint8_t reference[CODEC_MAX_BYTES];
+    RawFrame decoded;
+    
+    for (int mode = CODEC_PACKED; mode <= CODEC_DELTA; mode++) {
+        size_t len = CodecEncode(frame, (CodecMode)mode, encoded, sizeof(encoded));
+        CHECK(len > 0 && len <= CODEC_MAX_BYTES, "%s mode %d: encoded length %zu", name, mode, len);
+        
+        memset(&decoded, 0xA5, sizeof(decoded));
+        CHECK(CodecDecode(encoded, len, &decoded), "%s mode %d: decode refused", name, mode);
+        CHECK(SameFrame(frame, &decoded), "%s mode %d: round trip differs", name, mode);
+        
+        // One byte short must be refused, never read past the end
+        uint8_t* shorter = malloc(len - 1);
+        memcpy(shorter, encoded, len - 1);
+        CHECK(!CodecDecode(shorter, len - 1, &decoded), "%s mode %d: truncated input accepted", name, mode);
+        free(shorter);
+        
+        if (mode == CODEC_DELTA) {
+            size_t ref_len = ReferenceEncodeDelta(frame, reference);
+            CHECK(ref_len == len && memcmp(reference, encoded, len) == 0,
+                  "%s: delta stream differs from the reference writer (%zu vs %zu bytes)", name, len, ref_len);
+        }
+    }
+}
+
+static void CheckInvalid(void) {
+    RawFrame frame, decoded;
+    uint8_t encoded[CODEC_MAX_BYTES];
+    SetGeometry(&frame, FRAME_SAMPLES, 12, FRAME_ORIGIN);
+    FillSweep(&frame, 4);
+    size_t len = CodecEncode(&frame, CODEC_DELTA, encoded, sizeof(encoded));
+    
+    uint8_t bad[CODEC_MAX_BYTES];
+    memcpy(bad, encoded, len);
+    bad[1] = (uint8_t)((bad[1] & 0xF0) | 14);
+    CHECK(!CodecDecode(bad, len, &decoded), "block width 14 accepted");
+    
+    memcpy(bad, encoded, len);
+    bad[0] = 7;
+    CHECK(!CodecDecode(bad, len, &decoded), "unknown mode tag accepted");
+    
+    CHECK(!CodecDecode(encoded, 0, &decoded), "empty input accepted");
+    CHECK(!CodecDecode(encoded, 1 + (CODEC_BLOCKS + 1) / 2 - 1, &decoded), "partial width table accepted");
+    CHECK(CodecEncode(&frame, CODEC_DELTA, encoded, CodecMaxBytes(FRAME_SAMPLES) - 1) == 0,
+          "short output buffer accepted");
+    CHECK(CodecMaxBytes(FRAME_MAX_SAMPLES) == CODEC_MAX_BYTES, "worst case %zu for the largest geometry, not %d",
+          CodecMaxBytes(FRAME_MAX_SAMPLES), (int)CODEC_MAX_BYTES);
+    
+    // Deltas that walk out of the 12-bit range are corrupt, not wrapped. Full
+    // scale steps put the first block at 13 bits; the first code is the drive's
+    // step from the origin, and one that lands on 4096 must be refused.
+    RawFrame jumps;
+    SetGeometry(&jumps, FRAME_SAMPLES, 12, FRAME_ORIGIN);
+    FillAlternating(&jumps);
+    len = CodecEncode(&jumps, CODEC_DELTA, encoded, sizeof(encoded));
+    memcpy(bad, encoded, len);
+    size_t header = 1 + (CODEC_BLOCKS + 1) / 2;
+    int width = bad[1] & 0x0F;
+    CHECK(width == 13, "full-scale steps packed at %d bits, expected 13", width);
+    if (width == 13) {
+        uint32_t word = (uint32_t)bad[header] | ((uint32_t)bad[header + 1] << 8);
+        word = (word & ~0x1FFFu) | (2 * (4096 - FRAME_ORIGIN));
+        bad[header] = (uint8_t)word;
+        bad[header + 1] = (uint8_t)(word >> 8);
+        CHECK(!CodecDecode(bad, len, &decoded), "out of range delta accepted");
+    }
+    
+    // The same limits hold for a frame that carries its geometry
+    SetGeometry(&frame, 672, 10, 512);
+    FillSweep(&frame, 2);
+    len = CodecEncode(&frame, CODEC_DELTA, encoded, sizeof(encoded));
+    header = 1 + CODEC_GEOMETRY_BYTES;
+    memcpy(bad, encoded, len);
+    bad[header] = (uint8_t)((bad[header] & 0xF0) | 12);
+    CHECK(!CodecDecode(bad, len, &decoded), "block width 12 accepted for 10-bit codes");
+    
+    memcpy(bad, encoded, len);
+    bad[3] = 17;
+    CHECK(!CodecDecode(bad, len, &decoded), "17-bit geometry accepted");
+    
+    memcpy(bad, encoded, len);
+    bad[1] = (uint8_t)(FRAME_MAX_SAMPLES + 1);
+    bad[2] = (uint8_t)((FRAME_MAX_SAMPLES + 1) >> 8);
+    CHECK(!CodecDecode(bad, len, &decoded), "more than FRAME_MAX_SAMPLES accepted");
+    
+    CHECK(!CodecDecode(encoded, 1 + CODEC_GEOMETRY_BYTES - 1, &decoded), "partial geometry accepted");
+    
+    SetGeometry(&frame, FRAME_SAMPLES, 12, 4096);
+    CHECK(CodecEncode(&frame, CODEC_DELTA, encoded, sizeof(encoded)) == 0, "origin outside the depth encoded");
+}
+
+// Denser, deeper and odd-sized sweeps, each round tripped like the default
+static void CheckGeometries(void) {
+    static const int GEOMETRIES[][3] = {
+        {672, 12, FRAME_ORIGIN},
+        {336, 16, 32768},
+        {672, 16, 32768},
+        {FRAME_MAX_SAMPLES, 16, 30000},
+        {335, 9, 256},              // 1005 codes, so the last block is partial
+        {2, 15, 16384},
+        {FRAME_SAMPLES, 12, 2000},  // Default shape, moved origin
+    };
+    RawFrame frame;
+    char name[64];
+    
+    for (size_t g = 0; g < sizeof(GEOMETRIES) / sizeof(GEOMETRIES[0]); g++) {
+        SetGeometry(&frame, GEOMETRIES[g][0], GEOMETRIES[g][1], GEOMETRIES[g][2]);
+        
+        for (int f = 0; f < 8; f++) {
+            FillRandom(&frame);
+            snprintf(name, sizeof(name), "%dx%d random %d", frame.samples, frame.bits, f);
+            CheckFrame(name, &frame);
+            
+            FillSweep(&frame, f * 3);
+            snprintf(name, sizeof(name), "%dx%d sweep noise %d", frame.samples, frame.bits, f * 3);
+            CheckFrame(name, &frame);
+        }
+        FillConstant(&frame, 0);
+        snprintf(name, sizeof(name), "%dx%d all zero", frame.samples, frame.bits);
+        CheckFrame(name, &frame);
+        FillConstant(&frame, (uint16_t)FrameCodeMax(frame.bits));
+        snprintf(name, sizeof(name), "%dx%d all full scale", frame.samples, frame.bits);
+        CheckFrame(name, &frame);
+        FillAlternating(&frame);
+        snprintf(name, sizeof(name), "%dx%d alternating", frame.samples, frame.bits);
+        CheckFrame(name, &frame);
+    }
+}
+
+static double Seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+// Informational only; machines differ too much for a pass mark
+static void ReportThroughput(void) {
+    static RawFrame frames[TEST_FRAMES];
+    static uint8_t encoded[TEST_FRAMES][CODEC_MAX_BYTES];
+    size_t lengths[TEST_FRAMES];
+    RawFrame decoded;
+    
+    for (int f = 0; f < TEST_FRAMES; f++) {
+        SetGeometry(&frames[f], FRAME_SAMPLES, 12, FRAME_ORIGIN);
+        FillSweep(&frames[f], 4);
+    }
+    
+    for (int mode = CODEC_PACKED; mode <= CODEC_DELTA; mode++) {
+        const int reps = 2000;
+        size_t total = 0;
+        
+        double start = Seconds();
+        for (int r = 0; r < reps; r++) {
+            for (int f = 0; f < TEST_FRAMES; f++) {
+                lengths[f] = CodecEncode(&frames[f], (CodecMode)mode, encoded[f], CODEC_MAX_BYTES);
+            }
+        }
+        double encode = Seconds() - start;
+        
+        start = Seconds();
+        for (int r = 0; r < reps; r++) {
+            for (int f = 0; f < TEST_FRAMES; f++) {
+                CodecDecode(encoded[f], lengths[f], &decoded);
+            }
+        }
+        double decode = Seconds() - start;
+        
+        for (int f = 0; f < TEST_FRAMES; f++) total += lengths[f];
+        double bytes = (double)reps * TEST_FRAMES * FRAME_BYTES;
+        printf("%s: %zu bytes/frame, encode %.2f GB/s, decode %.2f GB/s\n",
+               mode == CODEC_DELTA ? "delta" : "packed", total / TEST_FRAMES,
+               encode > 0 ? bytes / encode / 1e9 : 0.0, decode > 0 ? bytes / decode / 1e9 : 0.0);
+    }
+}
+
+int main(void) {
+    RawFrame frame;
+    char name[64];
+    SetGeometry(&frame, FRAME_SAMPLES, 12, FRAME_ORIGIN);
+    
+    for (int f = 0; f < TEST_FRAMES; f++) {
+        FillRandom(&frame);
+        snprintf(name, sizeof(name), "random %d", f);
+        CheckFrame(name, &frame);
+        
+        FillSweep(&frame, f % 9);
+        snprintf(name, sizeof(name), "sweep noise %d", f % 9);
+        CheckFrame(name, &frame);
+    }
+    
+    FillConstant(&frame, 0);
+    CheckFrame("all zero", &frame);
+    FillConstant(&frame, 4095);
+    CheckFrame("all full scale", &frame);
+    FillConstant(&frame, FRAME_ORIGIN);
+    CheckFrame("all origin", &frame);
+    FillAlternating(&frame);
+    CheckFrame("alternating 0/4095", &frame);
+    
+    CheckInvalid();
+    CheckGeometries();
+    ReportThroughput();
+    
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("codec round trip: all checks passed\n");
+    return 0;
+}
\ No newline at end of file
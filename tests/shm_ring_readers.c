@@ -0,0 +1,204 @@
+// One producer publishing at full rate to the shared memory ring while
+// forked readers consume it, half by copy and half zero-copy. Every frame a
+// reader accepts must carry exactly the content derived from its sequence
+// number, sequences must only go up, and frames read plus frames dropped must
+// account for everything published.
+
+#include "shmring.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define TEST_FRAMES 200000
+#define TEST_READERS 4              // Even ones copy, odd ones read in place
+#define TEST_TIMEOUT_S 30
+
+static uint16_t ExpectedValue(uint64_t sequence, int channel, int i) {
+    return (uint16_t)((sequence * 2654435761u + (uint64_t)channel * 40503u + (uint64_t)i * 7u) & 0x0FFF);
+}
+
+static void FillFrame(FrameSamples* samples, uint64_t sequence) {
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        samples->drive[i] = ExpectedValue(sequence, 0, i);
+        samples->ch1[i] = ExpectedValue(sequence, 1, i);
+        samples->ch2[i] = ExpectedValue(sequence, 2, i);
+    }
+    samples->count = FRAME_SAMPLES;
+    samples->bits = 12;
+    samples->origin = FRAME_ORIGIN;
+}
+
+// Checked against the sequence read first, so an overwrite in between shows
+static bool FrameIntact(const ShmFrame* frame, uint64_t sequence) {
+    if (frame->sequence != sequence) return false;
+    if (frame->timestamp_us != sequence || frame->excitation != (uint32_t)(sequence & 1)) return false;
+    if (frame->samples.count != FRAME_SAMPLES || frame->samples.bits != 12 ||
+        frame->samples.origin != FRAME_ORIGIN) {
+        return false;
+    }
+    
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        if (frame->samples.drive[i] != ExpectedValue(sequence, 0, i) ||
+            frame->samples.ch1[i] != ExpectedValue(sequence, 1, i) ||
+            frame->samples.ch2[i] != ExpectedValue(sequence, 2, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int RunReader(const char* name, int id, int ready_fd) {
+    bool zero_copy = id & 1;
+    ShmRing ring;
+    if (!ShmRingAttach(&ring, name)) {
+        printf("reader %d: attach failed\n", id);
+        return 1;
+    }
+    
+    char byte = 1;
+    if (write(ready_fd, &byte, 1) != 1) return 1;
+    close(ready_fd);
+    
+    uint64_t received = 0, corrupt = 0, torn = 0, last = 0;
+    time_t deadline = time(NULL) + TEST_TIMEOUT_S;
+    ShmFrame copy;
+    
+    while (last < TEST_FRAMES) {
+        const ShmFrame* frame = NULL;
+        uint32_t token = 0;
+        
+        if (zero_copy) {
+            frame = ShmRingPeek(&ring, &token);
+        } else if (ShmRingRead(&ring, &copy)) {
+            frame = &copy;
+        }
+        
+        if (!frame) {
+            // Everything published has been seen or dropped
+            if (ring.next >= TEST_FRAMES) break;
+            if (time(NULL) > deadline) {
+                printf("reader %d: timed out at frame %llu\n", id, (unsigned long long)ring.next);
+                ShmRingClose(&ring);
+                return 1;
+            }
+            continue;
+        }
+        
+        // In place the content may be torn; only a frame that survives release
+        // counts. Now and then a zero-copy reader stalls mid-frame so the
+        // writer laps it and release has to catch the overwrite.
+        uint64_t sequence = frame->sequence;
+        if (zero_copy && received % 64 == 63) usleep(500);
+        bool intact = FrameIntact(frame, sequence);
+        if (zero_copy && !ShmRingRelease(&ring, frame, token)) {
+            torn++;
+            continue;
+        }
+        
+        received++;
+        if (!intact) corrupt++;
+        if (sequence <= last) {
+            printf("reader %d: sequence %llu after %llu\n", id,
+                   (unsigned long long)sequence, (unsigned long long)last);
+            corrupt++;
+        }
+        last = sequence;
+    }
+    
+    uint64_t dropped = ring.dropped;
+    ShmRingClose(&ring);
+    
+    printf("reader %d (%s): %llu read, %llu dropped, %llu torn in place, %llu corrupt\n",
+           id, zero_copy ? "zero-copy" : "copy", (unsigned long long)received,
+           (unsigned long long)dropped, (unsigned long long)torn, (unsigned long long)corrupt);
+    
+    if (corrupt) return 1;
+    if (received == 0) {
+        printf("reader %d: no frames read\n", id);
+        return 1;
+    }
+    // Torn zero-copy frames are counted as dropped by the release
+    if (received + dropped != TEST_FRAMES) {
+        printf("reader %d: %llu read + %llu dropped != %d published\n", id,
+               (unsigned long long)received, (unsigned long long)dropped, TEST_FRAMES);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    char name[32];
+    snprintf(name, sizeof(name), "/cbtest_%d", (int)getpid());
+    
+    ShmRing ring;
+    if (!ShmRingCreate(&ring, name)) {
+        printf("could not create %s\n", name);
+        return 1;
+    }
+    
+    int ready[2];
+    if (pipe(ready) != 0) {
+        ShmRingClose(&ring);
+        return 1;
+    }
+    
+    pid_t readers[TEST_READERS];
+    for (int r = 0; r < TEST_READERS; r++) {
+        readers[r] = fork();
+        if (readers[r] == 0) {
+            close(ready[0]);
+            int status = RunReader(name, r, ready[1]);
+            fflush(stdout);
+            _exit(status);
+        }
+        if (readers[r] < 0) {
+            printf("fork failed\n");
+            return 1;
+        }
+    }
+    close(ready[1]);
+    
+    // Readers start from the head when they attach, so publish only once all are in
+    int attached = 0;
+    char byte;
+    while (attached < TEST_READERS && read(ready[0], &byte, 1) == 1) attached++;
+    close(ready[0]);
+    
+    int failures = 0;
+    if (attached == TEST_READERS) {
+        FrameSamples samples;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        
+        for (uint64_t sequence = 1; sequence <= TEST_FRAMES; sequence++) {
+            FillFrame(&samples, sequence);
+            ShmRingPublish(&ring, &samples, (uint32_t)(sequence & 1), sequence);
+        }
+        
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+        printf("producer: %d frames in %.3f s (%.0f frames/s)\n", TEST_FRAMES, seconds,
+               seconds > 0 ? TEST_FRAMES / seconds : 0.0);
+    } else {
+        printf("only %d of %d readers attached\n", attached, TEST_READERS);
+        failures++;
+    }
+    
+    for (int r = 0; r < TEST_READERS; r++) {
+        int status;
+        if (waitpid(readers[r], &status, 0) != readers[r] || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+    
+    ShmRingClose(&ring);
+    
+    if (failures) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("shm ring: all readers consistent\n");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+// Computes per-file metric statistics and the most deviant frames over a
+// batch of captures, using every core. Paths can also be listed one per line
+// in a file for batches too large for the command line.
+//
+// Usage: curvebug-analyze [--threads N] [--reference ref.cbc] [--outliers N]
+//                         [--out results.csv] [--list paths.txt] capture.cbc...
+
+#include "analyze.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double WallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int AddFile(Analyzer* analyzer, const char* path) {
+    if (AnalyzerAddFile(analyzer, path)) {
+        if (analyzer->files[analyzer->file_count - 1].damaged) {
+            fprintf(stderr, "%s: damaged record, analyzing the frames before it\n", path);
+        }
+        return 0;
+    }
+    fprintf(stderr, "Could not open %s\n", path);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    const char* reference = NULL;
+    const char* out_path = "analysis.csv";
+    int threads = 0;
+    int max_outliers = 100;
+    int failed = 0;
+    
+    static Analyzer analyzer;
+    bool usage = false;
+    
+    // Options first so --outliers is known before files are added
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reference") == 0 && i + 1 < argc) reference = argv[++i];
+        else if (strcmp(argv[i], "--outliers") == 0 && i + 1 < argc) max_outliers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) i++;
+        else if (argv[i][0] == '-' && argv[i][1] == '-') usage = true;
+    }
+    
+    AnalyzerInit(&analyzer, max_outliers);
+    
+    for (int i = 1; i < argc && !usage; i++) {
+        if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            FILE* list = fopen(argv[++i], "r");
+            if (!list) {
+                fprintf(stderr, "Could not open %s\n", argv[i]);
+                failed++;
+                continue;
+            }
+            char line[512];
+            while (fgets(line, sizeof(line), list)) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if (line[0]) failed += AddFile(&analyzer, line);
+            }
+            fclose(list);
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            i++;
+        } else {
+            failed += AddFile(&analyzer, argv[i]);
+        }
+    }
+    
+    if (usage || analyzer.file_count == 0) {
+        fprintf(stderr, "Usage: %s [--threads N] [--reference ref.cbc] [--outliers N] [--out results.csv] "
+                        "[--list paths.txt] capture.cbc...\n", argv[0]);
+        AnalyzerFree(&analyzer);
+        return 1;
+    }
+    
+    if (reference && !AnalyzerSetReference(&analyzer, reference)) {
+        fprintf(stderr, "Could not read reference %s\n", reference);
+        AnalyzerFree(&analyzer);
+        return 1;
+    }
+    
+    double start = WallSeconds();
+    if (!AnalyzerRun(&analyzer, threads)) {
+        fprintf(stderr, "Out of memory\n");
+        AnalyzerFree(&analyzer);
+        return 1;
+    }
+    double seconds = WallSeconds() - start;
+    
+    // Outliers go next to the table: results.csv -> results_outliers.csv
+    char outlier_path[512];
+    const char* dot = strrchr(out_path, '.');
+    int stem = dot ? (int)(dot - out_path) : (int)strlen(out_path);
+    snprintf(outlier_path, sizeof(outlier_path), "%.*s_outliers%s", stem, out_path, dot ? dot : ".csv");
+    
+    FILE* f = fopen(out_path, "w");
+    if (f) {
+        AnalyzerWriteTable(&analyzer, f);
+        fclose(f);
+    } else {
+        fprintf(stderr, "Could not write %s\n", out_path);
+        failed++;
+    }
+    
+    if (max_outliers > 0) {
+        f = fopen(outlier_path, "w");
+        if (f) {
+            AnalyzerWriteOutliers(&analyzer, f);
+            fclose(f);
+        } else {
+            fprintf(stderr, "Could not write %s\n", outlier_path);
+            failed++;
+        }
+    }
+    
+    printf("%llu frames from %d files in %.2f s with %d threads (%.0f frames/min, %llu steals)%s\n",
+           (unsigned long long)analyzer.frames, analyzer.file_count, seconds, analyzer.worker_count,
+           seconds > 0 ? analyzer.frames / seconds * 60.0 : 0.0, (unsigned long long)analyzer.steals,
+           analyzer.bad_frames ? ", some frames failed to decode" : "");
+    
+    AnalyzerFree(&analyzer);
+    return failed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Converts a capture to CSV or JSON Lines for tools that only read text, one
+// row per frame with both channels' metrics and optionally the raw sweeps.
+// Metrics are in ADC counts, the same raw view as curvebug-analyze.
+//
+// Usage: curvebug-convert [--format csv|jsonl] [--samples] [--rotate-mb N]
+//                         [--rotate-minutes N] capture.cbc [outbase]
+
+#include "textexport.h"
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double WallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    const char* capture_path = NULL;
+    const char* out_base = NULL;
+    const char* format = "csv";
+    TextExportParams params = {0};
+    bool usage = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) format = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0) params.samples = true;
+        else if (strcmp(argv[i], "--rotate-mb") == 0 && i + 1 < argc) {
+            params.rotate_bytes = (uint64_t)atoi(argv[++i]) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--rotate-minutes") == 0 && i + 1 < argc) {
+            params.rotate_us = (uint64_t)atoi(argv[++i]) * 60 * 1000000;
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') usage = true;
+        else if (!capture_path) capture_path = argv[i];
+        else out_base = argv[i];
+    }
+    
+    if (usage || !capture_path || !TextExportParseFormat(format, &params.format)) {
+        fprintf(stderr, "Usage: %s [--format csv|jsonl] [--samples] [--rotate-mb N] [--rotate-minutes N] "
+                        "capture.cbc [outbase]\n", argv[0]);
+        return 1;
+    }
+    
+    // capture.cbc -> capture_000.csv unless told otherwise
+    char base[200];
+    if (out_base) {
+        snprintf(base, sizeof(base), "%s", out_base);
+    } else {
+        const char* dot = strrchr(capture_path, '.');
+        int stem = dot ? (int)(dot - capture_path) : (int)strlen(capture_path);
+        snprintf(base, sizeof(base), "%.*s", stem, capture_path);
+    }
+    
+    CaptureReader reader;
+    if (!CaptureReaderOpen(&reader, capture_path)) {
+        fprintf(stderr, "Could not open %s\n", capture_path);
+        return 1;
+    }
+    
+    TextExporter exporter;
+    if (!TextExporterOpen(&exporter, base, &params)) {
+        fprintf(stderr, "Out of memory\n");
+        CaptureReaderClose(&reader);
+        return 1;
+    }
+    
+    RawFrame frame;
+    CaptureFrameInfo info;
+    FrameSamples samples;
+    float voltage[FRAME_MAX_SAMPLES], current[FRAME_MAX_SAMPLES];
+    bool ok = true;
+    int files = 0;
+    
+    double start = WallSeconds();
+    while (ok && CaptureReaderNext(&reader, &frame, &info)) {
+        FrameSplit(&frame, &samples);
+        int e = info.excitation ? 1 : 0;
+        const uint16_t* channels[2] = {samples.ch1, samples.ch2};
+        
+        MetricsParams metrics_params;
+        MetricsParamsRaw(&metrics_params, samples.bits, samples.origin, e == 1);
+        
+        MetricsResult metrics[2];
+        for (int c = 0; c < 2; c++) {
+            for (int i = 0; i < samples.count; i++) {
+                voltage[i] = (float)channels[c][i];
+                current[i] = (float)(samples.drive[i] - channels[c][i]);
+            }
+            MetricsCompute(voltage, current, samples.drive, channels[c], samples.count, &metrics_params, &metrics[c]);
+        }
+        
+        ok = TextExporterAdd(&exporter, info.sequence, info.timestamp_us, e, &frame, metrics);
+        files = exporter.file_index;
+    }
+    if (ok) ok = TextExporterFlush(&exporter);
+    double seconds = WallSeconds() - start;
+    
+    if (!ok) fprintf(stderr, "Could not write %s\n", exporter.path);
+    printf("%llu frames to %d %s file%s, %.1f MB in %.2f s (%.0f frames/s)\n",
+           (unsigned long long)exporter.rows, files, TextExportExtension(params.format), files == 1 ? "" : "s",
+           exporter.bytes / (1024.0 * 1024.0), seconds, seconds > 0 ? exporter.rows / seconds : 0.0);
+    
+    TextExporterClose(&exporter);
+    CaptureReaderClose(&reader);
+    return ok ? 0 : 1;
+}
\ No newline at end of file
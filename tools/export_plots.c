@@ -0,0 +1,109 @@
+// Batch renders the frames of a capture to PNG without a window or GPU, for
+// reports on headless machines. Colours come from curvebug.cfg if present.
+//
+// Usage: curvebug-export [--threads N] [--size WxH] [--every N] [--single]
+//                        [--calib SERIAL] capture.cbc outdir
+
+#include "export.h"
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double NowSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv) {
+    const char* capture_path = NULL;
+    const char* out_dir = NULL;
+    const char* calib_serial = NULL;
+    int threads = 0;
+    int every = 1;
+    
+    ExportStyle style = {0};
+    style.width = 900;
+    style.height = 700;
+    ConfigLoad(&style.config, "curvebug.cfg");
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &style.width, &style.height);
+        else if (strcmp(argv[i], "--calib") == 0 && i + 1 < argc) calib_serial = argv[++i];
+        else if (strcmp(argv[i], "--single") == 0) style.single_channel = true;
+        else if (!capture_path) capture_path = argv[i];
+        else out_dir = argv[i];
+    }
+    
+    if (!capture_path || !out_dir || every < 1 || style.width < 200 || style.height < 200) {
+        fprintf(stderr, "Usage: %s [--threads N] [--size WxH] [--every N] [--single] [--calib SERIAL] "
+                        "capture.cbc outdir\n", argv[0]);
+        return 1;
+    }
+    
+    static CalibrationTable calib;
+    if (calib_serial) {
+        CalibrationProfile profile;
+        if (!CalibrationLoadProfile("calibration.cfg", calib_serial, &profile)) {
+            fprintf(stderr, "No profile for %s in calibration.cfg\n", calib_serial);
+            return 1;
+        }
+        CalibrationBuild(&calib, &profile);
+        style.calib = &calib;
+    }
+    
+    CaptureReader reader;
+    if (!CaptureReaderOpen(&reader, capture_path)) {
+        fprintf(stderr, "Could not open %s\n", capture_path);
+        return 1;
+    }
+    
+    static ExportPool pool;
+    if (!ExportPoolStart(&pool, &style, threads)) {
+        fprintf(stderr, "Could not start export threads\n");
+        CaptureReaderClose(&reader);
+        return 1;
+    }
+    
+    const char* name = strrchr(capture_path, '/');
+    name = name ? name + 1 : capture_path;
+    const char* mode_names[] = {"4.7K", "100K WEAK"};
+    
+    // Keep the latest frame of each excitation so ALT captures plot like the live view
+    static ExportJob job;
+    RawFrame frame;
+    CaptureFrameInfo info;
+    uint32_t index = 0, submitted = 0;
+    double start = NowSeconds();
+    time_t wall_start = time(NULL);
+    
+    while (CaptureReaderNext(&reader, &frame, &info)) {
+        int e = info.excitation ? 1 : 0;
+        FrameSplit(&frame, &job.samples[e]);
+        job.has[e] = true;
+        job.excitation = e;
+        
+        if (index++ % every != 0) continue;
+        
+        snprintf(job.title, sizeof(job.title), "%s  frame %u  seq %u  %s  t=%.3fs",
+                 name, index - 1, info.sequence, mode_names[e], info.timestamp_us / 1e6);
+        snprintf(job.path, sizeof(job.path), "%s/%.*s_%06u.png", out_dir,
+                 (int)(strcspn(name, ".")), name, index - 1);
+        ExportPoolSubmit(&pool, &job);
+        submitted++;
+    }
+    
+    ExportPoolWait(&pool);
+    uint32_t written = pool.written, failed = pool.failed;
+    int used_threads = pool.thread_count;
+    ExportPoolStop(&pool);
+    CaptureReaderClose(&reader);
+    
+    double wall = difftime(time(NULL), wall_start);
+    printf("%u of %u frames written to %s with %d threads (%.1f s wall, %.1f s CPU)%s\n",
+           written, submitted, out_dir, used_threads, wall, NowSeconds() - start,
+           failed ? ", some writes failed" : "");
+    return failed ? 1 : 0;
+}
\ No newline at end of file